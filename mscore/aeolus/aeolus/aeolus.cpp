@@ -18,6 +18,7 @@
 
 #include "aeolus.h"
 #include "model.h"
+#include "divpool.h"
 
 extern QString dataPath;
 extern QString mscoreGlobalShare;
@@ -75,6 +76,7 @@ Aeolus::Aeolus()
       _fsamp = 0;
       _nasect = 0;
       _ndivis = 0;
+      _divisionPool = 0;
       nout = 0;
       _ifc_init = 0;
       for (int i = 0; i < NGROUP; i++)
@@ -84,6 +86,7 @@ Aeolus::Aeolus()
 
 Aeolus::~Aeolus()
       {
+      delete _divisionPool;
       delete model;
       for (int i = 0; i < _nasect; i++)
             delete _asectp [i];
@@ -92,6 +95,21 @@ Aeolus::~Aeolus()
       _reverb.fini ();
       }
 
+//---------------------------------------------------------
+//   setRenderThreads
+//    render the divisions on n threads; must not be
+//    called while process() runs
+//---------------------------------------------------------
+
+void Aeolus::setRenderThreads(int n)
+      {
+      n = qBound(1, n, NDIVIS);
+      if ((_divisionPool ? _divisionPool->threads() : 1) == n)
+            return;
+      delete _divisionPool;
+      _divisionPool = n > 1 ? new DivisionPool(n) : 0;
+      }
+
 //---------------------------------------------------------
 //   setMasterTuning
 //---------------------------------------------------------
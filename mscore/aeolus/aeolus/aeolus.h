@@ -37,6 +37,7 @@ class Model;
 class M_audio_info;
 class M_new_divis;
 class M_ifc_init;
+class DivisionPool;
 
 //---------------------------------------------------------
 //   Synth
@@ -60,6 +61,7 @@ class Aeolus : public Synth {
       Asection       *_asectp [NASECT];
 
       Division*       _divisp [NDIVIS];
+      DivisionPool*   _divisionPool;    // 0 if single threaded
       Reverb          _reverb;
       unsigned char   _keymap [NNOTES];
       SyntiParameter  _audiopar[4];
@@ -103,6 +105,7 @@ class Aeolus : public Synth {
       virtual QStringList soundFonts() const { return QStringList(); }
 
       virtual void process(unsigned, float*, float*, float);
+      virtual void setRenderThreads(int);
       virtual void play(const Event&);
 
       virtual const QList<MidiPatch*>& getPatchInfo() const;
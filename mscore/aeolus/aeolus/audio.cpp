@@ -19,6 +19,7 @@
 
 #include "messages.h"
 #include "aeolus.h"
+#include "divpool.h"
 
 //---------------------------------------------------------
 //   start
@@ -171,7 +172,6 @@ void Aeolus::process(unsigned nframes, float* lout, float* rout, float gain)
             _reverb.set_t60hi(_revtime * 0.50f, 3e3f);
             }
 
-      int k = nout;
       while (nframes > 0) {
             if (nout == 0) {
                   float W [PERIOD];
@@ -183,8 +183,14 @@ void Aeolus::process(unsigned nframes, float* lout, float* rout, float gain)
                   memset(Y, 0, PERIOD * sizeof (float));
                   memset(R, 0, PERIOD * sizeof (float));
 
+                  if (_divisionPool && _ndivis > 1)
+                        _divisionPool->render(_divisp, _ndivis);
+                  else {
+                        for (int j = 0; j < _ndivis; j++)
+                              _divisp[j]->render();
+                        }
                   for (int j = 0; j < _ndivis; j++)
-                        _divisp[j]->process();
+                        _divisp[j]->mix();
                   for (int j = 0; j < _nasect; j++)
                         _asectp[j]->process(gain, W, X, Y, R);
 
@@ -196,12 +202,18 @@ void Aeolus::process(unsigned nframes, float* lout, float* rout, float gain)
                         routb[j] = W[j] + stposit * X[j] - Y[j];
                         }
                   nout = PERIOD;
-                  k += PERIOD;
                   }
-            *lout++ += gain * loutb[PERIOD - nout];
-            *rout++ += gain * routb[PERIOD - nout];
-            --nout;
-            --nframes;
+            unsigned n = qMin(unsigned(nout), nframes);
+            const float* l = loutb + PERIOD - nout;
+            const float* r = routb + PERIOD - nout;
+            for (unsigned i = 0; i < n; i++) {
+                  lout[i] += gain * l[i];
+                  rout[i] += gain * r[i];
+                  }
+            lout    += n;
+            rout    += n;
+            nout    -= n;
+            nframes -= n;
             }
       }
 
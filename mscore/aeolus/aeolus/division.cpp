@@ -31,6 +31,7 @@ Division::Division (Asection *asect, float fsam)
     _fsam (fsam),
     _swel (1.0f),
     _gain (0.1f),
+    _gain1 (0.1f),
     _w (0.0f),
     _c (1.0f),
     _s (0.0f),
@@ -45,10 +46,12 @@ Division::~Division()
       }
 
 //---------------------------------------------------------
-//   process
+//   render
+//    play the ranks into the division buffer; divisions
+//    can be rendered in parallel
 //---------------------------------------------------------
 
-void Division::process()
+void Division::render()
       {
       memset (_buff, 0, NCHANN * PERIOD * sizeof (float));
       for (int i = 0; i < _nrank; i++)
@@ -75,22 +78,28 @@ void Division::process()
       t = 0.95f * _gain;
       if (g < t)
             g = t;
+      _gain1 = g;
+      }
 
-      float d  = (g - _gain) / PERIOD;
-      g        = _gain;
-      float* p = _buff;
+//---------------------------------------------------------
+//   mix
+//    add the division buffer to the audio section, ramping
+//    the gain over the period; divisions of the same
+//    section are mixed one after another
+//---------------------------------------------------------
+
+void Division::mix()
+      {
+      float d = (_gain1 - _gain) / PERIOD;
       float* q = _asect->get_wptr ();
 
-      for (int i = 0; i < PERIOD; i++) {
-            g += d;
-            q [0 * PERIOD * MIXLEN] += p [0 * PERIOD] * g;
-            q [1 * PERIOD * MIXLEN] += p [1 * PERIOD] * g;
-            q [2 * PERIOD * MIXLEN] += p [2 * PERIOD] * g;
-            q [3 * PERIOD * MIXLEN] += p [3 * PERIOD] * g;
-            p++;
-            q++;
+      for (int c = 0; c < NCHANN; c++) {
+            const float* p = _buff + c * PERIOD;
+            float* r       = q + c * PERIOD * MIXLEN;
+            for (int i = 0; i < PERIOD; i++)
+                  r [i] += p [i] * (_gain + (i + 1) * d);
             }
-      _gain = g;
+      _gain = _gain1;
       }
 
 void Division::set_rank (int ind, Rankwave *W, int pan, int del)
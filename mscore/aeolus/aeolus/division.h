@@ -37,6 +37,7 @@ class Division
       float      _fsam;
       float      _swel;
       float      _gain;
+      float      _gain1;      // gain at the end of the period
       float      _w;
       float      _c;
       float      _s;
@@ -58,7 +59,8 @@ class Division
       void trem_on()                { _trem = 1; }
       void trem_off()               { _trem = 2; }
 
-      void process();
+      void render();
+      void mix();
       void update(int note, int mask);
       void update(unsigned char *keys);
       };
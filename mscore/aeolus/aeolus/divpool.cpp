@@ -0,0 +1,64 @@
+//=============================================================================
+//  MusE Score
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2002-2010 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "division.h"
+#include "divpool.h"
+
+//---------------------------------------------------------
+//   DivisionPool
+//    threads is the total number of rendering threads
+//    including the calling thread
+//---------------------------------------------------------
+
+DivisionPool::DivisionPool(int threads)
+   : WorkerPool(threads)
+      {
+      divisions = 0;
+      ndivis    = 0;
+      }
+
+//---------------------------------------------------------
+//   job
+//    render divisions until the job is exhausted; the
+//    share index does not matter
+//---------------------------------------------------------
+
+void DivisionPool::job(int)
+      {
+      for (;;) {
+            int i = next.fetchAndAddRelaxed(1);
+            if (i >= ndivis)
+                  break;
+            divisions[i]->render();
+            }
+      }
+
+//---------------------------------------------------------
+//   render
+//    render n divisions; returns when all are done
+//---------------------------------------------------------
+
+void DivisionPool::render(Division** d, int n)
+      {
+      divisions = d;
+      ndivis    = n;
+      next.fetchAndStoreRelease(0);
+      run();
+      }
@@ -0,0 +1,50 @@
+//=============================================================================
+//  MusE Score
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2002-2010 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __DIVPOOL_H__
+#define __DIVPOOL_H__
+
+#include "msynth/workerpool.h"
+
+class Division;
+
+//---------------------------------------------------------
+//   DivisionPool
+//    Renders the ranks of all divisions of one period on
+//    worker threads and the calling thread. Every division
+//    plays into its own buffer, so the divisions are
+//    independent until they are mixed into the audio
+//    sections.
+//---------------------------------------------------------
+
+class DivisionPool : public WorkerPool {
+      // the current job:
+      Division** divisions;
+      int ndivis;
+      QAtomicInt next;
+
+      virtual void job(int idx);
+
+   public:
+      DivisionPool(int threads);
+      void render(Division** d, int n);
+      };
+
+#endif
@@ -458,8 +458,11 @@ void Model::proc_rank (int g, int i, int comm)
 //WS                  send_event(TO_IFACE, new M_ifc_ifelm (MT_IFC_ELATT, M->_group, M->_ifelm));
 
                   M->_wave = new Rankwave (M->_sdef->_n0, M->_sdef->_n1);
-                  if (M->_wave->load (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale))
+                  if (M->_wave->load (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale)) {
                         M->_wave->gen_waves (M->_sdef, M->_fsamp, M->_fbase, M->_scale);
+                        // next time the rank is mapped from the file
+                        M->_wave->save (M->_path, M->_sdef, M->_fsamp, M->_fbase, M->_scale);
+                        }
 
                   _aeolus->_divisp [M->_divis]->set_rank (M->_rank, M->_wave,  M->_sdef->_pan, M->_sdef->_del);
                   _divis [M->_divis]._ranks [M->_rank]._wave = M->_wave;
@@ -16,6 +16,10 @@
     Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <stddef.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "rankwave.h"
 
 #define DEBUG
@@ -40,7 +44,43 @@ void Pipewave::initstatic (float fsamp)
 }
 
 
-void Pipewave::play (void)
+// Add n samples of p to q, and n samples of p with a falling
+// gain g, g - dg, ... to q.
+
+static inline void addwave (float *q, const float *p, int n)
+{
+#ifdef __SSE2__
+    for (; n >= 4; n -= 4, p += 4, q += 4)
+    {
+        _mm_storeu_ps (q, _mm_add_ps (_mm_loadu_ps (q), _mm_loadu_ps (p)));
+    }
+#endif
+    while (n--) *q++ += *p++;
+}
+
+
+static inline float addramp (float *q, const float *p, int n, float g, float dg)
+{
+#ifdef __SSE2__
+    __m128 G  = _mm_set_ps (g - 3 * dg, g - 2 * dg, g - dg, g);
+    __m128 DG = _mm_set1_ps (4 * dg);
+    for (; n >= 4; n -= 4, p += 4, q += 4)
+    {
+        _mm_storeu_ps (q, _mm_add_ps (_mm_loadu_ps (q), _mm_mul_ps (G, _mm_loadu_ps (p))));
+        G = _mm_sub_ps (G, DG);
+    }
+    g = _mm_cvtss_f32 (G);
+#endif
+    while (n--)
+    {
+        *q++ += g * *p++;
+        g -= dg;
+    }
+    return g;
+}
+
+
+void Pipewave::play (Rngen *R)
 {
     int     i, d, k1, k2;
     float   g, dg, y, dy, t;
@@ -81,11 +121,8 @@ void Pipewave::play (void)
 
         if (r < _p1)
         {
-            while (k1--)
-            {
-	        *q++ += g * *r++;
-                g -= dg;
-            }
+            g = addramp (q, r, k1, g, dg);
+            r += k1;
         }
         else
 	{
@@ -135,15 +172,13 @@ void Pipewave::play (void)
         q = _out;
         if (p < _p1)
         {
-            while (k1--)
-            {
-		*q++ += *p++;
-	    }
+            addwave (q, p, k1);
+            p += k1;
         }
         else
 	{
             y = _y_p;
-            _z_p += _d_p * 0.0005f * (0.05f * _d_p * (_rgen.urandf () - 0.5f) - _z_p);
+            _z_p += _d_p * 0.0005f * (0.05f * _d_p * (R->urandf () - 0.5f) - _z_p);
             dy = _z_p * _k_s;
             while (k1)
 	    {
@@ -216,8 +251,9 @@ void Pipewave::genwave (Addsynth *D, int n, float fsamp, float fpipe)
 
     k = _l0 + _l1 + _k_s * (PERIOD + 4);
 
-    delete[] _p0;
+    if (! _mapped) delete[] _p0;
     _p0 = new float [k];
+    _mapped = false;
     _p1 = _p0 + _l0;
     _p2 = _p1 + _l1;
     memset (_p0, 0, k * sizeof (float));
@@ -350,8 +386,8 @@ void Pipewave::save (FILE *F)
     d.i16 [4] = _k_s;
     d.i16 [5] = _k_r;
     d.flt [3] = _m_r;
-    d.i32 [4] = 0;
-    d.i32 [5] = 0;
+    d.flt [4] = _d_r;
+    d.flt [5] = _d_p;
     d.i32 [6] = 0;
     d.i32 [7] = 0;
     fwrite (&d, 1, 32, F);
@@ -360,7 +396,11 @@ void Pipewave::save (FILE *F)
 }
 
 
-void Pipewave::load (FILE *F)
+// Read one pipe from a mapped wave file. The wave data
+// is used in place. Returns a pointer to the next pipe,
+// or 0 if the file is truncated.
+
+const char *Pipewave::load (const char *p, const char *e)
 {
     int  k;
     union
@@ -370,32 +410,40 @@ void Pipewave::load (FILE *F)
 	float   flt [8];
     } d;
 
-    fread (&d, 1, 32, F);
+    if (e - p < 32) return 0;
+    memcpy (&d, p, 32);
+    p += 32;
+    k = d.i32 [0] + d.i32 [1] + d.i16 [4] * (PERIOD + 4);
+    if ((k <= 0) || (e - p < (ptrdiff_t)(k * sizeof (float)))) return 0;
     _l0  = d.i32 [0];
     _l1  = d.i32 [1];
     _k_s = d.i16 [4];
     _k_r = d.i16 [5];
     _m_r = d.flt [3];
-    k = _l0 +_l1 + _k_s * (PERIOD + 4);
-    delete[] _p0;
-    _p0 = new float [k];
+    _d_r = d.flt [4];
+    _d_p = d.flt [5];
+    if (! _mapped) delete[] _p0;
+    _p0 = (float *) p;
+    _mapped = true;
     _p1 = _p0 + _l0;
     _p2 = _p1 + _l1;
-    fread (_p0, k, sizeof (float), F);
+    return p + k * sizeof (float);
 }
 
 
 
 
-Rankwave::Rankwave (int n0, int n1) : _n0 (n0), _n1 (n1), _list (0), _modif (false)
+Rankwave::Rankwave (int n0, int n1) : _n0 (n0), _n1 (n1), _list (0), _modif (false), _file (0)
 {
     _pipes = new Pipewave [n1 - n0 + 1];
+    _rgen.init (n0 + 128 * n1);
 }
 
 
 Rankwave::~Rankwave (void)
 {
     delete[] _pipes;
+    delete _file;
 }
 
 
@@ -408,6 +456,8 @@ void Rankwave::gen_waves (Addsynth *D, float fsamp, float fbase, float *scale)
     {
 	_pipes [i - _n0].genwave (D, i - _n0, fsamp, ldexpf (fbase * scale [i % 12], i / 12 - 5));
     }
+    delete _file;   // no pipe plays from the old mapping any more
+    _file = 0;
     _modif = true;
 }
 
@@ -435,7 +485,7 @@ void Rankwave::play (int shift)
 
     for (P = 0, Q = _list; Q; Q = Q->_link)
     {
-	Q->play ();
+	Q->play (&_rgen);
         if (shift) Q->_sdel = (Q->_sdel >> 1) | Q->_sbit;
         if (Q->_sdel || Q->_p_p || Q->_p_r) P = Q;
         else
@@ -460,10 +510,14 @@ int Rankwave::save (const char *path, Addsynth *D, float fsamp, float fbase, flo
     if ((p = strrchr (name, '.'))) strcpy (p, ".ae1");
     else strcat (name, ".ae1");
 
-    F = fopen (name, "wb");
+    // Write to a new file and rename it, a rank may still play
+    // from a mapping of the old one.
+    char tmpname [1040];
+    sprintf (tmpname, "%s.tmp", name);
+    F = fopen (tmpname, "wb");
     if (F == NULL)
     {
-	fprintf (stderr, "Can't open waveform file '%s' for writing\n", name);
+	fprintf (stderr, "Can't open waveform file '%s' for writing\n", tmpname);
         return 1;
     }
 
@@ -489,42 +543,69 @@ int Rankwave::save (const char *path, Addsynth *D, float fsamp, float fbase, flo
     for (i = _n0, P = _pipes; i <= _n1; i++, P++) P->save (F);
 
     fclose (F);
+    if (rename (tmpname, name))
+    {
+        remove (name);
+        if (rename (tmpname, name))
+        {
+	    fprintf (stderr, "Can't replace waveform file '%s'\n", name);
+            remove (tmpname);
+            return 1;
+        }
+    }
 
     _modif = false;
     return 0;
 }
 
 
+// The wave file is mapped and the pipes play directly from
+// the mapping, so loading a rank costs no more than the
+// header checks.
+
 int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, float *scale)
 {
-    FILE      *F;
     Pipewave  *P;
     int        i;
     char       name [1024];
     char       data [64];
     char      *p;
+    const char *q, *e;
     float      f;
 
     sprintf (name, "%s/%s", path, D->_filename);
     if ((p = strrchr (name, '.'))) strcpy (p, ".ae1");
     else strcat (name, ".ae1");
 
-    F = fopen (name, "rb");
-    if (F == NULL)
+    QFile *F = new QFile (QString::fromLocal8Bit (name));
+    if (! F->open (QIODevice::ReadOnly))
     {
 #ifdef DEBUG
 	fprintf (stderr, "Can't open waveform file '%s' for reading\n", name);
 #endif
+        delete F;
         return 1;
     }
+    q = (const char *) F->map (0, F->size ());
+    if ((q == 0) || (F->size () < 80))
+    {
+#ifdef DEBUG
+	fprintf (stderr, "Can't map waveform file '%s'\n", name);
+#endif
+        delete F;
+        return 1;
+    }
+    e = q + F->size ();
 
-    fread (data, 1, 16, F);
+    memcpy (data, q, 16);
+    q += 16;
+    data [15] = 0;
     if (strcmp (data, "ae1"))
     {
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' is not an Aeolus waveform file\n", name);
 #endif
-        fclose (F);
+        delete F;
         return 1;
     }
 
@@ -533,17 +614,18 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' has an incompatible version tag (%d)\n", name, data [4]);
 #endif
-        fclose (F);
+        delete F;
         return 1;
     }
 
-    fread (data, 1, 64, F);
+    memcpy (data, q, 64);
+    q += 64;
     if (_n0 != data [4] || _n1 != data [5])
     {
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' has an incompatible note range (%d %d), (%d %d)\n", name, _n0, _n1, data [4], data [5]);
 #endif
-        fclose (F);
+        delete F;
         return 1;
     }
 
@@ -553,7 +635,7 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' has a different sample frequency (%3.1lf)\n", name, f);
 #endif
-        fclose (F);
+        delete F;
         return 1;
     }
 
@@ -563,7 +645,7 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
 #ifdef DEBUG
 	fprintf (stderr, "File '%s' has a different tuning (%3.1lf)\n", name, f);
 #endif
-        fclose (F);
+        delete F;
         return 1;
     }
 
@@ -575,15 +657,26 @@ int Rankwave::load (const char *path, Addsynth *D, float fsamp, float fbase, flo
 #ifdef DEBUG
 	    fprintf (stderr, "File '%s' has a different temperament\n", name);
 #endif
-            fclose (F);
+            delete F;
             return 1;
         }
     }
 
-    for (i = _n0, P = _pipes; i <= _n1; i++, P++) P->load (F);
-
-    fclose (F);
+    for (i = _n0, P = _pipes; q && (i <= _n1); i++, P++) q = P->load (q, e);
+    if (q == 0)
+    {
+#ifdef DEBUG
+	fprintf (stderr, "File '%s' is truncated\n", name);
+#endif
+        // pipes loaded so far point into the mapping
+        delete[] _pipes;
+        _pipes = new Pipewave [_n1 - _n0 + 1];
+        delete F;
+        return 1;
+    }
 
+    delete _file;
+    _file = F;
     _modif = false;
     return 0;
 }
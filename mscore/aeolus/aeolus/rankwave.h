@@ -34,18 +34,19 @@ private:
 
     Pipewave (void) :
         _p0 (0), _p1 (0), _p2 (0), _l1 (0), _k_s (0),  _k_r (0), _m_r (0),
+	_d_r (0), _d_p (0), _mapped (false),
 	_link (0), _sbit (0), _sdel (0),
         _p_p (0), _y_p (0), _z_p (0), _p_r (0), _y_r (0), _g_r (0), _i_r (0)
     {}
 
-    ~Pipewave (void) { delete[] _p0; }
+    ~Pipewave (void) { if (! _mapped) delete[] _p0; }
 
     friend class Rankwave;
 
     void genwave (Addsynth *D, int n, float fsamp, float fpipe);
     void save (FILE *F);
-    void load (FILE *F);
-    void play (void);
+    const char *load (const char *p, const char *e);
+    void play (Rngen *R);
 
     static void looplen (float f, float fsamp, int lmax, int *aa, int *bb);
     static void attgain (int n, float p);
@@ -60,6 +61,7 @@ private:
     float      _m_r;   // release multiplier
     float      _d_r;   // release detune
     float      _d_p;   // instability
+    bool       _mapped; // _p0 points into a mapped wave file
 
     Pipewave  *_link;  // link to next in active chain
     uint32_t   _sbit;  // on state bit
@@ -139,6 +141,8 @@ private:
     Pipewave   *_list;
     Pipewave   *_pipes;
     bool        _modif;
+    Rngen       _rgen;  // per rank, ranks are played on several threads
+    QFile      *_file;  // mapped wave file, or 0
 };
 
 
@@ -35,6 +35,9 @@ Channel::Channel(Fluid* s, int num)
       _preset = 0;
       banknum = 0;
       prognum = 0;
+      voices  = 0;
+      for (int i = 0; i < 128; ++i)
+            keyVoices[i] = 0;
       reset();
       }
 
@@ -221,7 +224,7 @@ void Channel::setPreset(Preset* p)
       {
       if (_preset != p) {
             if (p)
-                  p->loadSamples();
+                  synth->loadPreset(p);
             _preset = p;
             }
       }
@@ -66,6 +66,7 @@
  *
  */
 
+#include "config.h"
 #include "chorus.h"
 #include "fluid.h"
 
@@ -75,27 +76,26 @@ namespace FluidS {
 #define MIN_SPEED_HZ	0.29
 #define MAX_SPEED_HZ    5
 
-/* Length of one delay line in samples:
+/* Maximum modulation depth in samples:
  * Set through MAX_SAMPLES_LN2.
  * For example:
  * MAX_SAMPLES_LN2=12
  * => MAX_SAMPLES=pow(2,12)=4096
- * => MAX_SAMPLES_ANDMASK=4095
  */
 #define MAX_SAMPLES_LN2 12
 
 #define MAX_SAMPLES (1 << (MAX_SAMPLES_LN2-1))
-#define MAX_SAMPLES_ANDMASK (MAX_SAMPLES-1)
 
 #define fluid_log(a, ...)
 
+ChorusKernel Chorus::kernel = chorus_scalar;
+
 //---------------------------------------------------------
 //   Chorus
 //---------------------------------------------------------
 
 Chorus::Chorus(float sr)
       {
-      counter     = 0;
       sample_rate = sr;
 
       /* Lookup table for the SI function (impulse response of an ideal low pass) */
@@ -107,20 +107,33 @@ Chorus::Chorus(float sr)
                   /* Move the origin into the center of the table */
                   double i_shifted = ((double) i- ((double) INTERPOLATION_SAMPLES) / 2.
 			  + (double) ii / (double) INTERPOLATION_SUBSAMPLES);
+                  float val;
                   if (fabs(i_shifted) < 0.000001) {
                         /* sinc(0) cannot be calculated straightforward (limit needed
                            for 0/0) */
-                        sinc_table[i][ii] = (float)1.;
+                        val = (float)1.;
                         }
                   else {
-                        sinc_table[i][ii] = (float)sin(i_shifted * M_PI) / (M_PI * i_shifted);
+                        val = (float)sin(i_shifted * M_PI) / (M_PI * i_shifted);
                         /* Hamming window */
-                        sinc_table[i][ii] *= (float)0.5 * (1.0 + cos(2.0 * M_PI * i_shifted / (float)INTERPOLATION_SAMPLES));
+                        val *= (float)0.5 * (1.0 + cos(2.0 * M_PI * i_shifted / (float)INTERPOLATION_SAMPLES));
                         }
+                  /* tap i is i samples before the read position, the
+                     window starts with the oldest sample */
+                  lines.coef[ii][INTERPOLATION_SAMPLES - 1 - i] = val;
                   }
             }
-      lookup_tab = new int[(int) (sample_rate / MIN_SPEED_HZ)];
-      chorusbuf  = new float[MAX_SAMPLES];
+      for (int ii = 0; ii < INTERPOLATION_SUBSAMPLES; ii++) {
+            for (int k = INTERPOLATION_SAMPLES; k < 8; k++)
+                  lines.coef[ii][k] = 0.0f;
+            }
+      lines.buffer  = new float[ChorusLines::SIZE + ChorusLines::GUARD];
+      lines.counter = 0;
+      for (int i = 0; i < CHORUS_LANES; i++) {
+            lines.lfoSin[i]   = 0.0f;
+            lines.lfoCos[i]   = 1.0f;
+            lines.lfoPhase[i] = 0.0f;
+            }
       reset();
       }
 
@@ -130,8 +143,7 @@ Chorus::Chorus(float sr)
 
 void Chorus::reset()
       {
-      memset(chorusbuf, 0, MAX_SAMPLES * sizeof(*chorusbuf));
-      number_blocks = 0;
+      memset(lines.buffer, 0, (ChorusLines::SIZE + ChorusLines::GUARD) * sizeof(float));
       number_blocks = FLUID_CHORUS_DEFAULT_N;
       level         = FLUID_CHORUS_DEFAULT_LEVEL;
       speed_Hz      = FLUID_CHORUS_DEFAULT_SPEED;
@@ -147,8 +159,21 @@ void Chorus::reset()
 
 Chorus::~Chorus()
       {
-      delete[] chorusbuf;
-      delete[] lookup_tab;
+      delete[] lines.buffer;
+      }
+
+//---------------------------------------------------------
+//   config
+//    select the chorus kernel for this cpu
+//---------------------------------------------------------
+
+void Chorus::config()
+      {
+#ifdef FLUID_SIMD
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("sse2"))
+            kernel = chorus_sse2;
+#endif
       }
 
 //---------------------------------------------------------
@@ -171,120 +196,111 @@ void Chorus::update()
             fluid_log(FLUID_WARN, "chorus: Too high depth. Setting it to max (%d).", MAX_SAMPLES);
             modulation_depth_samples = MAX_SAMPLES;
             }
-
-      /* initialize LFO table */
-      if (type == FLUID_CHORUS_MOD_SINE)
-            sine(lookup_tab, modulation_period_samples, modulation_depth_samples);
-      else if (type == FLUID_CHORUS_MOD_TRIANGLE)
-            triangle(lookup_tab, modulation_period_samples, modulation_depth_samples);
-      else {
+      if (type != FLUID_CHORUS_MOD_SINE && type != FLUID_CHORUS_MOD_TRIANGLE)
             type = FLUID_CHORUS_MOD_SINE;
-            sine(lookup_tab, modulation_period_samples, modulation_depth_samples);
-            }
+      number_blocks = qBound(0, number_blocks, MAX_CHORUS);
+
+      lines.blocks  = number_blocks;
+      lines.type    = type;
+      lines.depth   = modulation_depth_samples * INTERPOLATION_SUBSAMPLES;
+      lines.period  = modulation_period_samples;
+      lines.stepSin = sin(2.0 * M_PI / modulation_period_samples);
+      lines.stepCos = cos(2.0 * M_PI / modulation_period_samples);
 
       for (int i = 0; i < number_blocks; i++) {
             /* Set the phase of the chorus blocks equally spaced */
             phase[i] = (int) ((double) modulation_period_samples
-               * (double) i / (double) number_blocks);
+               * (double) i / (double) number_blocks) / (double) modulation_period_samples;
             }
-
-      /* Start of the circular buffer */
-      counter = 0;
       }
 
 //---------------------------------------------------------
 //   process
+//    The lfos are evaluated in double precision at the
+//    start of every block of BLOCK samples; the kernel
+//    continues them in float.
 //---------------------------------------------------------
 
 void Chorus::process(int n, float* in, float* left_out, float* right_out)
       {
-      for (int sample_index = 0; sample_index < n; sample_index++) {
-            float d_in = in[sample_index];
-            float d_out = 0.0f;
-
-            /* Write the current sample into the circular buffer */
-            chorusbuf[counter] = d_in;
-
-            for (int i = 0; i < number_blocks; i++) {
-                  /* Calculate the delay in subsamples for the delay line of chorus block nr. */
-
-                  /* The value in the lookup table is so, that this expression
-                   * will always be positive.  It will always include a number of
-                   * full periods of MAX_SAMPLES*INTERPOLATION_SUBSAMPLES to
-                   * remain positive at all times.
-                   */
-                  int pos_subsamples = (INTERPOLATION_SUBSAMPLES * counter
-                     - lookup_tab[phase[i]]);
-
-                  int pos_samples = pos_subsamples/INTERPOLATION_SUBSAMPLES;
-
-                  /* modulo divide by INTERPOLATION_SUBSAMPLES */
-                  pos_subsamples &= INTERPOLATION_SUBSAMPLES_ANDMASK;
-
-                  for (int ii = 0; ii < INTERPOLATION_SAMPLES; ii++) {
-	                  /* Add the delayed signal to the chorus sum d_out Note: The
-	                   * delay in the delay line moves backwards for increasing
-	                   * delay!*/
-
-	                  /* The & in chorusbuf[...] is equivalent to a division modulo
-	                     MAX_SAMPLES, only faster.
-                         */
-                        d_out += (chorusbuf[pos_samples & MAX_SAMPLES_ANDMASK]
-                           * sinc_table[ii][pos_subsamples]);
-                        pos_samples--;
-                        }
-                  /* Cycle the phase of the modulating LFO */
-                  phase[i]++;
-                  phase[i] %= (modulation_period_samples);
-                  } /* foreach chorus block */
-
-            d_out *= level;
-
-            /* Add the chorus sum d_out to output */
-            left_out[sample_index]  += d_out;
-            right_out[sample_index] += d_out;
-
-            /* Move forward in circular buffer */
-            counter++;
-            counter %= MAX_SAMPLES;
+      float out[BLOCK];
+
+      for (int i = 0; i < n; i += BLOCK) {
+            int m = qMin(int(BLOCK), n - i);
+
+            for (int k = 0; k < number_blocks; k++) {
+                  double a = phase[k] * 2.0 * M_PI;
+                  lines.lfoSin[k]   = sin(a);
+                  lines.lfoCos[k]   = cos(a);
+                  lines.lfoPhase[k] = phase[k];
+                  phase[k] += (double) m / (double) modulation_period_samples;
+                  phase[k] -= floor(phase[k]);
+                  }
+            kernel(&lines, m, in + i, out);
+
+            float* lo = left_out + i;
+            float* ro = right_out + i;
+            for (int k = 0; k < m; k++) {
+                  /* Add the chorus sum to output */
+                  float d_out = out[k] * level;
+                  lo[k] += d_out;
+                  ro[k] += d_out;
+                  }
             }
       }
 
-/* Purpose:
- *
- * Calculates a modulation waveform (sine) Its value ( modulo
- * MAXSAMPLES) varies between 0 and depth*INTERPOLATION_SUBSAMPLES.
- * Its period length is len.  The waveform data will be used modulo
- * MAXSAMPLES only.  Since MAXSAMPLES is substracted from the waveform
- * a couple of times here, the resulting (current position in
- * buffer)-(waveform sample) will always be positive.
- */
-void Chorus::sine(int *buf, int len, int depth)
-      {
-      for (int i = 0; i < len; i++) {
-            double val = sin((double) i / (double)len * 2.0 * M_PI);
-            buf[i] = (int) ((1.0 + val) * (double) depth / 2.0 * (double) INTERPOLATION_SUBSAMPLES);
-            buf[i] -= 3* MAX_SAMPLES * INTERPOLATION_SUBSAMPLES;
-            }
-      }
+//---------------------------------------------------------
+//   chorus_scalar
+//    The delay of a chorus block in subsamples is
+//    truncated as the lookup table of the original
+//    fluid chorus was. The read position is kept positive
+//    by adding the length of the delay line.
+//---------------------------------------------------------
 
-/* Purpose:
- * Calculates a modulation waveform (triangle)
- * See fluid_chorus_sine for comments.
- */
-void Chorus::triangle(int *buf, int len, int depth)
+void chorus_scalar(ChorusLines* cl, int n, const float* in, float* out)
       {
-      int i=0;
-      int ii=len-1;
-      double val;
-      double val2;
-
-      while (i <= ii){
-            val = i * 2.0 / len * (double)depth * (double) INTERPOLATION_SUBSAMPLES;
-            val2= (int) (val + 0.5) - 3 * MAX_SAMPLES * INTERPOLATION_SUBSAMPLES;
-            buf[i++] = (int) val2;
-            buf[ii--] = (int) val2;
+      const int mask = ChorusLines::SIZE - 1;
+      float* buf     = cl->buffer;
+
+      for (int k = 0; k < n; k++) {
+            int w  = (cl->counter + k) & mask;
+            buf[w] = in[k];
+            if (w < ChorusLines::GUARD)
+                  buf[ChorusLines::SIZE + w] = in[k];
+            out[k] = 0.0f;
+            }
+      const float inc   = 1.0f / cl->period;
+      const float scale = 2.0f / cl->period;
+      for (int i = 0; i < cl->blocks; i++) {
+            float s  = cl->lfoSin[i];
+            float c  = cl->lfoCos[i];
+            float ph = cl->lfoPhase[i];
+            for (int k = 0; k < n; k++) {
+                  int d;
+                  if (cl->type == FLUID_CHORUS_MOD_SINE) {
+                        d = (int) ((1.0f + s) * cl->depth * 0.5f);
+                        float t = s * cl->stepCos + c * cl->stepSin;
+                        c       = c * cl->stepCos - s * cl->stepSin;
+                        s       = t;
+                        }
+                  else {
+                        float t = ph * cl->period;
+                        t  = qMin(t, cl->period - 1.0f - t);
+                        d  = (int) (t * scale * cl->depth + 0.5f);
+                        ph += inc;
+                        if (ph >= 1.0f)
+                              ph -= 1.0f;
+                        }
+                  int pos         = (cl->counter + k + ChorusLines::SIZE) * INTERPOLATION_SUBSAMPLES - d;
+                  const float* w  = buf + (((pos >> (INTERPOLATION_SUBSAMPLES_LN2 - 1)) - 4) & mask);
+                  const float* co = cl->coef[pos & INTERPOLATION_SUBSAMPLES_ANDMASK];
+                  float sum = 0.0f;
+                  for (int ii = 0; ii < INTERPOLATION_SAMPLES; ii++)
+                        sum += w[ii] * co[ii];
+                  out[k] += sum;
+                  }
             }
+      cl->counter = (cl->counter + n) & mask;
       }
 
 //---------------------------------------------------------
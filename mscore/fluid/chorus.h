@@ -41,14 +41,55 @@ namespace FluidS {
 */
 #define INTERPOLATION_SAMPLES 5
 
+//---------------------------------------------------------
+//   ChorusLines
+//    the delay line and the lfo state of all chorus
+//    blocks as structure of arrays, padded to a multiple
+//    of four lanes. The lfo values are set by
+//    Chorus::process() at the start of every block.
+//---------------------------------------------------------
+
+static const int CHORUS_LANES = (MAX_CHORUS + 3) & ~3;
+
+struct ChorusLines {
+      static const int SIZE  = 4096;      // delay line, power of two
+      static const int GUARD = 8;         // the first samples again after the end
+
+      // sinc rows for one whole interpolation window of
+      // 8 samples, the oldest first; the last 3 are zero
+      float coef[INTERPOLATION_SUBSAMPLES][8] __attribute__ ((aligned (16)));
+      float lfoSin[CHORUS_LANES] __attribute__ ((aligned (16)));
+      float lfoCos[CHORUS_LANES] __attribute__ ((aligned (16)));
+      float lfoPhase[CHORUS_LANES] __attribute__ ((aligned (16)));    // in periods
+
+      float* buffer;                // SIZE + GUARD
+      int counter;                  // write position
+      int blocks;                   // chorus blocks (voices)
+      int type;
+      float depth;                  // modulation depth in subsamples
+      float period;                 // lfo period in samples
+      float stepSin;                // sine lfo rotation per sample
+      float stepCos;
+      };
+
+//---------------------------------------------------------
+//   chorus kernels
+//    write n <= Chorus::BLOCK samples into the delay
+//    line and sum the modulated taps of all chorus
+//    blocks into out, which is overwritten
+//---------------------------------------------------------
+
+typedef void (*ChorusKernel)(ChorusLines*, int n, const float* in, float* out);
+
+extern void chorus_scalar(ChorusLines*, int, const float*, float*);
+extern void chorus_sse2(ChorusLines*, int, const float*, float*);
 
 //---------------------------------------------------------
 //   Chorus
 //---------------------------------------------------------
 
 class Chorus {
-      static void triangle(int *buf, int len, int depth);
-      static void sine(int *buf, int len, int depth);
+      static const int BLOCK = 64;        // process() works in blocks of this size
 
       /* Store the values between fluid_chorus_set_xxx and fluid_chorus_update
       * Logic behind this:
@@ -65,17 +106,16 @@ class Chorus {
       float speed_Hz;
       int number_blocks;
 
-      float* chorusbuf;
-      int counter;
-      long phase[MAX_CHORUS];
       long modulation_period_samples;
-      int* lookup_tab;
+      double phase[MAX_CHORUS];           // of the lfos, in periods
       float sample_rate;
 
-      /* sinc lookup table */
-      float sinc_table[INTERPOLATION_SAMPLES][INTERPOLATION_SUBSAMPLES];
+      ChorusLines lines;
 
    public:
+      static ChorusKernel kernel;         // selected at runtime by config()
+      static void config();
+
       Chorus(float sample_rate);
       ~Chorus();
 
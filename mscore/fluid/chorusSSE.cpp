@@ -0,0 +1,104 @@
+/*
+ * August 24, 1998
+ * Copyright (C) 1998 Juergen Mueller And Sundry Contributors
+ * This source code is freely redistributable and may be used for
+ * any purpose.  This copyright notice must be maintained.
+ * Juergen Mueller And Sundry Contributors are not responsible for
+ * the consequences of using this software.
+ */
+
+//
+//    SSE2 version of the chorus kernel, compiled with -msse2,
+//    selected at runtime in Chorus::config()
+//
+//    The lfos of four chorus blocks are computed as the four
+//    lanes of a register. For every lane the interpolation
+//    window of 8 samples is read with two unaligned loads
+//    and multiplied with the matching sinc row; the lanes
+//    are summed once per sample.
+//
+
+#include <emmintrin.h>
+#include "chorus.h"
+#include "fluid.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   chorus_sse2
+//---------------------------------------------------------
+
+void chorus_sse2(ChorusLines* cl, int n, const float* in, float* out)
+      {
+      const int mask = ChorusLines::SIZE - 1;
+      float* buf     = cl->buffer;
+
+      for (int k = 0; k < n; k++) {
+            int w  = (cl->counter + k) & mask;
+            buf[w] = in[k];
+            if (w < ChorusLines::GUARD)
+                  buf[ChorusLines::SIZE + w] = in[k];
+            out[k] = 0.0f;
+            }
+
+      const bool sine      = cl->type == FLUID_CHORUS_MOD_SINE;
+      const __m128 one     = _mm_set1_ps(1.0f);
+      const __m128 half    = _mm_set1_ps(0.5f);
+      const __m128 depth   = _mm_set1_ps(cl->depth);
+      const __m128 hdepth  = _mm_set1_ps(cl->depth * 0.5f);
+      const __m128 period  = _mm_set1_ps(cl->period);
+      const __m128 period1 = _mm_set1_ps(cl->period - 1.0f);
+      const __m128 scale   = _mm_set1_ps(2.0f / cl->period);
+      const __m128 inc     = _mm_set1_ps(1.0f / cl->period);
+      const __m128 stepSin = _mm_set1_ps(cl->stepSin);
+      const __m128 stepCos = _mm_set1_ps(cl->stepCos);
+      const __m128i imask  = _mm_set1_epi32(mask);
+      const __m128i smask  = _mm_set1_epi32(INTERPOLATION_SUBSAMPLES_ANDMASK);
+      const __m128i four   = _mm_set1_epi32(4);
+
+      int start[4] __attribute__ ((aligned (16)));
+      int sub[4]   __attribute__ ((aligned (16)));
+
+      for (int i = 0; i < cl->blocks; i += 4) {
+            int lanes = cl->blocks - i < 4 ? cl->blocks - i : 4;
+            __m128 s  = _mm_load_ps(cl->lfoSin + i);
+            __m128 c  = _mm_load_ps(cl->lfoCos + i);
+            __m128 ph = _mm_load_ps(cl->lfoPhase + i);
+
+            for (int k = 0; k < n; k++) {
+                  __m128i d;
+                  if (sine) {
+                        d = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(one, s), hdepth));
+                        __m128 t = _mm_add_ps(_mm_mul_ps(s, stepCos), _mm_mul_ps(c, stepSin));
+                        c        = _mm_sub_ps(_mm_mul_ps(c, stepCos), _mm_mul_ps(s, stepSin));
+                        s        = t;
+                        }
+                  else {
+                        __m128 t = _mm_mul_ps(ph, period);
+                        t  = _mm_min_ps(t, _mm_sub_ps(period1, t));
+                        d  = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(t, scale), depth), half));
+                        ph = _mm_add_ps(ph, inc);
+                        ph = _mm_sub_ps(ph, _mm_and_ps(_mm_cmpge_ps(ph, one), one));
+                        }
+                  __m128i pos = _mm_sub_epi32(_mm_set1_epi32((cl->counter + k + ChorusLines::SIZE)
+                     * INTERPOLATION_SUBSAMPLES), d);
+                  _mm_store_si128((__m128i*)start, _mm_and_si128(_mm_sub_epi32(
+                     _mm_srli_epi32(pos, INTERPOLATION_SUBSAMPLES_LN2 - 1), four), imask));
+                  _mm_store_si128((__m128i*)sub, _mm_and_si128(pos, smask));
+
+                  __m128 acc = _mm_setzero_ps();
+                  for (int l = 0; l < lanes; l++) {
+                        const float* w  = buf + start[l];
+                        const float* co = cl->coef[sub[l]];
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(w), _mm_load_ps(co)));
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(w + 4), _mm_load_ps(co + 4)));
+                        }
+                  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+                  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+                  out[k] += _mm_cvtss_f32(acc);
+                  }
+            }
+      cl->counter = (cl->counter + n) & mask;
+      }
+}
+
@@ -18,9 +18,11 @@
  * 02111-1307, USA
  */
 
+#include "config.h"
 #include "fluid.h"
 #include "voice.h"
 #include "sfont.h"
+#include "dspkernels.h"
 
 namespace FluidS {
 
@@ -53,13 +55,17 @@ namespace FluidS {
 float Voice::interp_coeff_linear[FLUID_INTERP_MAX][2];
 
 /* 4th order (cubic) interpolation table (4 coefficients centered on 2nd) */
-float Voice::interp_coeff[FLUID_INTERP_MAX][4];
+float Voice::interp_coeff[FLUID_INTERP_MAX][4] __attribute__ ((aligned (16)));
 
-/* 7th order interpolation (7 coefficients centered on 3rd) */
-float Voice::sinc_table7[FLUID_INTERP_MAX][7];
+/* 7th order interpolation (7 coefficients centered on 3rd, 8th is always zero) */
+float Voice::sinc_table7[FLUID_INTERP_MAX][8] __attribute__ ((aligned (16)));
 
 #define SINC_INTERP_ORDER 7	/* 7th order constant */
 
+Voice::InterpKernel Voice::interp4 = Voice::interp4_scalar;
+Voice::InterpKernel Voice::interp7 = Voice::interp7_scalar;
+Voice::MixKernel Voice::mix         = Voice::mix_scalar;
+
 //---------------------------------------------------------
 //   dsp_float_config
 //    Initializes interpolation tables
@@ -105,6 +111,148 @@ void Voice::dsp_float_config()
                   }
             }
       fluid_check_fpe("interpolation table calculation");
+
+      //
+      // select the fastest interpolation kernels the cpu
+      // can execute; all of them produce the same output
+      //
+#ifdef FLUID_SIMD
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+            interp4 = interp4_avx2;
+            interp7 = interp7_avx2;
+            mix     = mix_avx2;
+            }
+      else if (__builtin_cpu_supports("sse2")) {
+            interp4 = interp4_sse2;
+            interp7 = interp7_sse2;
+            mix     = mix_sse2;
+            }
+#endif
+      }
+
+//---------------------------------------------------------
+//   interp4_avx2
+//    the block kernel is in dspAVX.cpp, the remaining
+//    samples are done by the scalar version
+//---------------------------------------------------------
+
+#ifdef FLUID_SIMD
+void Voice::interp4_avx2(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      unsigned i = interp4_avx2_block(buf, n, data, &phase->data, incr, amp, amp_incr, interp_coeff);
+      if (i < n)
+            interp4_scalar(buf + i, n - i, data, phase, incr, amp, amp_incr);
+      }
+
+//---------------------------------------------------------
+//   interp7_avx2
+//---------------------------------------------------------
+
+void Voice::interp7_avx2(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      unsigned i = interp7_avx2_block(buf, n, data, &phase->data, incr, amp, amp_incr, sinc_table7);
+      if (i < n)
+            interp7_scalar(buf + i, n - i, data, phase, incr, amp, amp_incr);
+      }
+
+//---------------------------------------------------------
+//   mix_avx2
+//---------------------------------------------------------
+
+void Voice::mix_avx2(const float* buf, unsigned n, float* left, float* right,
+   float* reverb, float* chorus, const float* gain)
+      {
+      unsigned i = mix_avx2_block(buf, n, left, right, reverb, chorus, gain);
+      if (i < n)
+            mix_scalar(buf + i, n - i, left + i, right + i, reverb + i, chorus + i, gain);
+      }
+#endif
+
+//---------------------------------------------------------
+//   mix_scalar
+//---------------------------------------------------------
+
+void Voice::mix_scalar(const float* buf, unsigned n, float* left, float* right,
+   float* reverb, float* chorus, const float* gain)
+      {
+      for (unsigned i = 0; i < n; ++i) {
+            float v    = buf[i];
+            left[i]   += gain[0] * v;
+            right[i]  += gain[1] * v;
+            reverb[i] += gain[2] * v;
+            chorus[i] += gain[3] * v;
+            }
+      }
+
+//---------------------------------------------------------
+//   interp_count
+//    return the number of samples (max n) which can be
+//    interpolated before the phase index passes end_index
+//---------------------------------------------------------
+
+unsigned Voice::interp_count(const Phase& phase, qint64 incr, unsigned end_index, unsigned n)
+      {
+      qint64 limit = (qint64(end_index) + 1) << 32;
+      if (phase.data >= limit)
+            return 0;
+      if (incr <= 0)
+            return n;
+      qint64 count = (limit - 1 - phase.data) / incr + 1;
+      return count < qint64(n) ? unsigned(count) : n;
+      }
+
+//---------------------------------------------------------
+//   interp4_scalar
+//    reference version of the 4th order kernel
+//---------------------------------------------------------
+
+void Voice::interp4_scalar(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      Phase p = *phase;
+      float a = *amp;
+      for (unsigned i = 0; i < n; ++i) {
+            int idx       = p.index();
+            const float* coeffs = interp_coeff[fluid_phase_fract_to_tablerow(p)];
+            buf[i] = a * (coeffs[0] * data[idx-1]
+               + coeffs[1] * data[idx]
+               + coeffs[2] * data[idx+1]
+               + coeffs[3] * data[idx+2]);
+            p.data += incr;
+            a      += amp_incr;
+            }
+      *phase = p;
+      *amp   = a;
+      }
+
+//---------------------------------------------------------
+//   interp7_scalar
+//    reference version of the 7th order kernel
+//---------------------------------------------------------
+
+void Voice::interp7_scalar(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      Phase p = *phase;
+      float a = *amp;
+      for (unsigned i = 0; i < n; ++i) {
+            int idx       = p.index();
+            const float* coeffs = sinc_table7[fluid_phase_fract_to_tablerow(p)];
+            buf[i] = a * (coeffs[0] * (float)data[idx-3]
+               + coeffs[1] * (float)data[idx-2]
+               + coeffs[2] * (float)data[idx-1]
+               + coeffs[3] * (float)data[idx]
+               + coeffs[4] * (float)data[idx+1]
+               + coeffs[5] * (float)data[idx+2]
+               + coeffs[6] * (float)data[idx+3]);
+            p.data += incr;
+            a      += amp_incr;
+            }
+      *phase = p;
+      *amp   = a;
       }
 
 //-------------------------------------------------------------------
@@ -331,17 +479,11 @@ int Voice::dsp_float_interpolate_4th_order(unsigned n)
                   }
 
             /* interpolate the sequence of sample points */
-            for ( ; dsp_i < n && dsp_phase_index <= end_index; dsp_i++) {
-                  coeffs = interp_coeff[fluid_phase_fract_to_tablerow (phase)];
-                  dsp_buf[dsp_i] = amp * (coeffs[0] * dsp_data[dsp_phase_index-1]
-				  + coeffs[1] * dsp_data[dsp_phase_index]
-				  + coeffs[2] * dsp_data[dsp_phase_index+1]
-				  + coeffs[3] * dsp_data[dsp_phase_index+2]);
-
-                  /* increment phase and amplitude */
-                  phase += dsp_phase_incr;
+            if (dsp_i < n) {
+                  unsigned count = interp_count(phase, dsp_phase_incr.data, end_index, n - dsp_i);
+                  interp4(dsp_buf + dsp_i, count, dsp_data, &phase, dsp_phase_incr.data, &amp, dsp_amp_incr);
+                  dsp_i += count;
                   dsp_phase_index = phase.index();
-                  amp += dsp_amp_incr;
                   }
 
             /* break out if buffer filled */
@@ -529,21 +671,11 @@ int Voice::dsp_float_interpolate_7th_order(unsigned n)
             start_index -= 2;	/* set back to original start index */
 
             /* interpolate the sequence of sample points */
-            for ( ; dsp_i < n && dsp_phase_index <= end_index; dsp_i++) {
-                  coeffs = sinc_table7[fluid_phase_fract_to_tablerow (dsp_phase)];
-
-                  dsp_buf[dsp_i] = dsp_amp * (coeffs[0] * (float)dsp_data[dsp_phase_index-3]
-                     + coeffs[1] * (float)dsp_data[dsp_phase_index-2]
-                     + coeffs[2] * (float)dsp_data[dsp_phase_index-1]
-                     + coeffs[3] * (float)dsp_data[dsp_phase_index]
-                     + coeffs[4] * (float)dsp_data[dsp_phase_index+1]
-                     + coeffs[5] * (float)dsp_data[dsp_phase_index+2]
-                     + coeffs[6] * (float)dsp_data[dsp_phase_index+3]);
-
-                  /* increment phase and amplitude */
-                  dsp_phase += dsp_phase_incr;
+            if (dsp_i < n) {
+                  unsigned count = interp_count(dsp_phase, dsp_phase_incr.data, end_index, n - dsp_i);
+                  interp7(dsp_buf + dsp_i, count, dsp_data, &dsp_phase, dsp_phase_incr.data, &dsp_amp, dsp_amp_incr);
+                  dsp_i += count;
                   dsp_phase_index = dsp_phase.index();
-                  dsp_amp += dsp_amp_incr;
                   }
 
             /* break out if buffer filled */
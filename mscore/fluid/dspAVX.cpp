@@ -0,0 +1,200 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+//
+//    AVX2 versions of the interpolation and mix kernels
+//    compiled with -mavx2, selected at runtime in
+//    Voice::dsp_float_config()
+//
+//    This file must not include headers with inline
+//    functions which are also compiled in other files
+//    (fluid.h, voice.h, Qt): the linker may keep the AVX2
+//    copy of such a function for the whole program. The
+//    kernels work on plain pointers and leave the tail of
+//    a block to the scalar code in dsp.cpp.
+//
+//    Eight output samples are computed per iteration;
+//    lanes 0-3 are kept in the low and lanes 4-7 in the
+//    high half of the 256 bit registers. As in the SSE2
+//    version the output is bit identical to the scalar code.
+//    Only the arithmetic is vectorized, the sample points
+//    are still loaded one output sample at a time.
+//
+
+#include <immintrin.h>
+#include "dspkernels.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   samples4
+//---------------------------------------------------------
+
+static inline __m128 samples4(__m128i s)
+      {
+      return _mm_cvtepi32_ps(_mm_cvtepi16_epi32(s));
+      }
+
+//---------------------------------------------------------
+//   pair
+//    combine lanes k and k+4 into one register
+//---------------------------------------------------------
+
+static inline __m256 pair(__m128 a, __m128 b)
+      {
+      return _mm256_insertf128_ps(_mm256_castps128_ps256(a), b, 1);
+      }
+
+//---------------------------------------------------------
+//   transpose
+//    4x4 transpose in both 128 bit halves
+//---------------------------------------------------------
+
+static inline void transpose(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+      {
+      __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+      __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+      __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+      __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+      r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+      r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+      r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+      r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+      }
+
+//---------------------------------------------------------
+//   phaseIndex
+//    sample index and table row of a 32.32 phase
+//---------------------------------------------------------
+
+static inline int phaseIndex(long long p)
+      {
+      return int(p >> 32);
+      }
+
+static inline int phaseRow(long long p)
+      {
+      return int((unsigned(p) & KERNEL_ROW_MASK) >> KERNEL_ROW_SHIFT);
+      }
+
+//---------------------------------------------------------
+//   interp4_avx2_block
+//---------------------------------------------------------
+
+unsigned interp4_avx2_block(float* buf, unsigned n, const short* data, long long* phase,
+   long long incr, float* amp, float amp_incr, const float (*coeff)[4])
+      {
+      long long p = *phase;
+      float a     = *amp;
+      unsigned i  = 0;
+
+      for (; i + 8 <= n; i += 8) {
+            __m128 v[8];
+            float av[8];
+            for (int k = 0; k < 8; ++k) {
+                  int idx = phaseIndex(p);
+                  __m128 d = samples4(_mm_loadl_epi64((const __m128i*)(data + idx - 1)));
+                  v[k]     = _mm_mul_ps(_mm_load_ps(coeff[phaseRow(p)]), d);
+                  av[k]    = a;
+                  p       += incr;
+                  a       += amp_incr;
+                  }
+            __m256 c0 = pair(v[0], v[4]);
+            __m256 c1 = pair(v[1], v[5]);
+            __m256 c2 = pair(v[2], v[6]);
+            __m256 c3 = pair(v[3], v[7]);
+            transpose(c0, c1, c2, c3);
+            __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(c0, c1), c2), c3);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(av), sum));
+            }
+      *phase = p;
+      *amp   = a;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   interp7_avx2_block
+//---------------------------------------------------------
+
+unsigned interp7_avx2_block(float* buf, unsigned n, const short* data, long long* phase,
+   long long incr, float* amp, float amp_incr, const float (*coeff)[8])
+      {
+      long long p = *phase;
+      float a     = *amp;
+      unsigned i  = 0;
+
+      for (; i + 8 <= n; i += 8) {
+            __m128 lo[8], hi[8];
+            float av[8];
+            for (int k = 0; k < 8; ++k) {
+                  int idx = phaseIndex(p);
+                  const float* coeffs = coeff[phaseRow(p)];
+                  __m128 d1 = samples4(_mm_loadl_epi64((const __m128i*)(data + idx - 3)));
+                  __m128 d2 = samples4(_mm_srli_si128(_mm_loadl_epi64((const __m128i*)(data + idx)), 2));
+                  lo[k]     = _mm_mul_ps(_mm_load_ps(coeffs), d1);
+                  hi[k]     = _mm_mul_ps(_mm_load_ps(coeffs + 4), d2);
+                  av[k]     = a;
+                  p        += incr;
+                  a        += amp_incr;
+                  }
+            __m256 l0 = pair(lo[0], lo[4]);
+            __m256 l1 = pair(lo[1], lo[5]);
+            __m256 l2 = pair(lo[2], lo[6]);
+            __m256 l3 = pair(lo[3], lo[7]);
+            __m256 h0 = pair(hi[0], hi[4]);
+            __m256 h1 = pair(hi[1], hi[5]);
+            __m256 h2 = pair(hi[2], hi[6]);
+            __m256 h3 = pair(hi[3], hi[7]);
+            transpose(l0, l1, l2, l3);
+            transpose(h0, h1, h2, h3);
+            __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(l0, l1), l2), l3);
+            sum        = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(sum, h0), h1), h2);
+            _mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(av), sum));
+            }
+      *phase = p;
+      *amp   = a;
+      return i;
+      }
+
+//---------------------------------------------------------
+//   mix_avx2_block
+//---------------------------------------------------------
+
+unsigned mix_avx2_block(const float* buf, unsigned n, float* left, float* right,
+   float* reverb, float* chorus, const float* gain)
+      {
+      const __m256 gl = _mm256_set1_ps(gain[0]);
+      const __m256 gr = _mm256_set1_ps(gain[1]);
+      const __m256 gv = _mm256_set1_ps(gain[2]);
+      const __m256 gc = _mm256_set1_ps(gain[3]);
+      unsigned i = 0;
+
+      for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(buf + i);
+            _mm256_storeu_ps(left + i,   _mm256_add_ps(_mm256_loadu_ps(left + i),   _mm256_mul_ps(gl, v)));
+            _mm256_storeu_ps(right + i,  _mm256_add_ps(_mm256_loadu_ps(right + i),  _mm256_mul_ps(gr, v)));
+            _mm256_storeu_ps(reverb + i, _mm256_add_ps(_mm256_loadu_ps(reverb + i), _mm256_mul_ps(gv, v)));
+            _mm256_storeu_ps(chorus + i, _mm256_add_ps(_mm256_loadu_ps(chorus + i), _mm256_mul_ps(gc, v)));
+            }
+      return i;
+      }
+}
+
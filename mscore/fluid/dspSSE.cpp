@@ -0,0 +1,143 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+//
+//    SSE2 versions of the interpolation and mix kernels
+//    compiled with -msse2, selected at runtime in
+//    Voice::dsp_float_config()
+//
+//    Four output samples are computed per iteration. The
+//    products of every output sample are transposed so
+//    that the sum is built in the same order as in the
+//    scalar code; the output is bit identical.
+//
+
+#include <emmintrin.h>
+#include "fluid.h"
+#include "voice.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   samples4
+//    convert four 16 bit sample points to float
+//---------------------------------------------------------
+
+static inline __m128 samples4(__m128i s)
+      {
+      return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+      }
+
+//---------------------------------------------------------
+//   interp4_sse2
+//---------------------------------------------------------
+
+void Voice::interp4_sse2(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      Phase p = *phase;
+      float a = *amp;
+      unsigned i = 0;
+
+      for (; i + 4 <= n; i += 4) {
+            __m128 v[4];
+            float av[4];
+            for (int k = 0; k < 4; ++k) {
+                  int idx = p.index();
+                  __m128 d = samples4(_mm_loadl_epi64((const __m128i*)(data + idx - 1)));
+                  v[k]     = _mm_mul_ps(_mm_load_ps(interp_coeff[fluid_phase_fract_to_tablerow(p)]), d);
+                  av[k]    = a;
+                  p.data  += incr;
+                  a       += amp_incr;
+                  }
+            _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(v[0], v[1]), v[2]), v[3]);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(av), sum));
+            }
+      *phase = p;
+      *amp   = a;
+      if (i < n)
+            interp4_scalar(buf + i, n - i, data, phase, incr, amp, amp_incr);
+      }
+
+//---------------------------------------------------------
+//   interp7_sse2
+//---------------------------------------------------------
+
+void Voice::interp7_sse2(float* buf, unsigned n, const short* data, Phase* phase,
+   qint64 incr, float* amp, float amp_incr)
+      {
+      Phase p = *phase;
+      float a = *amp;
+      unsigned i = 0;
+
+      for (; i + 4 <= n; i += 4) {
+            __m128 lo[4], hi[4];
+            float av[4];
+            for (int k = 0; k < 4; ++k) {
+                  int idx = p.index();
+                  const float* coeffs = sinc_table7[fluid_phase_fract_to_tablerow(p)];
+                  // points idx-3 .. idx and idx+1 .. idx+3; never read behind idx+3
+                  __m128 d1 = samples4(_mm_loadl_epi64((const __m128i*)(data + idx - 3)));
+                  __m128 d2 = samples4(_mm_srli_si128(_mm_loadl_epi64((const __m128i*)(data + idx)), 2));
+                  lo[k]     = _mm_mul_ps(_mm_load_ps(coeffs), d1);
+                  hi[k]     = _mm_mul_ps(_mm_load_ps(coeffs + 4), d2);
+                  av[k]     = a;
+                  p.data   += incr;
+                  a        += amp_incr;
+                  }
+            _MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+            _MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(lo[0], lo[1]), lo[2]), lo[3]);
+            sum        = _mm_add_ps(_mm_add_ps(_mm_add_ps(sum, hi[0]), hi[1]), hi[2]);
+            _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(av), sum));
+            }
+      *phase = p;
+      *amp   = a;
+      if (i < n)
+            interp7_scalar(buf + i, n - i, data, phase, incr, amp, amp_incr);
+      }
+
+//---------------------------------------------------------
+//   mix_sse2
+//---------------------------------------------------------
+
+void Voice::mix_sse2(const float* buf, unsigned n, float* left, float* right,
+   float* reverb, float* chorus, const float* gain)
+      {
+      const __m128 gl = _mm_set1_ps(gain[0]);
+      const __m128 gr = _mm_set1_ps(gain[1]);
+      const __m128 gv = _mm_set1_ps(gain[2]);
+      const __m128 gc = _mm_set1_ps(gain[3]);
+      unsigned i = 0;
+
+      for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(buf + i);
+            _mm_storeu_ps(left + i,   _mm_add_ps(_mm_loadu_ps(left + i),   _mm_mul_ps(gl, v)));
+            _mm_storeu_ps(right + i,  _mm_add_ps(_mm_loadu_ps(right + i),  _mm_mul_ps(gr, v)));
+            _mm_storeu_ps(reverb + i, _mm_add_ps(_mm_loadu_ps(reverb + i), _mm_mul_ps(gv, v)));
+            _mm_storeu_ps(chorus + i, _mm_add_ps(_mm_loadu_ps(chorus + i), _mm_mul_ps(gc, v)));
+            }
+      if (i < n)
+            mix_scalar(buf + i, n - i, left + i, right + i, reverb + i, chorus + i, gain);
+      }
+}
+
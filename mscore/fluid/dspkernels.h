@@ -0,0 +1,52 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#ifndef _FLUID_DSPKERNELS_H
+#define _FLUID_DSPKERNELS_H
+
+//
+//    plain block kernels of dspAVX.cpp
+//
+//    This header is included by files compiled with
+//    different instruction sets and must only contain
+//    declarations and constants, no inline functions.
+//
+//    A phase is a 32.32 fixed point sample position; the
+//    row of the interpolation table is taken from the top
+//    bits of the fraction (see fluid_phase_fract_to_tablerow()).
+//    The kernels process multiples of 8 samples and return
+//    the number of samples done.
+//
+
+namespace FluidS {
+
+static const unsigned KERNEL_ROW_MASK  = 0xff000000;
+static const int      KERNEL_ROW_SHIFT = 24;
+
+unsigned interp4_avx2_block(float* buf, unsigned n, const short* data, long long* phase,
+   long long incr, float* amp, float amp_incr, const float (*coeff)[4]);
+unsigned interp7_avx2_block(float* buf, unsigned n, const short* data, long long* phase,
+   long long incr, float* amp, float amp_incr, const float (*coeff)[8]);
+unsigned mix_avx2_block(const float* buf, unsigned n, float* left, float* right,
+   float* reverb, float* chorus, const float* gain);
+}
+
+#endif
@@ -18,6 +18,7 @@
  * 02111-1307, USA
  */
 
+#include "config.h"
 #include "libmscore/event.h"
 #include "fluid.h"
 #include "sfont.h"
@@ -25,6 +26,8 @@
 #include "gen.h"
 #include "chorus.h"
 #include "voice.h"
+#include "render.h"
+#include "voiceheap.h"
 #include "msynth/sparm_p.h"
 
 namespace FluidS {
@@ -91,6 +94,21 @@ Fluid::Fluid()
       reverb    = 0;
       chorus    = 0;
       silentBlocks = 0;
+      renderPool   = 0;
+      voicePool    = 0;
+      freeVoices   = new Voice*[MAX_VOICES];
+      activeVoices = new Voice*[MAX_VOICES];
+      nfree        = 0;
+      nactive      = 0;
+      deferFree    = false;
+      voiceHeap    = new VoiceHeap(MAX_VOICES);
+      loader       = 0;
+      _offline     = false;
+      ndeferred    = 0;
+
+      directOut      = 0;
+      directChannels = 0;
+      directPos      = 0;
       }
 
 //---------------------------------------------------------
@@ -103,6 +121,8 @@ void Fluid::init()
       initialized = true;
       fluid_conversion_config();
       Voice::dsp_float_config();
+      Reverb::config();
+      Chorus::config();
       }
 
 //---------------------------------------------------------
@@ -115,8 +135,10 @@ void Fluid::init(int sr)
       if (!initialized) // initialize all the conversion tables and other stuff
             init();
 
+      loader = new SampleLoader(this);
+      loader->start(QThread::LowPriority);
+
       sample_rate        = double(sr);
-      sfont_id           = 0;
       _gain              = .2;
 
       _state       = FLUID_SYNTH_PLAYING; // as soon as the synth is created it starts playing.
@@ -125,12 +147,24 @@ void Fluid::init(int sr)
             _tuning[i] = i * 100.0;
       _masterTuning = 440.0;
 
-      for (int i = 0; i < 512; i++)
-            freeVoices.append(new Voice(this));
+      //
+      // all voices live in one block, no allocation happens
+      // on note on
+      //
+      voicePool = static_cast<Voice*>(qMallocAligned(MAX_VOICES * sizeof(Voice), 64));
+      for (int i = 0; i < MAX_VOICES; i++)
+            freeVoices[nfree++] = new (voicePool + i) Voice(this);
 
       reverb = new Reverb();
       chorus = new Chorus(sample_rate);
       reverb->setPreset(0);
+
+      //
+      // create the channels here and not on their first
+      // event in the audio thread
+      //
+      for (int i = 0; i < MAX_CHANNELS; ++i)
+            channel.append(new Channel(this, i));
       }
 
 //---------------------------------------------------------
@@ -140,12 +174,21 @@ void Fluid::init(int sr)
 Fluid::~Fluid()
       {
       _state = FLUID_SYNTH_STOPPED;
-      foreach(Voice* v, activeVoices)
-            delete v;
-      foreach(Voice* v, freeVoices)
-            delete v;
+      if (loader) {
+            loader->stop();
+            delete loader;
+            }
+      delete renderPool;
+      delete voiceHeap;
+      if (voicePool) {
+            for (int i = 0; i < MAX_VOICES; i++)
+                  voicePool[i].~Voice();
+            qFreeAligned(voicePool);
+            }
+      delete[] freeVoices;
+      delete[] activeVoices;
       foreach(SFont* sf, sfonts)
-            delete sf;
+            SFont::release(sf);
       foreach(BankOffset* bankOffset, bank_offsets)
             delete bankOffset;
       foreach(Channel* c, channel)
@@ -166,37 +209,303 @@ Fluid::~Fluid()
 
 void Fluid::freeVoice(Voice* v)
       {
-      if (activeVoices.removeOne(v))
-            freeVoices.append(v);
+      if (deferFree)          // called while rendering
+            return;
+      int i = v->activeIndex;
+      if (i < 0)
+            return;
+      // move the last active voice into the gap
+      Voice* last     = activeVoices[--nactive];
+      activeVoices[i] = last;
+      last->activeIndex = i;
+      v->activeIndex  = -1;
+
+      voiceHeap->remove(v);
+      unlistVoice(v);
+      freeVoices[nfree++] = v;
+      }
+
+//---------------------------------------------------------
+//   listVoice
+//    add v to the voice lists of its channel, so channel
+//    and key events only visit the voices concerned
+//---------------------------------------------------------
+
+void Fluid::listVoice(Voice* v)
+      {
+      Channel* c     = v->channel;
+      v->listChannel = c;
+      v->chanPrev    = 0;
+      v->chanNext    = c->voices;
+      if (c->voices)
+            c->voices->chanPrev = v;
+      c->voices      = v;
+
+      Voice*& head   = c->keyVoices[v->key];
+      v->keyPrev     = 0;
+      v->keyNext     = head;
+      if (head)
+            head->keyPrev = v;
+      head           = v;
+      }
+
+//---------------------------------------------------------
+//   unlistVoice
+//---------------------------------------------------------
+
+void Fluid::unlistVoice(Voice* v)
+      {
+      Channel* c = v->listChannel;
+      if (!c)
+            return;
+      if (v->chanPrev)
+            v->chanPrev->chanNext = v->chanNext;
+      else
+            c->voices = v->chanNext;
+      if (v->chanNext)
+            v->chanNext->chanPrev = v->chanPrev;
+
+      if (v->keyPrev)
+            v->keyPrev->keyNext = v->keyNext;
+      else
+            c->keyVoices[v->key] = v->keyNext;
+      if (v->keyNext)
+            v->keyNext->keyPrev = v->keyPrev;
+
+      v->listChannel = 0;
+      v->chanPrev = v->chanNext = 0;
+      v->keyPrev  = v->keyNext  = 0;
+      }
+
+//---------------------------------------------------------
+//   FluidCmdFifo
+//---------------------------------------------------------
+
+FluidCmdFifo::FluidCmdFifo()
+      {
+      for (int i = 0; i < FIFO_SIZE; ++i)
+            cells[i].seq = i;
+      widx = 0;
+      ridx = 0;
+      }
+
+//---------------------------------------------------------
+//   put
+//    called from any thread; fails if less than reserve
+//    cells would stay free
+//---------------------------------------------------------
+
+bool FluidCmdFifo::put(const FluidCmd& cmd, int reserve)
+      {
+      int pos = widx;
+      for (;;) {
+            Cell* c  = &cells[pos & (FIFO_SIZE - 1)];
+            int diff = c->seq.fetchAndAddAcquire(0) - pos;
+            if (diff == 0 && reserve) {
+                  Cell* r = &cells[(pos + reserve) & (FIFO_SIZE - 1)];
+                  if (r->seq.fetchAndAddAcquire(0) - (pos + reserve) < 0)
+                        return false;     // only the reserve is left
+                  }
+            if (diff == 0) {
+                  // cell is free; try to claim it
+                  if (widx.testAndSetRelaxed(pos, pos + 1)) {
+                        c->cmd = cmd;
+                        c->seq.fetchAndStoreRelease(pos + 1);
+                        return true;
+                        }
+                  }
+            else if (diff < 0)
+                  return false;     // full
+            pos = widx;
+            }
+      }
+
+//---------------------------------------------------------
+//   get
+//    called from audio thread
+//---------------------------------------------------------
+
+bool FluidCmdFifo::get(FluidCmd* cmd)
+      {
+      Cell* c = &cells[ridx & (FIFO_SIZE - 1)];
+      if (c->seq.fetchAndAddAcquire(0) - (ridx + 1) < 0)
+            return false;           // empty
+      *cmd = c->cmd;
+      c->seq.fetchAndStoreRelease(ridx + FIFO_SIZE);
+      ++ridx;
+      return true;
+      }
+
+//---------------------------------------------------------
+//   isRelease
+//    messages which end notes must not get lost, a note
+//    would hang
+//---------------------------------------------------------
+
+static bool isRelease(const FluidCmd& cmd)
+      {
+      if (cmd.cmd == FLUID_CMD_NOTES_OFF || cmd.cmd == FLUID_CMD_SOUNDS_OFF)
+            return true;
+      if (cmd.cmd != FLUID_CMD_EVENT)
+            return false;
+      switch (cmd.type) {
+            case ME_NOTEOFF:
+                  return true;
+            case ME_NOTEON:
+                  return cmd.b == 0;
+            case ME_CONTROLLER:
+                  return cmd.a == ALL_NOTES_OFF || cmd.a == ALL_SOUND_OFF
+                     || (cmd.a == SUSTAIN_SWITCH && cmd.b < 64);
+            }
+      return false;
+      }
+
+//---------------------------------------------------------
+//   post
+//    The last CMD_RESERVE cells of the fifo are kept for
+//    messages which release notes. Lost messages are
+//    counted and reported by takeDroppedEvents().
+//---------------------------------------------------------
+
+void Fluid::post(const FluidCmd& cmd)
+      {
+      if (!cmdFifo.put(cmd, isRelease(cmd) ? 0 : CMD_RESERVE))
+            droppedCmds.fetchAndAddRelaxed(1);
+      }
+
+//---------------------------------------------------------
+//   lock
+//    exclude the audio thread while soundfonts are
+//    (un)loaded; the audio thread never waits for this
+//    flag, it renders silence while it is set.
+//    Lock order is busy, then the loader mutex: offline
+//    the audio thread takes the loader mutex while it
+//    holds busy, see loadPreset().
+//---------------------------------------------------------
+
+void Fluid::lock()
+      {
+      while (!busy.testAndSetAcquire(0, 1))
+            QThread::yieldCurrentThread();
+      if (loader)
+            loader->mutex.lock();
+      }
+
+//---------------------------------------------------------
+//   unlock
+//---------------------------------------------------------
+
+void Fluid::unlock()
+      {
+      if (loader)
+            loader->mutex.unlock();
+      busy.fetchAndStoreRelease(0);
+      }
+
+//---------------------------------------------------------
+//   loadPreset
+//    make the samples of preset p resident; this is done
+//    by the loader thread unless rendering offline. Called
+//    from the audio thread on program changes, so the
+//    request is only queued. Notes played before the
+//    samples are resident are deferred, see playEvent().
+//---------------------------------------------------------
+
+void Fluid::loadPreset(Preset* p)
+      {
+      if (_offline || !loader) {
+            QMutexLocker locker(loader ? &loader->mutex : 0);
+            p->loadSamples();
+            }
+      else if (!loader->load(p))
+            droppedCmds.fetchAndAddRelaxed(1);
+      }
+
+//---------------------------------------------------------
+//   processCommands
+//    apply all pending control messages
+//    called from audio thread at start of block
+//---------------------------------------------------------
+
+void Fluid::processCommands()
+      {
+      if (ndeferred)
+            playDeferred();
+      FluidCmd cmd;
+      while (cmdFifo.get(&cmd)) {
+            switch (cmd.cmd) {
+                  case FLUID_CMD_EVENT:
+                        playEvent(cmd.type, cmd.chan, cmd.a, cmd.b, cmd.val);
+                        break;
+                  case FLUID_CMD_NOTES_OFF:
+                        notesOff(cmd.chan);
+                        break;
+                  case FLUID_CMD_SOUNDS_OFF:
+                        soundsOff(cmd.chan);
+                        break;
+                  case FLUID_CMD_PARAMETER:
+                        {
+                        SParmId spid(cmd.a);
+                        if (spid.subsystemId == REVERB_GROUP)
+                              reverb->setParameter(spid.paramId, cmd.val);
+                        else if (spid.subsystemId == CHORUS_GROUP)
+                              chorus->setParameter(spid.paramId, cmd.val);
+                        }
+                        break;
+                  case FLUID_CMD_TUNING:
+                        _masterTuning = cmd.val;
+                        break;
+                  }
+            }
       }
 
 //---------------------------------------------------------
 //   play
+//    queue event for the audio thread
 //---------------------------------------------------------
 
 void Fluid::play(const Event& event)
+      {
+      FluidCmd cmd;
+      cmd.cmd  = FLUID_CMD_EVENT;
+      cmd.type = event.type();
+      cmd.chan = event.channel();
+      cmd.a    = event.dataA();
+      cmd.b    = event.dataB();
+      cmd.val  = event.tuning();
+      post(cmd);
+      }
+
+//---------------------------------------------------------
+//   playEvent
+//    audio thread
+//---------------------------------------------------------
+
+void Fluid::playEvent(int type, int ch, int a, int b, double tuning)
       {
       bool err = false;
-      int ch   = event.channel();
 
       if (ch >= channel.size()) {
             for (int i = channel.size(); i < ch+1; i++)
                   channel.append(new Channel(this, i));
             }
 
-      int type    = event.type();
       Channel* cp = channel[ch];
 
       if (type == ME_NOTEON) {
-            int key = event.dataA();
-            int vel = event.dataB();
+            int key = a;
+            int vel = b;
             if (vel == 0) {
                   //
                   // process note off
                   //
-                  foreach (Voice* v, activeVoices) {
-                        if (v->ON() && (v->chan == ch) && (v->key == key))
+                  if (ndeferred)
+                        cancelDeferred(ch, key);
+                  for (Voice* v = cp->keyVoices[key]; v;) {
+                        Voice* next = v->keyNext;     // v may be freed
+                        if (v->ON())
                               v->noteoff();
+                        v = next;
                         }
                   return;
                   }
@@ -204,6 +513,14 @@ void Fluid::play(const Event& event)
                   log("channel has no preset");
                   err = true;
                   }
+            else if (!cp->preset()->resident(key, vel)) {
+                  //
+                  // the loader thread has not yet made the
+                  // samples resident; hold the note back instead
+                  // of waiting for it
+                  //
+                  deferNote(ch, key, vel, tuning);
+                  }
             else {
                   /*
                    * If the same note is hit twice on the same channel, then the older
@@ -214,25 +531,27 @@ void Fluid::play(const Event& event)
                    * several voice processes, for example a stereo sample.  Don't
                    * release those...
                    */
-                  foreach(Voice* v, activeVoices) {
-                        if (v->isPlaying() && (v->chan == ch) && (v->key == key) && (v->get_id() != noteid))
+                  for (Voice* v = cp->keyVoices[key]; v;) {
+                        Voice* next = v->keyNext;
+                        if (v->isPlaying() && (v->get_id() != noteid))
                               v->noteoff();
+                        v = next;
                         }
-                  err = !cp->preset()->noteon(this, noteid++, ch, key, vel, event.tuning());
+                  err = !cp->preset()->noteon(this, noteid++, ch, key, vel, tuning);
                   }
             }
       else if (type == ME_CONTROLLER)  {
-            switch(event.controller()) {
+            switch(a) {
                   case CTRL_PROGRAM:
-                        program_change(ch, event.value());
+                        program_change(ch, b);
                         break;
                   case CTRL_PITCH:
-                        cp->pitchBend(event.value());
+                        cp->pitchBend(b);
                         break;
                   case CTRL_PRESS:
                         break;
                   default:
-                        cp->setcc(event.controller(), event.value());
+                        cp->setcc(a, b);
                         break;
                   }
             }
@@ -241,15 +560,79 @@ void Fluid::play(const Event& event)
                type, ch, qPrintable(error()));
       }
 
+//---------------------------------------------------------
+//   deferNote
+//    keep a note on until the samples of the channel
+//    preset are resident; audio thread
+//---------------------------------------------------------
+
+void Fluid::deferNote(int chan, int key, int vel, double tuning)
+      {
+      if (ndeferred == MAX_DEFERRED) {
+            droppedCmds.fetchAndAddRelaxed(1);
+            return;
+            }
+      DeferredNote& dn = deferred[ndeferred++];
+      dn.chan   = chan;
+      dn.key    = key;
+      dn.vel    = vel;
+      dn.tuning = tuning;
+      // repeat the request, it may have been lost to a full fifo
+      if (loader)
+            loader->load(channel[chan]->preset());
+      }
+
+//---------------------------------------------------------
+//   cancelDeferred
+//    a note off before the samples arrived cancels the
+//    note; key -1 cancels all notes of chan, chan -1
+//    all notes
+//---------------------------------------------------------
+
+void Fluid::cancelDeferred(int chan, int key)
+      {
+      int n = 0;
+      for (int i = 0; i < ndeferred; ++i) {
+            const DeferredNote& dn = deferred[i];
+            if ((chan == -1 || dn.chan == chan) && (key == -1 || dn.key == key))
+                  continue;
+            deferred[n++] = dn;
+            }
+      ndeferred = n;
+      }
+
+//---------------------------------------------------------
+//   playDeferred
+//    start the deferred notes whose samples are resident
+//    now; notes of channels which lost their preset are
+//    dropped
+//---------------------------------------------------------
+
+void Fluid::playDeferred()
+      {
+      int n = 0;
+      for (int i = 0; i < ndeferred; ++i) {
+            DeferredNote dn = deferred[i];
+            Preset* p = channel[dn.chan]->preset();
+            if (p && !p->resident(dn.key, dn.vel))
+                  deferred[n++] = dn;
+            else if (p)
+                  playEvent(ME_NOTEON, dn.chan, dn.key, dn.vel, dn.tuning);
+            }
+      ndeferred = n;
+      }
+
 //---------------------------------------------------------
 //   damp_voices
 //---------------------------------------------------------
 
 void Fluid::damp_voices(int chan)
       {
-      foreach(Voice* v, activeVoices) {
-            if ((v->chan == chan) && v->SUSTAINED())
+      for (Voice* v = channel[chan]->voices; v;) {
+            Voice* next = v->chanNext;
+            if (v->SUSTAINED())
                   v->noteoff();
+            v = next;
             }
       }
 
@@ -259,9 +642,26 @@ void Fluid::damp_voices(int chan)
 
 void Fluid::allNotesOff(int chan)
       {
-      foreach(Voice* v, activeVoices) {
-            if (chan == -1 || v->chan == chan)
-                  v->noteoff();
+      FluidCmd cmd;
+      cmd.cmd  = FLUID_CMD_NOTES_OFF;
+      cmd.chan = chan;
+      post(cmd);
+      }
+
+void Fluid::notesOff(int chan)
+      {
+      cancelDeferred(chan, -1);
+      if (chan == -1) {
+            for (int i = 0; i < nactive; ++i)
+                  activeVoices[i]->noteoff();
+            return;
+            }
+      if (chan >= channel.size())
+            return;
+      for (Voice* v = channel[chan]->voices; v;) {
+            Voice* next = v->chanNext;
+            v->noteoff();
+            v = next;
             }
       }
 
@@ -273,9 +673,27 @@ void Fluid::allNotesOff(int chan)
 
 void Fluid::allSoundsOff(int chan)
       {
-      foreach(Voice* v, activeVoices) {
-            if (chan == -1 || v->chan == chan)
-                  v->off();
+      FluidCmd cmd;
+      cmd.cmd  = FLUID_CMD_SOUNDS_OFF;
+      cmd.chan = chan;
+      post(cmd);
+      }
+
+void Fluid::soundsOff(int chan)
+      {
+      cancelDeferred(chan, -1);
+      if (chan == -1) {
+            // downwards: off() moves the last voice into the gap
+            for (int i = nactive - 1; i >= 0; --i)
+                  activeVoices[i]->off();
+            return;
+            }
+      if (chan >= channel.size())
+            return;
+      for (Voice* v = channel[chan]->voices; v;) {
+            Voice* next = v->chanNext;
+            v->off();
+            v = next;
             }
       }
 
@@ -288,8 +706,7 @@ void Fluid::allSoundsOff(int chan)
 
 void Fluid::system_reset()
       {
-      foreach(Voice* v, activeVoices)
-            v->off();
+      soundsOff(-1);
       foreach(Channel* c, channel)
             c->reset();
       chorus->reset();
@@ -304,10 +721,8 @@ void Fluid::system_reset()
  */
 void Fluid::modulate_voices(int chan, bool is_cc, int ctrl)
       {
-      foreach(Voice* v, activeVoices) {
-            if (v->chan == chan)
-                  v->modulate(is_cc, ctrl);
-            }
+      for (Voice* v = channel[chan]->voices; v; v = v->chanNext)
+            v->modulate(is_cc, ctrl);
       }
 
 /*
@@ -319,10 +734,8 @@ void Fluid::modulate_voices(int chan, bool is_cc, int ctrl)
  */
 void Fluid::modulate_voices_all(int chan)
       {
-      foreach(Voice* v, activeVoices) {
-            if (v->chan == chan)
-                  v->modulate_all();
-            }
+      for (Voice* v = channel[chan]->voices; v; v = v->chanNext)
+            v->modulate_all();
       }
 
 /*
@@ -484,102 +897,145 @@ void Fluid::program_reset()
 //---------------------------------------------------------
 
 void Fluid::process(unsigned len, float* lout, float* rout, float gain)
+      {
+      processMetered(len, lout, rout, gain, 0);
+      }
+
+//---------------------------------------------------------
+//   setDirectOutputs
+//    called from the audio thread at the start of a cycle
+//---------------------------------------------------------
+
+void Fluid::setDirectOutputs(float** out, int channels)
+      {
+      directOut      = out;
+      directChannels = out ? channels : 0;
+      directPos      = 0;
+      }
+
+//---------------------------------------------------------
+//   processMetered
+//    The voices of channels with direct outputs are mixed
+//    into them, without reverb, chorus and master gain;
+//    the effect sends go to the output. The output is
+//    metered in the final mix loop if peak is given.
+//---------------------------------------------------------
+
+void Fluid::processMetered(unsigned len, float* lout, float* rout, float gain, float* peak)
       {
       const int byte_size = len * sizeof(float);
 
+      //
+      // flush denormals while rendering; the filter and
+      // reverb tails would otherwise slow down the audio
+      // thread considerably
+      //
+      DenormalGuard denormals;
+
       /* clean the audio buffers */
       memset(left_buf,  0, byte_size);
       memset(right_buf, 0, byte_size);
       memset(fx_buf[0], 0, byte_size);
       memset(fx_buf[1], 0, byte_size);
 
-      if (mutex.tryLock()) {
-            if (activeVoices.isEmpty())
+      //
+      // the flag is only set by the gui while soundfonts are
+      // (un)loaded; pending commands stay queued until then
+      //
+      if (busy.testAndSetAcquire(0, 1)) {
+            processCommands();
+            if (nactive == 0)
                   silentBlocks--;
             else {
                   silentBlocks = SILENT_BLOCKS;
-                  foreach (Voice* v, activeVoices)
-                        v->write(len, left_buf, right_buf, fx_buf[0], fx_buf[1]);
+                  deferFree = true;
+                  if (renderPool && nactive >= MT_MIN_VOICES && directChannels == 0) {
+                        float* buf[4] = { left_buf, right_buf, fx_buf[0], fx_buf[1] };
+                        renderPool->process(activeVoices, nactive, len, buf);
+                        }
+                  else {
+                        for (int i = 0; i < nactive; ++i) {
+                              Voice* v = activeVoices[i];
+                              float* l = left_buf;
+                              float* r = right_buf;
+                              if (v->chan < directChannels && directOut[v->chan * 2]) {
+                                    l = directOut[v->chan * 2] + directPos;
+                                    r = directOut[v->chan * 2 + 1] + directPos;
+                                    }
+                              v->write(len, l, r, fx_buf[0], fx_buf[1]);
+                              }
+                        }
+                  deferFree = false;
+                  //
+                  // free the voices which finished in this block;
+                  // note offs, sustain and envelope transitions
+                  // change the kill priority of the others
+                  //
+                  for (int i = nactive - 1; i >= 0; --i) {
+                        Voice* v = activeVoices[i];
+                        if (v->status == FLUID_VOICE_OFF)
+                              freeVoice(v);
+                        else if (voiceHeap->changed(v))
+                              voiceHeap->update(v);
+                        }
                   }
             if (silentBlocks > 0) {
                   reverb->process(len, fx_buf[0], left_buf, right_buf);
                   chorus->process(len, fx_buf[1], left_buf, right_buf);
                   }
-            mutex.unlock();
+            busy.fetchAndStoreRelease(0);
             }
-      for (unsigned i = 0; i < len; i++) {
-            *lout++ += gain * left_buf[i];
-            *rout++ += gain * right_buf[i];
+      directPos += len;
+      if (peak) {
+            float lv = peak[0];
+            float rv = peak[1];
+            for (unsigned i = 0; i < len; i++) {
+                  float lval = (lout[i] += gain * left_buf[i]);
+                  float rval = (rout[i] += gain * right_buf[i]);
+                  lv = qMax(lv, fabsf(lval));
+                  rv = qMax(rv, fabsf(rval));
+                  }
+            peak[0] = lv;
+            peak[1] = rv;
+            }
+      else {
+            for (unsigned i = 0; i < len; i++) {
+                  *lout++ += gain * left_buf[i];
+                  *rout++ += gain * right_buf[i];
+                  }
             }
       }
 
-/*
- * fluid_synth_free_voice_by_kill
- *
- * selects a voice for killing. the selection algorithm is a refinement
- * of the algorithm previously in fluid_synth_alloc_voice.
- */
+//---------------------------------------------------------
+//   setRenderThreads
+//    distribute the active voices over n threads; below
+//    MT_MIN_VOICES active voices only the calling thread
+//    renders. Called from the gui thread.
+//---------------------------------------------------------
 
-void Fluid::free_voice_by_kill()
+void Fluid::setRenderThreads(int n)
       {
-      float best_prio = 999999.;
-      float this_voice_prio;
-      Voice* best_voice = 0;
-
-      foreach(Voice* v, activeVoices) {
-            /* Determine, how 'important' a voice is.
-             * Start with an arbitrary number */
-            this_voice_prio = 10000.;
-
-            /* Is this voice on the drum channel?
-             * Then it is very important.
-             * Also, forget about the released-note condition:
-             * Typically, drum notes are triggered only very briefly, they run most
-             * of the time in release phase.
-             */
-            if (v->chan == 9) {
-                  this_voice_prio += 4000;
-
-                  }
-            else if (v->RELEASED()) {
-                  /* The key for this voice has been released. Consider it much less important
-                  * than a voice, which is still held.
-                  */
-                  this_voice_prio -= 2000.;
-                  }
-
-            if (v->SUSTAINED()) {
-              /* The sustain pedal is held down on this channel.
-               * Consider it less important than non-sustained channels.
-               * This decision is somehow subjective. But usually the sustain pedal
-               * is used to play 'more-voices-than-fingers', so it shouldn't hurt
-               * if we kill one voice.
-               */
-                  this_voice_prio -= 1000;
-                  }
-
-            /* We are not enthusiastic about releasing voices, which have just been started.
-             * Otherwise hitting a chord may result in killing notes belonging to that very same
-             * chord.
-             * So subtract the age of the voice from the priority - an older voice is just a little
-             * bit less important than a younger voice.
-             * This is a number between roughly 0 and 100.*/
-
-            this_voice_prio -= (noteid - v->get_id());
+      n = qBound(1, n, 16);
+      if ((renderPool ? renderPool->threads() : 1) == n)
+            return;
+      RenderPool* pool = n > 1 ? new RenderPool(n) : 0;
+      lock();
+      qSwap(pool, renderPool);
+      unlock();
+      delete pool;
+      }
 
-            /* take a rough estimate of loudness into account. Louder voices are more important. */
-            if (v->volenv_section != FLUID_VOICE_ENVATTACK) {
-                  this_voice_prio += v->volenv_val * 1000.;
-                  }
+//---------------------------------------------------------
+//   free_voice_by_kill
+//    kill the least important voice; the priorities are
+//    kept up to date in voiceHeap, see VoiceHeap::priority()
+//---------------------------------------------------------
 
-            /* check if this voice has less priority than the previous candidate. */
-            if (this_voice_prio < best_prio) {
-                  best_voice = v;
-                  best_prio = this_voice_prio;
-                  }
-            }
-      if (best_voice)
-            best_voice->off();
+void Fluid::free_voice_by_kill()
+      {
+      Voice* v = voiceHeap->top();
+      if (v)
+            v->off();
       }
 
 //---------------------------------------------------------
@@ -591,25 +1047,29 @@ Voice* Fluid::alloc_voice(unsigned id, Sample* sample, int chan, int key, int ve
       Channel* c = 0;
 
       /* check if there's an available synthesis process */
-      if (freeVoices.isEmpty())
+      if (nfree == 0)
             free_voice_by_kill();
 
-      if (freeVoices.isEmpty()) {
+      if (nfree == 0) {
             log("Failed to allocate a synthesis process. (chan=%d,key=%d)", chan, key);
             return 0;
             }
 
-      Voice* v = freeVoices.takeLast();
-      activeVoices.append(v);
+      Voice* v = freeVoices[--nfree];
+      v->activeIndex = nactive;
+      activeVoices[nactive++] = v;
 
       if (chan >= 0)
             c = channel[chan];
 
       v->init(sample, c, key, vel, id, vt);
+      listVoice(v);
 
-      /* add the default modulators to the synthesis process. */
-      for (unsigned i = 0; i < sizeof(defaultMod)/sizeof(*defaultMod); ++i)
-            v->add_mod(&defaultMod[i],  FLUID_VOICE_DEFAULT);
+      /* add the default modulators to the synthesis process; they are
+         all valid and the voice has no other modulators yet, so the
+         table is copied as a whole */
+      v->setMods(defaultMod, sizeof(defaultMod)/sizeof(*defaultMod));
+      voiceHeap->insert(v);
       return v;
       }
 
@@ -641,16 +1101,14 @@ void Fluid::start_voice(Voice* voice)
 
             /* Kill all notes on the same channel with the same exclusive class */
 
-            foreach(Voice* existing_voice, activeVoices) {
+            /* An exclusive class is valid for a whole channel (or preset),
+             * only look at the voices of this channel. */
+            for (Voice* existing_voice = voice->channel->voices; existing_voice;
+               existing_voice = existing_voice->chanNext) {
                   /* Existing voice does not play? Leave it alone. */
                   if (!existing_voice->isPlaying())
                         continue;
 
-                  /* An exclusive class is valid for a whole channel (or preset).
-                   * Is the voice on a different channel? Leave it alone. */
-                  if (existing_voice->chan != voice->chan)
-                        continue;
-
                   /* Existing voice has a different (or no) exclusive class? Leave it alone. */
                   if ((int)existing_voice->GEN(GEN_EXCLUSIVECLASS) != excl_class)
                         continue;
@@ -663,6 +1121,7 @@ void Fluid::start_voice(Voice* voice)
                   }
             }
       voice->voice_start();
+      voiceHeap->update(voice);
       }
 
 //---------------------------------------------------------
@@ -713,9 +1172,8 @@ bool Fluid::loadSoundFonts(const QStringList& sl)
             // printf("Fluid:loadSoundFonts: already loaded\n");
             return true;
             }
-      mutex.lock();
-      foreach(Voice* v, activeVoices)
-            v->off();
+      lock();
+      soundsOff(-1);
       foreach(Channel* c, channel)
             c->reset();
       foreach (SFont* sf, sfonts)
@@ -726,7 +1184,7 @@ bool Fluid::loadSoundFonts(const QStringList& sl)
             if (sfload(sl[i], true) == -1)
                   ok = false;
             }
-      mutex.unlock();
+      unlock();
       return ok;
       }
 
@@ -737,9 +1195,9 @@ bool Fluid::loadSoundFonts(const QStringList& sl)
 
 bool Fluid::addSoundFont(const QString& s)
       {
-      mutex.lock();
+      lock();
       bool rv = (sfload(s, true) == -1) ? false : true;
-      mutex.unlock();
+      unlock();
       return rv;
       }
 
@@ -750,12 +1208,11 @@ bool Fluid::addSoundFont(const QString& s)
 
 bool Fluid::removeSoundFont(const QString& s)
       {
-      mutex.lock();
-      foreach(Voice* v, activeVoices)
-            v->off();
+      lock();
+      soundsOff(-1);
       SFont* sf = get_sfont_by_name(s);
       sfunload(sf->id(), true);
-      mutex.unlock();
+      unlock();
       return true;
       }
 
@@ -768,15 +1225,14 @@ int Fluid::sfload(const QString& filename, bool reset_presets)
       if (filename.isEmpty())
             return -1;
 
-      SFont* sf = new SFont(this);
-      if (!sf->read(filename)) {
-            delete sf;
-            sf = 0;
+      SFont* sf = SFont::acquire(this, filename);
+      if (!sf)
             return -1;
+      if (get_sfont_by_id(sf->id())) {    // already loaded
+            SFont::release(sf);
+            return sf->id();
             }
 
-      sf->setId(++sfont_id);
-
       /* insert the sfont as the first one on the list */
       sfonts.prepend(sf);
 
@@ -808,7 +1264,7 @@ bool Fluid::sfunload(int id, bool reset_presets)
             program_reset();
       else
             update_presets();
-      delete sf;
+      SFont::release(sf);
       updatePatchList();
       return true;
       }
@@ -819,8 +1275,6 @@ bool Fluid::sfunload(int id, bool reset_presets)
 
 int Fluid::add_sfont(SFont* sf)
       {
-	sf->setId(++sfont_id);
-
 	/* insert the sfont as the first one on the list */
       sfonts.prepend(sf);
 
@@ -889,10 +1343,8 @@ void Fluid::set_interp_method(int chan, int interp_method)
 void Fluid::set_gen(int chan, int param, float value)
       {
       channel[chan]->setGen(param, value, 0);
-      foreach(Voice* v, activeVoices) {
-            if (v->chan == chan)
-                  v->set_param(param, value, 0);
-            }
+      for (Voice* v = channel[chan]->voices; v; v = v->chanNext)
+            v->set_param(param, value, 0);
       }
 
 /** Change the value of a generator. This function allows to control
@@ -923,10 +1375,8 @@ void Fluid::set_gen2(int chan, int param, float value, int absolute, int normali
       float v = (normalized)? fluid_gen_scale(param, value) : value;
       channel[chan]->setGen(param, v, absolute);
 
-      foreach(Voice* vo, activeVoices) {
-            if (vo->chan == chan)
-                  vo->set_param(param, v, absolute);
-            }
+      for (Voice* vo = channel[chan]->voices; vo; vo = vo->chanNext)
+            vo->set_param(param, v, absolute);
       }
 
 float Fluid::get_gen(int chan, int param)
@@ -1017,10 +1467,23 @@ void Fluid::setParameter(int id, double value)
       SParmId spid(id);
       if (spid.syntiId != FLUID_ID)
             return;
-      if (spid.subsystemId == REVERB_GROUP)
-            reverb->setParameter(spid.paramId, value);
-      else if (spid.subsystemId == CHORUS_GROUP)
-            chorus->setParameter(spid.paramId, value);
+      FluidCmd cmd;
+      cmd.cmd = FLUID_CMD_PARAMETER;
+      cmd.a   = id;
+      cmd.val = value;
+      post(cmd);
+      }
+
+//---------------------------------------------------------
+//   setMasterTuning
+//---------------------------------------------------------
+
+void Fluid::setMasterTuning(double f)
+      {
+      FluidCmd cmd;
+      cmd.cmd = FLUID_CMD_TUNING;
+      cmd.val = f;
+      post(cmd);
       }
 
 /**
@@ -1120,14 +1583,11 @@ void Fluid::setState(SyntiState& sp)
             if (spid.syntiId != FLUID_ID)
                   continue;
             int group = spid.subsystemId;
-            int no    = spid.paramId;
 
             if (group == FLUID_GROUP)
                   ;
-            else if (group == REVERB_GROUP)
-                  reverb->setParameter(no, p.fval());
-            else if (group == CHORUS_GROUP)
-                  chorus->setParameter(no, p.fval());
+            else if (group == REVERB_GROUP || group == CHORUS_GROUP)
+                  setParameter(id, p.fval());
             else
                   printf("Fluid::setState: unknown group %d\n", group);
             }
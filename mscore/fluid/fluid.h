@@ -22,6 +22,7 @@
 #ifndef __FLUID_S_H__
 #define __FLUID_S_H__
 
+#include "config.h"
 #include "msynth/synti.h"
 #include "libmscore/midipatch.h"
 #include "rev.h"
@@ -37,6 +38,16 @@ struct Mod;
 class Reverb;
 class Chorus;
 class Fluid;
+class RenderPool;
+class VoiceHeap;
+class SampleLoader;
+
+//    denormals are flushed to zero in the SSE control register;
+//    DAZ needs SSE2, which is not implied by FLUID_SIMD on i386
+#if defined(FLUID_SIMD) && defined(__SSE2__)
+#define FLUID_FTZ
+#include <xmmintrin.h>
+#endif
 
 #define FLUID_MAX_BUFSIZE       4096
 #define FLUID_NUM_PROGRAMS      129
@@ -232,6 +243,9 @@ class Channel {
 
       short cc[128];          // controller values
 
+      Voice* voices;          // active voices of this channel
+      Voice* keyVoices[128];  // active voices of this channel by key
+
       /* cached values of last MSB values of MSB/LSB controllers */
       unsigned char bank_msb;
       int interp_method;
@@ -309,20 +323,98 @@ enum {
       CHORUS_GAIN
       };
 
+//---------------------------------------------------------
+//   FluidCmd
+//    control message for the synthesizer; posted from any
+//    thread and applied by the audio thread at the start
+//    of the next block
+//---------------------------------------------------------
+
+enum {
+      FLUID_CMD_EVENT,        // midi event: type, chan, a, b, val = tuning
+      FLUID_CMD_NOTES_OFF,    // chan
+      FLUID_CMD_SOUNDS_OFF,   // chan
+      FLUID_CMD_PARAMETER,    // a = parameter id, val
+      FLUID_CMD_TUNING,       // val = master tuning
+      FLUID_CMD_LOAD          // load preset samples: chan = soundfont id, a = bank, b = preset
+      };
+
+struct FluidCmd {
+      int cmd;
+      int type;
+      int chan;
+      int a;
+      int b;
+      double val;
+      };
+
+//---------------------------------------------------------
+//   FluidCmdFifo
+//    bounded lock free fifo
+//    - any number of writers
+//    - only one reader (the audio thread)
+//    - every cell carries a sequence number which tells
+//      whether it is free for writing or ready for reading
+//    - a writer can leave room for more urgent messages
+//---------------------------------------------------------
+
+class FluidCmdFifo {
+   public:
+      static const int FIFO_SIZE = 1024;  // must be a power of two
+
+   private:
+      struct Cell {
+            QAtomicInt seq;
+            FluidCmd cmd;
+            };
+      Cell cells[FIFO_SIZE];
+      QAtomicInt widx;        // next write position, shared by writers
+      int ridx;               // next read position, reader only
+
+   public:
+      FluidCmdFifo();
+      bool put(const FluidCmd&, int reserve = 0);     // returns false if fifo is full
+      bool get(FluidCmd*);          // returns false if fifo is empty
+      };
+
+//---------------------------------------------------------
+//   DenormalGuard
+//    flush denormals to zero (FTZ) and treat denormal
+//    inputs as zero (DAZ) while in scope. MXCSR is per
+//    thread: every thread which renders voices or effects
+//    needs its own guard.
+//---------------------------------------------------------
+
+class DenormalGuard {
+#ifdef FLUID_FTZ
+      unsigned int csr;
+
+   public:
+      DenormalGuard()   { csr = _mm_getcsr(); _mm_setcsr(csr | 0x8040); }
+      ~DenormalGuard()  { _mm_setcsr(csr); }
+#endif
+      };
+
 //---------------------------------------------------------
 //   Fluid
 //---------------------------------------------------------
 
 class Fluid : public Synth {
       static const int SILENT_BLOCKS = 32*5;
+      static const int MAX_VOICES    = 512;
+      static const int MAX_CHANNELS  = 256;     // created by init(), more on demand
+      static const int MT_MIN_VOICES = 16;      // render single threaded below
       int silentBlocks;
 
       QList<SFont*> sfonts;               // the loaded soundfonts
       QList<BankOffset*> bank_offsets;    // the offsets of the soundfont banks
       QList<MidiPatch*> patches;
 
-      QList<Voice*> freeVoices;           // unused synthesis processes
-      QList<Voice*> activeVoices;         // active synthesis processes
+      Voice* voicePool;                   // all synthesis processes, one block
+      Voice** freeVoices;                 // unused synthesis processes
+      int nfree;
+      Voice** activeVoices;               // active synthesis processes
+      int nactive;
       QString _error;                     // last error message
 
       static bool initialized;
@@ -332,14 +424,49 @@ class Fluid : public Synth {
       float _masterTuning;                // usually 440.0
       double _tuning[128];                // the pitch of every key, in cents
 
-      QMutex mutex;
+      static const int CMD_RESERVE = 128; // fifo cells only note offs may use
+      FluidCmdFifo cmdFifo;               // control messages to audio thread
+      QAtomicInt droppedCmds;             // lost to a full fifo
+      QAtomicInt busy;                    // set while rendering or (un)loading soundfonts
+
+      RenderPool* renderPool;             // worker threads, 0 if single threaded
+      bool deferFree;                     // voices are freed after rendering
+      VoiceHeap* voiceHeap;               // active voices by kill priority
+
+      SampleLoader* loader;               // loads preset samples in the background
+      bool _offline;                      // load samples synchronously
+
+      struct DeferredNote {               // note on waiting for its samples
+            int chan;
+            int key;
+            int vel;
+            double tuning;
+            };
+      static const int MAX_DEFERRED = 64;
+      DeferredNote deferred[MAX_DEFERRED];      // audio thread only
+      int ndeferred;
+
+      float** directOut;                  // see Synth::setDirectOutputs()
+      int directChannels;
+      unsigned directPos;                 // frames written in this cycle
+
       void updatePatchList();
+      void post(const FluidCmd&);
+      void processCommands();
+      void playEvent(int type, int ch, int a, int b, double tuning);
+      void lock();
+      void unlock();
+      void notesOff(int chan);
+      void listVoice(Voice*);
+      void unlistVoice(Voice*);
+      void soundsOff(int chan);
+      void deferNote(int chan, int key, int vel, double tuning);
+      void cancelDeferred(int chan, int key);
+      void playDeferred();
 
    protected:
       int _state;                         // the synthesizer state
 
-      unsigned int sfont_id;
-
       double _gain;                       // master gain
       QList<Channel*> channel;            // the channels
 
@@ -379,6 +506,14 @@ class Fluid : public Synth {
       virtual void setState(SyntiState&);
       virtual void allSoundsOff(int);
       virtual void allNotesOff(int);
+      virtual void setRenderThreads(int);
+      virtual int voiceCount() const      { return nactive; }
+      virtual int takeDroppedEvents()     { return droppedCmds.fetchAndStoreRelaxed(0); }
+      virtual void setOffline(bool val)   { _offline = val; }
+      virtual void setDirectOutputs(float** out, int channels);
+
+      void loadPreset(Preset*);
+      friend class SampleLoader;
 
       bool log(const char* fmt, ...);
 
@@ -422,6 +557,7 @@ class Fluid : public Synth {
       void free_voice_by_kill();
 
       virtual void process(unsigned len, float* lout, float* rout, float gain);
+      virtual void processMetered(unsigned len, float* lout, float* rout, float gain, float* peak);
 
       void program_reset();
 
@@ -445,7 +581,7 @@ class Fluid : public Synth {
       float ct2hz(float cents)  { return act2hz(qBound(1500.0f, cents, 13500.0f)); }
 
       virtual double masterTuning() const     { return _masterTuning; }
-      virtual void setMasterTuning(double f)  { _masterTuning = f;    }
+      virtual void setMasterTuning(double f);
 
       QString error() const { return _error; }
 
@@ -0,0 +1,125 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+#include "fluid.h"
+#include "voice.h"
+#include "render.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   RenderPool
+//    threads is the total number of rendering threads
+//    including the calling thread
+//---------------------------------------------------------
+
+RenderPool::RenderPool(int threads)
+   : WorkerPool(threads)
+      {
+      voices   = 0;
+      nvoices  = 0;
+      len      = 0;
+      out      = 0;
+      shareBuf = new float*[threads][4];
+      used     = new bool[threads];
+      for (int i = 0; i < threads; ++i) {
+            for (int k = 0; k < 4; ++k)
+                  shareBuf[i][k] = i ? new float[FLUID_MAX_BUFSIZE] : 0;
+            used[i] = false;
+            }
+      }
+
+RenderPool::~RenderPool()
+      {
+      for (int i = 0; i < threads(); ++i) {
+            for (int k = 0; k < 4; ++k)
+                  delete[] shareBuf[i][k];
+            }
+      delete[] shareBuf;
+      delete[] used;
+      }
+
+//---------------------------------------------------------
+//   renderVoices
+//    render the share idx: the voices idx, idx + threads(),
+//    idx + 2 * threads() ...; if clear is set, buf is
+//    cleared before the first voice is written. Returns
+//    true if anything was rendered.
+//---------------------------------------------------------
+
+bool RenderPool::renderVoices(float** buf, int idx, bool clear)
+      {
+      bool rendered = false;
+      for (int i = idx; i < nvoices; i += threads()) {
+            if (clear && !rendered) {
+                  for (int k = 0; k < 4; ++k)
+                        memset(buf[k], 0, len * sizeof(float));
+                  }
+            rendered = true;
+            voices[i]->write(len, buf[0], buf[1], buf[2], buf[3]);
+            }
+      return rendered;
+      }
+
+//---------------------------------------------------------
+//   job
+//    run by a worker or by the calling thread
+//---------------------------------------------------------
+
+void RenderPool::job(int idx)
+      {
+      DenormalGuard denormals;
+      if (idx == 0)
+            renderVoices(out, 0, false);
+      else
+            used[idx] = renderVoices(shareBuf[idx], idx, true);
+      }
+
+//---------------------------------------------------------
+//   process
+//    render n voices into buf (left, right, reverb, chorus)
+//    and add the buffers of all other shares which got a
+//    voice. The voices are distributed in a fixed way and
+//    the buffers are added in share order, so the result
+//    does not depend on thread timing.
+//---------------------------------------------------------
+
+void RenderPool::process(Voice** v, int n, unsigned l, float** buf)
+      {
+      voices  = v;
+      nvoices = n;
+      len     = l;
+      out     = buf;
+
+      run();
+
+      for (int i = 1; i < threads(); ++i) {
+            if (!used[i])
+                  continue;
+            for (int k = 0; k < 4; ++k) {
+                  float* dst = buf[k];
+                  float* src = shareBuf[i][k];
+                  for (unsigned j = 0; j < len; ++j)
+                        dst[j] += src[j];
+                  }
+            }
+      }
+
+}
@@ -0,0 +1,64 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+#ifndef __FLUID_RENDER_H__
+#define __FLUID_RENDER_H__
+
+#include "msynth/workerpool.h"
+
+namespace FluidS {
+
+class Voice;
+
+//---------------------------------------------------------
+//   RenderPool
+//    Renders the voices of one block on a few worker
+//    threads together with the calling (audio) thread.
+//    Share i renders every threads()-th voice starting at
+//    voice i; share 0 into the output buffers, the others
+//    into their own left/right/reverb/chorus buffers,
+//    which are added to the output buffers in share order.
+//    Which thread runs a share does not matter, so for a
+//    given number of threads the output is bit identical
+//    from run to run.
+//---------------------------------------------------------
+
+class RenderPool : public WorkerPool {
+      float* (*shareBuf)[4];        // buffers of share i, 0 is unused
+      bool* used;                   // share i rendered into its buffers
+
+      // the current job:
+      Voice** voices;
+      int nvoices;
+      unsigned len;
+      float** out;
+
+      bool renderVoices(float** buf, int idx, bool clear);
+      virtual void job(int idx);
+
+   public:
+      RenderPool(int threads);
+      ~RenderPool();
+      void process(Voice** voices, int n, unsigned len, float** buf);
+      };
+
+}
+
+#endif
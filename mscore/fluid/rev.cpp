@@ -9,6 +9,7 @@
   Further modified by Werner Schweer, 2009
 */
 
+#include "config.h"
 #include "rev.h"
 #include "fluid.h"
 
@@ -16,6 +17,8 @@ namespace FluidS {
 
 #define DC_OFFSET 1e-8
 
+CombKernel Reverb::combs = combs_scalar;
+
 static ReverbPreset revmodel_preset[] = {
       // name           roomsize       damp      width        level
       { "Default",         0.5f,      0.5f,       1.0f,       0.2f },
@@ -47,26 +50,108 @@ void Allpass::init()
             buffer[i] = DC_OFFSET;  // this is not 100 % correct.
       }
 
-void Comb::setbuffer(int size)
+//---------------------------------------------------------
+//   process
+//    run n samples of buf through the allpass in place.
+//    A segment which does not wrap the delay line touches
+//    every buffer position at most once, so there is no
+//    dependency between the samples of a segment.
+//---------------------------------------------------------
+
+void Allpass::process(int n, float* buf)
       {
-      filterstore = 0;
-      bufidx      = 0;
-      buffer      = new float[size];
-      bufsize     = size;
+      while (n) {
+            int seg = qMin(n, bufsize - bufidx);
+            float* p = buffer + bufidx;
+            for (int k = 0; k < seg; ++k) {
+                  float bufout = p[k];
+                  float input  = buf[k];
+                  buf[k] = bufout - input;
+                  p[k]   = input + (bufout * feedback);
+                  }
+            buf    += seg;
+            n      -= seg;
+            bufidx += seg;
+            if (bufidx >= bufsize)
+                  bufidx = 0;
+            }
       }
 
-void Comb::init()
+//---------------------------------------------------------
+//   CombBank
+//---------------------------------------------------------
+
+void CombBank::setbuffer(int lane, int size)
       {
-      for (int i = 0; i < bufsize; i++)
-            buffer[i] = DC_OFFSET;  // This is not 100 % correct.
+      filterstore[lane] = 0;
+      bufidx[lane]      = 0;
+      buffer[lane]      = new float[size];
+      bufsize[lane]     = size;
       }
 
-void Comb::setdamp(float val)
+void CombBank::init()
+      {
+      for (int c = 0; c < numcomblanes; ++c) {
+            for (int i = 0; i < bufsize[c]; i++)
+                  buffer[c][i] = DC_OFFSET;  // This is not 100 % correct.
+            }
+      }
+
+void CombBank::setdamp(float val)
       {
       damp1 = val;
       damp2 = 1 - val;
       }
 
+//---------------------------------------------------------
+//   process
+//    split n samples into segments where no delay line
+//    wraps and run the comb kernel on them
+//---------------------------------------------------------
+
+void CombBank::process(int n, const float* input, float* outL, float* outR)
+      {
+      while (n) {
+            int seg = n;
+            for (int c = 0; c < numcomblanes; ++c)
+                  seg = qMin(seg, bufsize[c] - bufidx[c]);
+            Reverb::combs(this, seg, input, outL, outR);
+            for (int c = 0; c < numcomblanes; ++c) {
+                  bufidx[c] += seg;
+                  if (bufidx[c] >= bufsize[c])
+                        bufidx[c] = 0;
+                  }
+            input += seg;
+            outL  += seg;
+            outR  += seg;
+            n     -= seg;
+            }
+      }
+
+//---------------------------------------------------------
+//   combs_scalar
+//    the sum over the combs is built in the same order as
+//    in the original per sample Freeverb loop
+//---------------------------------------------------------
+
+void combs_scalar(CombBank* cb, int n, const float* input, float* outL, float* outR)
+      {
+      for (int k = 0; k < n; ++k)
+            outL[k] = outR[k] = 0.0f;
+      for (int c = 0; c < numcomblanes; ++c) {
+            float* p   = cb->buffer[c] + cb->bufidx[c];
+            float* out = c < numcombs ? outL : outR;
+            float fs   = cb->filterstore[c];
+            for (int k = 0; k < n; ++k) {
+                  float tmp = p[k];
+                  fs        = (tmp * cb->damp2) + (fs * cb->damp1);
+                  p[k]      = input[k] + (fs * cb->feedback);
+                  out[k]   += tmp;
+                  }
+            cb->filterstore[c] = fs;
+            }
+      }
+
 static const int stereospread = 23;
 
 /*
@@ -91,8 +176,8 @@ static const int allpasstuning[] = {
 Reverb::Reverb()
       {
       for (int i = 0; i < numcombs; ++i) {
-            combL[i].setbuffer(combtuning[i]);
-            combR[i].setbuffer(combtuning[i] + stereospread);
+            comb.setbuffer(i, combtuning[i]);
+            comb.setbuffer(i + numcombs, combtuning[i] + stereospread);
             }
 
       for (int i = 0; i < numallpasses; ++i) {
@@ -113,18 +198,31 @@ Reverb::Reverb()
 
 void Reverb::init()
       {
-      for (int i = 0; i < numcombs; i++) {
-            combL[i].init();
-            combR[i].init();
-            }
+      comb.init();
       for (int i = 0; i < numallpasses; i++) {
             allpassL[i].init();
             allpassR[i].init();
             }
       }
 
+//---------------------------------------------------------
+//   config
+//    select the comb kernel for this cpu
+//---------------------------------------------------------
+
+void Reverb::config()
+      {
+#ifdef FLUID_SIMD
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("sse2"))
+            combs = combs_sse2;
+#endif
+      }
+
 //---------------------------------------------------------
 //   process
+//    The comb bank and the allpass chain are run one
+//    after the other over blocks of BLOCK samples.
 //---------------------------------------------------------
 
 void Reverb::process(int n, float* in, float* l, float* r)
@@ -137,28 +235,34 @@ void Reverb::process(int n, float* in, float* l, float* r)
             update();
             parameterChanged = false;
             }
-      for (int k = 0; k < n; k++) {
-            float outL = 0.0;
-            float outR = 0.0;
+      float input[BLOCK];
+      float outL[BLOCK];
+      float outR[BLOCK];
 
-            float input = (in[k] * 2.0 + DC_OFFSET) * gain;
+      for (int i = 0; i < n; i += BLOCK) {
+            int m = qMin(int(BLOCK), n - i);
 
-            for (int i = 0; i < numcombs; i++) {      // Accumulate comb filters in parallel
-                  outL += combL[i].process(input);
-                  outR += combR[i].process(input);
-                  }
-            for (int i = 0; i < numallpasses; i++) {  // Feed through allpasses in series
-                  outL = allpassL[i].process(outL);
-                  outR = allpassR[i].process(outR);
+            for (int k = 0; k < m; k++)
+                  input[k] = (in[i + k] * 2.0 + DC_OFFSET) * gain;
+
+            comb.process(m, input, outL, outR);       // Accumulate comb filters in parallel
+
+            for (int k = 0; k < numallpasses; k++) {  // Feed through allpasses in series
+                  allpassL[k].process(m, outL);
+                  allpassR[k].process(m, outR);
                   }
 
-            /* Remove the DC offset */
-            outL -= DC_OFFSET;
-            outR -= DC_OFFSET;
+            float* lo = l + i;
+            float* ro = r + i;
+            for (int k = 0; k < m; k++) {
+                  /* Remove the DC offset */
+                  float oL = outL[k] - DC_OFFSET;
+                  float oR = outR[k] - DC_OFFSET;
 
-            /* Calculate output MIXING with anything already there */
-            l[k] += outL * wet1 + outR * wet2;
-            r[k] += outR * wet1 + outL * wet2;
+                  /* Calculate output MIXING with anything already there */
+                  lo[k] += oL * wet1 + oR * wet2;
+                  ro[k] += oR * wet1 + oL * wet2;
+                  }
             }
       }
 
@@ -172,14 +276,8 @@ void Reverb::update()
       wet1 = wet * (width * .5 + 0.5f);
       wet2 = wet * ((1.0 - width) * .5);
 
-      for (int i = 0; i < numcombs; i++) {
-            combL[i].setfeedback(roomsize);
-            combR[i].setfeedback(roomsize);
-            }
-      for (int i = 0; i < numcombs; i++) {
-            combL[i].setdamp(damp);
-            combR[i].setdamp(damp);
-            }
+      comb.setfeedback(roomsize);
+      comb.setdamp(damp);
       }
 
 //---------------------------------------------------------
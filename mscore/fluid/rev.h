@@ -42,48 +42,46 @@ class Allpass {
       void init();
       void setfeedback(float val) { feedback = val;  }
       float getfeedback() const   { return feedback; }
-
-      float process(float _input) {
-            float bufout = buffer[bufidx];
-            float output = bufout - _input;
-            buffer[bufidx] = _input + (bufout * feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-            return output;
-            }
+      void process(int n, float* buf);
       };
 
 //---------------------------------------------------------
-//   Comb
+//   CombBank
+//    the comb filters of both channels as structure
+//    of arrays; lanes 0 - 7 are the left, lanes 8 - 15
+//    the right channel. All combs share feedback and
+//    damping.
 //---------------------------------------------------------
 
-class Comb {
+static const int numcomblanes = numcombs * 2;
+
+struct CombBank {
+      float filterstore[numcomblanes] __attribute__ ((aligned (16)));
+      float* buffer[numcomblanes];
+      int bufsize[numcomblanes];
+      int bufidx[numcomblanes];
       float feedback;
-      float filterstore;
       float damp1;
       float damp2;
-      float *buffer;
-      int bufsize;
-      int bufidx;
 
-   public:
-      void setbuffer(int size);
+      void setbuffer(int lane, int size);
       void init();
       void setdamp(float val);
-      float getdamp() const       { return damp1;    }
       void setfeedback(float val) { feedback = val;  }
-      float getfeedback() const   { return feedback; }
-
-      float process(float input) {
-            float tmp = buffer[bufidx];
-            filterstore      = (tmp * damp2) + (filterstore * damp1);
-            buffer[bufidx]   = input + (filterstore * feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-            return tmp;
-            }
+      void process(int n, const float* input, float* outL, float* outR);
       };
 
+//---------------------------------------------------------
+//   comb kernels
+//    run all combs over n samples without wrapping a
+//    delay line; outL/outR are overwritten
+//---------------------------------------------------------
+
+typedef void (*CombKernel)(CombBank*, int n, const float* input, float* outL, float* outR);
+
+extern void combs_scalar(CombBank*, int, const float*, float*, float*);
+extern void combs_sse2(CombBank*, int, const float*, float*, float*);
+
 static const float scaleroom  = 0.28f;
 static const float offsetroom = 0.7f;
 static const float scalewet   = 3.0f;
@@ -94,6 +92,8 @@ static const float scaledamp  = 0.4f;
 //---------------------------------------------------------
 
 class Reverb {
+      static const int BLOCK = 64;        // process() works in blocks of this size
+
       void init();
       void update();
 
@@ -115,13 +115,15 @@ class Reverb {
        with its subsequent error-checking messiness
        */
 
-      Comb combL[numcombs];
-      Comb combR[numcombs];
+      CombBank comb;
 
       Allpass allpassL[numallpasses];
       Allpass allpassR[numallpasses];
 
    public:
+      static CombKernel combs;            // selected at runtime by config()
+      static void config();
+
       Reverb();
       void process(int n, float* in, float* left_out, float* right_out);
 
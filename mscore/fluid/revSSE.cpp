@@ -0,0 +1,98 @@
+/*
+  Freeverb
+
+  Written by Jezar at Dreampoint, June 2000
+  http://www.dreampoint.co.uk
+  This code is public domain
+
+  Translated to C by Peter Hanappe, Mai 2001
+  Further modified by Werner Schweer, 2009
+*/
+
+//
+//    SSE2 version of the comb bank, compiled with -msse2,
+//    selected at runtime in Reverb::config()
+//
+//    Four combs are processed as the four lanes of a
+//    register. Four samples of every comb are loaded,
+//    transposed to get one register per sample, run
+//    through the filter and transposed back. The output
+//    is bit identical to combs_scalar().
+//
+
+#include <emmintrin.h>
+#include "rev.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   combs_sse2
+//---------------------------------------------------------
+
+void combs_sse2(CombBank* cb, int n, const float* input, float* outL, float* outR)
+      {
+      for (int k = 0; k < n; ++k)
+            outL[k] = outR[k] = 0.0f;
+
+      const __m128 d1 = _mm_set1_ps(cb->damp1);
+      const __m128 d2 = _mm_set1_ps(cb->damp2);
+      const __m128 fb = _mm_set1_ps(cb->feedback);
+
+      for (int g = 0; g < numcomblanes; g += 4) {
+            float* out = g < numcombs ? outL : outR;
+            float* p0  = cb->buffer[g]     + cb->bufidx[g];
+            float* p1  = cb->buffer[g + 1] + cb->bufidx[g + 1];
+            float* p2  = cb->buffer[g + 2] + cb->bufidx[g + 2];
+            float* p3  = cb->buffer[g + 3] + cb->bufidx[g + 3];
+            __m128 fs  = _mm_load_ps(cb->filterstore + g);
+            int k      = 0;
+
+            for (; k + 4 <= n; k += 4) {
+                  __m128 r0 = _mm_loadu_ps(p0 + k);
+                  __m128 r1 = _mm_loadu_ps(p1 + k);
+                  __m128 r2 = _mm_loadu_ps(p2 + k);
+                  __m128 r3 = _mm_loadu_ps(p3 + k);
+
+                  // sum the combs in the same order as the scalar code
+                  __m128 o = _mm_loadu_ps(out + k);
+                  o = _mm_add_ps(o, r0);
+                  o = _mm_add_ps(o, r1);
+                  o = _mm_add_ps(o, r2);
+                  o = _mm_add_ps(o, r3);
+                  _mm_storeu_ps(out + k, o);
+
+                  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                  fs = _mm_add_ps(_mm_mul_ps(r0, d2), _mm_mul_ps(fs, d1));
+                  r0 = _mm_add_ps(_mm_set1_ps(input[k]), _mm_mul_ps(fs, fb));
+                  fs = _mm_add_ps(_mm_mul_ps(r1, d2), _mm_mul_ps(fs, d1));
+                  r1 = _mm_add_ps(_mm_set1_ps(input[k + 1]), _mm_mul_ps(fs, fb));
+                  fs = _mm_add_ps(_mm_mul_ps(r2, d2), _mm_mul_ps(fs, d1));
+                  r2 = _mm_add_ps(_mm_set1_ps(input[k + 2]), _mm_mul_ps(fs, fb));
+                  fs = _mm_add_ps(_mm_mul_ps(r3, d2), _mm_mul_ps(fs, d1));
+                  r3 = _mm_add_ps(_mm_set1_ps(input[k + 3]), _mm_mul_ps(fs, fb));
+                  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+                  _mm_storeu_ps(p0 + k, r0);
+                  _mm_storeu_ps(p1 + k, r1);
+                  _mm_storeu_ps(p2 + k, r2);
+                  _mm_storeu_ps(p3 + k, r3);
+                  }
+            _mm_store_ps(cb->filterstore + g, fs);
+
+            if (k < n) {
+                  for (int c = g; c < g + 4; ++c) {
+                        float* p = cb->buffer[c] + cb->bufidx[c];
+                        float f  = cb->filterstore[c];
+                        for (int i = k; i < n; ++i) {
+                              float tmp = p[i];
+                              f         = (tmp * cb->damp2) + (f * cb->damp1);
+                              p[i]      = input[i] + (f * cb->feedback);
+                              out[i]   += tmp;
+                              }
+                        cb->filterstore[c] = f;
+                        }
+                  }
+            }
+      }
+
+}
@@ -45,19 +45,30 @@ SFVersion::SFVersion()
 
 //---------------------------------------------------------
 //   SFont
+//    soundfont ids are unique in the process as soundfonts
+//    are shared between synthesizers
 //---------------------------------------------------------
 
+static QAtomicInt sfontIds;
+QString SFont::pcmCacheDir;
+
 SFont::SFont(Fluid* f)
       {
-      synth      = f;
-      samplepos  = 0;
-      samplesize = 0;
+      synth       = f;
+      samplepos   = 0;
+      samplesize  = 0;
+      _sampleData = 0;
+      _pcmCache   = 0;
+      _id         = sfontIds.fetchAndAddRelaxed(1) + 1;
       }
 
 SFont::~SFont()
       {
       foreach(Sample* s, sample)
             delete s;
+#ifdef SOUNDFONT3
+      delete _pcmCache;
+#endif
       foreach(Preset* p, presets)
             delete p;
       foreach(unsigned char* p, infos)
@@ -69,6 +80,98 @@ SFont::~SFont()
             }
       }
 
+//---------------------------------------------------------
+//   SFontCache
+//    All soundfonts of the process, keyed by canonical
+//    path and modification time. A soundfont is parsed
+//    once and shared by every Fluid instance; after
+//    parsing it is only changed by loading sample data,
+//    which is serialized by SFont::loadMutex.
+//    Up to MAX_UNUSED soundfonts without a user are kept,
+//    so that exports and batch conversions which create
+//    and destroy synthesizers do not load them again.
+//---------------------------------------------------------
+
+struct SFontCacheEntry {
+      SFont* sf;
+      int refs;
+      int lastUse;
+      };
+
+static const int MAX_UNUSED = 2;
+static QMutex cacheMutex;
+static QHash<QString, SFontCacheEntry> sfontCache;
+static int cacheClock;
+
+//---------------------------------------------------------
+//   acquire
+//    return the soundfont for path; it is loaded if it is
+//    not in the cache. Returns 0 on error.
+//---------------------------------------------------------
+
+SFont* SFont::acquire(Fluid* synth, const QString& path)
+      {
+      QFileInfo fi(path);
+      if (!fi.exists())
+            return 0;
+      QString key = fi.canonicalFilePath() + QString(":%1").arg(fi.lastModified().toTime_t());
+
+      QMutexLocker locker(&cacheMutex);
+      QHash<QString, SFontCacheEntry>::iterator i = sfontCache.find(key);
+      if (i != sfontCache.end()) {
+            i->refs++;
+            return i->sf;
+            }
+      SFont* sf = new SFont(synth);
+      if (!sf->read(path)) {
+            delete sf;
+            return 0;
+            }
+      SFontCacheEntry e;
+      e.sf      = sf;
+      e.refs    = 1;
+      e.lastUse = ++cacheClock;
+      sfontCache.insert(key, e);
+      return sf;
+      }
+
+//---------------------------------------------------------
+//   release
+//---------------------------------------------------------
+
+void SFont::release(SFont* sf)
+      {
+      QMutexLocker locker(&cacheMutex);
+      int unused = 0;
+      QHash<QString, SFontCacheEntry>::iterator oldest = sfontCache.end();
+      for (QHash<QString, SFontCacheEntry>::iterator i = sfontCache.begin(); i != sfontCache.end(); ++i) {
+            if (i->sf == sf) {
+                  i->refs--;
+                  i->lastUse = ++cacheClock;
+                  }
+            if (i->refs == 0) {
+                  ++unused;
+                  if (oldest == sfontCache.end() || i->lastUse < oldest->lastUse)
+                        oldest = i;
+                  }
+            }
+      if (unused > MAX_UNUSED) {
+            delete oldest->sf;
+            sfontCache.erase(oldest);
+            }
+      }
+
+//---------------------------------------------------------
+//   setPcmCacheDir
+//    decoded samples of sf3 soundfonts are kept in this
+//    directory; an empty path disables the cache
+//---------------------------------------------------------
+
+void SFont::setPcmCacheDir(const QString& path)
+      {
+      pcmCacheDir = path;
+      }
+
 //---------------------------------------------------------
 //   read
 //---------------------------------------------------------
@@ -79,6 +182,17 @@ bool SFont::read(const QString& s)
       if (!load())
             return false;
 
+      //
+      // map the sample data; if this fails the samples
+      // are read from the file
+      //
+      mapFile.setFileName(s);
+      if (samplesize && mapFile.open(QIODevice::ReadOnly))
+            _sampleData = mapFile.map(samplepos, samplesize);
+#ifdef SOUNDFONT3
+      openPcmCache();
+#endif
+
       foreach(Instrument* i, instruments) {
             if (!i->import_sfont())
                   return false;
@@ -129,29 +243,123 @@ Preset::~Preset()
 
 //---------------------------------------------------------
 //   loadSamples
-//    this is called if the preset is associated with a
-//    channel
+//    this is called by the SampleLoader if the preset is
+//    associated with a channel
 //---------------------------------------------------------
 
+static void addSample(QList<Sample*>* sl, Sample* s)
+      {
+      if (s && !sl->contains(s))
+            sl->append(s);
+      }
+
 void Preset::loadSamples()
       {
-//      sfont->synth->mutex.lock();
+      QMutexLocker locker(&sfont->loadMutex);
+      QList<Sample*> sl;
       if (_global_zone && _global_zone->instrument) {
             Instrument* i = _global_zone->instrument;
-            if (i->global_zone && i->global_zone->sample)
-                  i->global_zone->sample->load();
+            if (i->global_zone)
+                  addSample(&sl, i->global_zone->sample);
             foreach(Zone* iz, i->zones)
-                  iz->sample->load();
+                  addSample(&sl, iz->sample);
             }
 
       foreach(Zone* z, zones) {
             Instrument* i = z->instrument;
-            if (i->global_zone && i->global_zone->sample)
-                  i->global_zone->sample->load();
+            if (i->global_zone)
+                  addSample(&sl, i->global_zone->sample);
             foreach(Zone* iz, i->zones)
-                  iz->sample->load();
+                  addSample(&sl, iz->sample);
             }
-//      sfont->synth->mutex.unlock();
+      Sample::load(sl);
+      }
+
+//---------------------------------------------------------
+//   SampleLoader
+//---------------------------------------------------------
+
+SampleLoader::SampleLoader(Fluid* f)
+   : mutex(QMutex::Recursive)
+      {
+      synth    = f;
+      quitFlag = false;
+      }
+
+//---------------------------------------------------------
+//   load
+//    queue loading of the samples of preset p
+//    can be called from the audio thread; takes no lock,
+//    the loader polls the fifo
+//---------------------------------------------------------
+
+bool SampleLoader::load(Preset* p)
+      {
+      FluidCmd c;
+      c.cmd  = FLUID_CMD_LOAD;
+      c.type = 0;
+      c.chan = p->sfont->id();
+      c.a    = p->get_banknum();
+      c.b    = p->get_num();
+      c.val  = 0.0;
+      return fifo.put(c);
+      }
+
+//---------------------------------------------------------
+//   stop
+//---------------------------------------------------------
+
+void SampleLoader::stop()
+      {
+      quitFlag = true;
+      wait();
+      }
+
+//---------------------------------------------------------
+//   run
+//    The preset is looked up again by soundfont id, bank
+//    and number; the soundfont may have been unloaded
+//    since the request was queued. The fifo is polled
+//    every POLL_MS while it is empty.
+//---------------------------------------------------------
+
+void SampleLoader::run()
+      {
+      while (!quitFlag) {
+            FluidCmd c;
+            if (!fifo.get(&c)) {
+                  msleep(POLL_MS);
+                  continue;
+                  }
+            mutex.lock();
+            SFont* sf = synth->get_sfont_by_id(c.chan);
+            Preset* p = sf ? sf->get_preset(c.a, c.b) : 0;
+            if (p)
+                  p->loadSamples();
+            mutex.unlock();
+            }
+      }
+
+//---------------------------------------------------------
+//   resident
+//    true if the samples of all zones which play key and
+//    vel are loaded
+//---------------------------------------------------------
+
+bool Preset::resident(int key, int vel)
+      {
+      foreach (Zone* preset_zone, zones) {
+            if (!preset_zone->inside_range(key, vel))
+                  continue;
+            foreach (Zone* inst_zone, preset_zone->get_inst()->get_zone()) {
+                  Sample* sample = inst_zone->get_sample();
+                  if (sample == 0 || sample->inRom())
+                        continue;
+                  if (inst_zone->inside_range(key, vel) && !sample->loaded())
+                        return false;
+                  }
+            }
+      return true;
       }
 
 //---------------------------------------------------------
@@ -180,6 +388,10 @@ bool Preset::noteon(Fluid* synth, unsigned id, int chan, int key, int vel, doubl
                         Sample* sample = inst_zone->get_sample();
                         if (sample == 0 || sample->inRom())
                               continue;
+                        /* the sample data is not yet resident; Fluid::playEvent()
+                           defers such notes, see resident() */
+                        if (!sample->loaded())
+                              continue;
                         /* check if the note falls into the key and velocity range of this
                            instrument */
                         if (inst_zone->inside_range(key, vel) && (sample != 0)) {
@@ -583,7 +795,9 @@ Sample::Sample(SFont* s)
       origpitch   = 0;
       pitchadj    = 0;
       sampletype  = 0;
+      index       = 0;
       data        = 0;
+      ownData     = true;
       amplitude_that_reaches_noise_floor_is_valid = false;
       amplitude_that_reaches_noise_floor = 0.0;
       }
@@ -594,58 +808,124 @@ Sample::Sample(SFont* s)
 
 Sample::~Sample()
       {
-      delete[] data;
+      if (ownData)
+            delete[] data;
       }
 
 //---------------------------------------------------------
 //   load
+//    load a list of samples; compressed samples are
+//    decoded in parallel
 //---------------------------------------------------------
 
-void Sample::load()
+void Sample::load(const QList<Sample*>& sl)
+      {
+#ifdef SOUNDFONT3
+      QList<Sample*> compressed;
+      foreach(Sample* s, sl) {
+            if (s->sampletype & FLUID_SAMPLETYPE_OGG_VORBIS)
+                  compressed.append(s);
+            else
+                  s->load();
+            }
+      if (!compressed.isEmpty())
+            decode(compressed);
+#else
+      foreach(Sample* s, sl)
+            s->load();
+#endif
+      }
+
+//---------------------------------------------------------
+//   readFile
+//    read size bytes at offset into the sample chunk
+//---------------------------------------------------------
+
+bool Sample::readFile(char* buf, unsigned offset, unsigned size)
       {
-      if (!_valid || data)
-            return;
       QFile fd(sf->get_name());
       if (!fd.open(QIODevice::ReadOnly))
-            return;
-      if (sampletype & FLUID_SAMPLETYPE_OGG_VORBIS) {
-            if (!fd.seek(sf->samplePos() + start))
-                  return;
-            }
-      else {
-            if (!fd.seek(sf->samplePos() + start * sizeof(short)))
-                  return;
+            return false;
+      if (!fd.seek(sf->samplePos() + offset))
+            return false;
+      if (fd.read(buf, size) != size) {
+            printf("  read %d failed\n", size);
+            return false;
             }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   load
+//    called from the SampleLoader thread. 16 bit samples
+//    on little endian machines are played directly from
+//    the mapped sample chunk.
+//---------------------------------------------------------
+
+void Sample::load()
+      {
+      if (!_valid || data)
+            return;
+      const uchar* smpl = sf->sampleData();
       unsigned int size = end - start;
 
       if (sampletype & FLUID_SAMPLETYPE_OGG_VORBIS) {
 #ifdef SOUNDFONT3
-            char* p = new char[size];
-            if (fd.read(p, size) != size) {
-                  printf("  read %d failed\n", size);
-                  return;
+            PcmCache* cache = sf->pcmCache();
+            if (!cache || !cache->lookup(this)) {
+                  if (smpl && start + size <= sf->getSamplesize())
+                        decompressOggVorbis((const char*)smpl + start, size);
+                  else {
+                        char* p = new char[size];
+                        if (readFile(p, start, size))
+                              decompressOggVorbis(p, size);
+                        delete[] p;
+                        }
+                  if (!data)
+                        return;
+                  if (cache && _valid)
+                        cache->store(this);
                   }
-            decompressOggVorbis(p, size);
-            delete[] p;
+#else
+            return;
 #endif
             }
       else {
-            data = new short[size];
-            size *= sizeof(short);
-
-            if (fd.read((char*)data, size) != size)
-                  return;
-
-            if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
-                  unsigned char hi, lo;
-                  unsigned int i, j;
-                  short s;
-                  uchar* cbuf = (uchar*) data;
-                  for (i = 0, j = 0; j < size; i++) {
-                        lo = cbuf[j++];
-                        hi = cbuf[j++];
-                        s = (hi << 8) | lo;
-                        data[i] = s;
+            unsigned offset = start * sizeof(short);
+            unsigned bytes  = size * sizeof(short);
+            bool mapped     = smpl && (offset + bytes <= sf->getSamplesize());
+
+            if (mapped && QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
+                  data    = (short*)(smpl + offset);
+                  ownData = false;
+                  // fault in all pages now, the audio thread
+                  // must not wait for the disk
+                  volatile short sink = 0;
+                  for (unsigned i = 0; i < size; i += 2048)
+                        sink = data[i];
+                  (void)sink;
+                  }
+            else {
+                  data    = new short[size];
+                  ownData = true;
+                  if (mapped)
+                        memcpy(data, smpl + offset, bytes);
+                  else if (!readFile((char*)data, offset, bytes)) {
+                        delete[] data;
+                        data = 0;
+                        return;
+                        }
+                  if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
+                        unsigned char hi, lo;
+                        unsigned int i, j;
+                        short s;
+                        uchar* cbuf = (uchar*) data;
+                        for (i = 0, j = 0; j < bytes; i++) {
+                              lo = cbuf[j++];
+                              hi = cbuf[j++];
+                              s = (hi << 8) | lo;
+                              data[i] = s;
+                              }
                         }
                   }
             end       -= (start + 1);       // marks last sample, contrary to SF spec.
@@ -654,6 +934,7 @@ void Sample::load()
             start      = 0;
             }
       optimize();
+      _loaded.fetchAndStoreRelease(1);
       }
 
 //---------------------------------------------------------
@@ -1591,6 +1872,7 @@ void SFont::load_shdr (int size)
       /* load all sample headers */
       for (int i = 0; i < size; i++) {
             Sample* p = new Sample(this);
+            p->index = sample.size();
             sample.append(p);
             char buffer[21];
             READSTR (buffer);
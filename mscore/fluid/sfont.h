@@ -31,6 +31,7 @@ namespace FluidS {
 class Preset;
 class Sample;
 class Instrument;
+class PcmCache;
 struct SFGen;
 struct SFMod;
 
@@ -50,10 +51,13 @@ struct SFVersion {            // version structure
 //---------------------------------------------------------
 
 class SFont {
-      Fluid* synth;
+      Fluid* synth;                 // the synth which loaded the soundfont, only used while reading
       QFile f;
       unsigned samplepos;           // the position in the file at which the sample data starts
       unsigned samplesize;          // the size of the sample data
+      QFile mapFile;                // keeps the smpl chunk mapped
+      uchar* _sampleData;           // the mapped smpl chunk or 0
+      PcmCache* _pcmCache;          // decoded sf3 samples on disk or 0
 
       QList<Instrument*> instruments;
       QList<Preset*> presets;
@@ -97,9 +101,19 @@ class SFont {
       void safe_fseek(long ofs);
       bool load();
 
-   public:
+      static QString pcmCacheDir;
+
       SFont(Fluid* f);
       virtual ~SFont();
+#ifdef SOUNDFONT3
+      void openPcmCache();
+#endif
+
+   public:
+      QMutex loadMutex;             // serializes sample loading of all synths
+
+      static SFont* acquire(Fluid*, const QString& path);
+      static void release(SFont*);
 
       QString get_name()  const                 { return f.fileName(); }
       Preset* get_preset(int bank, int prenum);
@@ -109,10 +123,12 @@ class SFont {
       int load_sampledata();
       unsigned int samplePos() const            { return samplepos;  }
       int id() const                            { return _id; }
-      void setId(int i)                         { _id = i;    }
       void setSamplepos(unsigned v)             { samplepos = v; }
       void setSamplesize(unsigned v)            { samplesize = v; }
       unsigned getSamplesize() const            { return samplesize; }
+      const uchar* sampleData() const           { return _sampleData; }
+      PcmCache* pcmCache() const                { return _pcmCache; }
+      static void setPcmCacheDir(const QString&);
       const QList<Preset*> getPresets() const   { return presets; }
       SFVersion version() const                 { return _version; }
       friend class Preset;
@@ -124,6 +140,10 @@ class SFont {
 
 class Sample {
       bool _valid;
+      bool ownData;                 // data is not part of the mapped smpl chunk
+      QAtomicInt _loaded;           // set by the loader thread when data is resident
+
+      bool readFile(char* buf, unsigned offset, unsigned size);
 
    public:
       SFont* sf;
@@ -135,6 +155,7 @@ class Sample {
       int origpitch;
       int pitchadj;
       int sampletype;
+      int index;                    // position in the sample header list
 
       short* data;
 
@@ -152,12 +173,44 @@ class Sample {
       bool inRom() const;
       void optimize();
       void load();
+      static void load(const QList<Sample*>&);
+      bool loaded()         { return _loaded.fetchAndAddAcquire(0); }
       bool valid() const    { return _valid; }
       void setValid(bool v) { _valid = v; }
 #ifdef SOUNDFONT3
-      bool decompressOggVorbis(char* p, int size);
+      bool decompressOggVorbis(const char* p, int size);
+      static void decode(const QList<Sample*>&);
 #endif
+      friend class PcmCache;
+      };
+
+#ifdef SOUNDFONT3
+//---------------------------------------------------------
+//   PcmCache
+//    decoded samples of a sf3 soundfont in a file; the
+//    file is mapped and new samples are appended
+//---------------------------------------------------------
+
+class PcmCache {
+      struct Record {
+            quint32 magic;
+            qint32 sample;          // sample index
+            quint32 frames;
+            quint32 loopstart;
+            quint32 loopend;
+            };                      // followed by frames 16 bit samples
+
+      QFile file;
+      uchar* map;
+      QHash<int, const Record*> records;
+      QMutex mutex;                 // store() is called from the decoder threads
+
+   public:
+      PcmCache(const QString& path);
+      bool lookup(Sample*);
+      void store(const Sample*);
       };
+#endif
 
 //---------------------------------------------------------
 //   Zone
@@ -227,6 +280,7 @@ class Preset {
       int get_banknum() const                   { return bank; }
       int get_num() const                       { return num;  }
       bool noteon(Fluid*, unsigned id, int chan, int key, int vel, double nt);
+      bool resident(int key, int vel);
 
       void setGlobalZone(Zone* z)               { _global_zone = z;   }
       bool importSfont();
@@ -236,6 +290,30 @@ class Preset {
       QList<Zone*> getZones()                   { return zones; }
       };
 
+//---------------------------------------------------------
+//   SampleLoader
+//    loads the samples of presets in the background;
+//    requests come from the audio thread through a
+//    lock free fifo, which the loader polls
+//---------------------------------------------------------
+
+class SampleLoader : public QThread {
+      Fluid* synth;
+      static const int POLL_MS = 5;       // the audio thread does not wake the loader
+
+      FluidCmdFifo fifo;
+      volatile bool quitFlag;
+
+      virtual void run();
+
+   public:
+      QMutex mutex;                 // held while loading and while soundfonts change
+
+      SampleLoader(Fluid*);
+      bool load(Preset*);           // returns false if the request cannot be queued
+      void stop();
+      };
+
 //---------------------------------------------------------
 //   SFChunk
 //---------------------------------------------------------
@@ -10,11 +10,13 @@ namespace FluidS {
 //   decompressOggVorbis
 //---------------------------------------------------------
 
-bool Sample::decompressOggVorbis(char* src, int size)
+bool Sample::decompressOggVorbis(const char* src, int size)
       {
 #define MAX_OUT   1024*500
-      short odata[MAX_OUT];
-      short* oPtr = odata;
+      // on the heap: this runs on decoder threads with small stacks
+      QScopedArrayPointer<short> obuf(new short[MAX_OUT]);
+      short* odata = obuf.data();
+      short* oPtr  = odata;
 
       ogg_sync_state   oy; // sync and verify incoming physical bitstream
       ogg_stream_state os; // take physical pages, weld into a logical stream of packets
@@ -213,4 +215,155 @@ bool Sample::decompressOggVorbis(char* src, int size)
 // printf("  vorbis sample 0-%d %d %d\n", end, loopstart, loopend);
       return true;
       }
+
+//---------------------------------------------------------
+//   SampleDecoder
+//---------------------------------------------------------
+
+class SampleDecoder : public QRunnable {
+      Sample* sample;
+      QSemaphore* done;
+
+   public:
+      SampleDecoder(Sample* s, QSemaphore* d) : sample(s), done(d) {}
+      virtual void run() {
+            sample->load();
+            done->release();
+            }
+      };
+
+//---------------------------------------------------------
+//   decode
+//    decode compressed samples on the global thread pool
+//    and wait until all are done
+//---------------------------------------------------------
+
+void Sample::decode(const QList<Sample*>& sl)
+      {
+      QSemaphore done;
+      int n = 0;
+      foreach(Sample* s, sl) {
+            if (!s->valid() || s->data)
+                  continue;
+            QThreadPool::globalInstance()->start(new SampleDecoder(s, &done));
+            ++n;
+            }
+      done.acquire(n);
+      }
+
+//---------------------------------------------------------
+//   openPcmCache
+//    the cache file is named after a hash of path, size
+//    and modification time of the soundfont
+//---------------------------------------------------------
+
+void SFont::openPcmCache()
+      {
+      if (pcmCacheDir.isEmpty())
+            return;
+      bool compressed = false;
+      foreach(Sample* s, sample) {
+            if (s->sampletype & FLUID_SAMPLETYPE_OGG_VORBIS) {
+                  compressed = true;
+                  break;
+                  }
+            }
+      if (!compressed)
+            return;
+      QFileInfo fi(f.fileName());
+      QCryptographicHash h(QCryptographicHash::Md5);
+      h.addData(fi.canonicalFilePath().toUtf8());
+      h.addData(QByteArray::number(fi.size()));
+      h.addData(QByteArray::number(fi.lastModified().toTime_t()));
+      h.addData(QByteArray::number(int(QSysInfo::ByteOrder)));
+      if (!QDir().mkpath(pcmCacheDir))
+            return;
+      _pcmCache = new PcmCache(pcmCacheDir + "/" + h.result().toHex() + ".pcm");
+      }
+
+//---------------------------------------------------------
+//   PcmCache
+//    map the cache file and index its records; a
+//    truncated record ends the scan
+//---------------------------------------------------------
+
+static const quint32 PCM_MAGIC = 0x4d435053;    // "SPCM"
+
+static qint64 recordSize(quint32 frames, int header)
+      {
+      return (header + qint64(frames) * sizeof(short) + 3) & ~3;
+      }
+
+PcmCache::PcmCache(const QString& path)
+      {
+      map = 0;
+      file.setFileName(path);
+      if (!file.open(QIODevice::ReadOnly))      // not yet created
+            return;
+      qint64 size = file.size();
+      if (size == 0)
+            return;
+      map = file.map(0, size);
+      if (!map)
+            return;
+      qint64 pos = 0;
+      while (pos + qint64(sizeof(Record)) <= size) {
+            const Record* r = (const Record*)(map + pos);
+            qint64 len = recordSize(r->frames, sizeof(Record));
+            if (r->magic != PCM_MAGIC || pos + len > size)
+                  break;
+            records.insert(r->sample, r);
+            pos += len;
+            }
+      }
+
+//---------------------------------------------------------
+//   lookup
+//    play sample s from the cache file if it was decoded
+//    in an earlier run
+//---------------------------------------------------------
+
+bool PcmCache::lookup(Sample* s)
+      {
+      const Record* r = records.value(s->index);
+      if (!r || r->frames < 8)
+            return false;
+      s->data      = (short*)(r + 1);
+      s->ownData   = false;
+      s->start     = 0;
+      s->end       = r->frames - 1;
+      s->loopstart = r->loopstart;
+      s->loopend   = r->loopend;
+
+      volatile short sink = 0;      // fault in the pages now
+      for (unsigned i = 0; i < r->frames; i += 2048)
+            sink = s->data[i];
+      (void)sink;
+      return true;
+      }
+
+//---------------------------------------------------------
+//   store
+//    append a decoded sample to the cache file; it is
+//    used from the next run on
+//---------------------------------------------------------
+
+void PcmCache::store(const Sample* s)
+      {
+      QMutexLocker locker(&mutex);
+      QFile out(file.fileName());
+      if (!out.open(QIODevice::WriteOnly | QIODevice::Append))
+            return;
+      Record r;
+      r.magic     = PCM_MAGIC;
+      r.sample    = s->index;
+      r.frames    = s->end + 1;
+      r.loopstart = s->loopstart;
+      r.loopend   = s->loopend;
+      QByteArray ba(int(recordSize(r.frames, sizeof(Record))), 0);
+      memcpy(ba.data(), &r, sizeof(Record));
+      memcpy(ba.data() + sizeof(Record), s->data, r.frames * sizeof(short));
+      out.write(ba);          // one write, so a record is never split
+      }
+
 } // namespace
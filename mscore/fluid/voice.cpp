@@ -18,6 +18,7 @@
  * 02111-1307, USA
  */
 
+#include "config.h"
 #include "conv.h"
 #include "fluid.h"
 #include "sfont.h"
@@ -63,6 +64,13 @@ Voice::Voice(Fluid* f)
       vel     = 0;
       channel = 0;
       sample  = 0;
+      activeIndex = -1;
+      listChannel = 0;
+      chanPrev  = chanNext = 0;
+      keyPrev   = keyNext  = 0;
+      heapIndex = -1;
+      heapState = 0;
+      heapPrio  = 0.0;
 
       /* The 'sustain' and 'finished' segments of the volume / modulation
        * envelope are constant. They are never affected by any modulator
@@ -1402,6 +1410,19 @@ void Voice::add_mod(const Mod* _mod, int mode)
             _mod->clone(&mod[mod_count++]);
       }
 
+//---------------------------------------------------------
+//   setMods
+//    replace the modulators of a voice by a table of
+//    valid modulators
+//---------------------------------------------------------
+
+void Voice::setMods(const Mod* m, int n)
+      {
+      Q_ASSERT(n <= FLUID_NUM_MOD);
+      memcpy(mod, m, n * sizeof(Mod));
+      mod_count = n;
+      }
+
 /*
  * fluid_voice_get_lower_boundary_for_attenuation
  *
@@ -1663,90 +1684,81 @@ void Sample::optimize()
             s->amplitude_that_reaches_noise_floor_is_valid = 1;
             }
       }
-/* Purpose:
- *
- * - filters (applies a lowpass filter with variable cutoff frequency and quality factor)
- * - mixes the processed sample to left and right output using the pan setting
- * - sends the processed sample to chorus and reverb
- *
- * A couple of variables are used internally, their results are discarded:
- * - dsp_phase_fractional: The fractional part of dsp_phase
- * - dsp_coeff: A table of four coefficients, depending on the fractional phase.
- *              Used to interpolate between samples.
- * - dsp_process_buffer: Holds the processed signal between stages
- * - dsp_centernode: delay line for the IIR filter
- * - dsp_hist1: same
- * - dsp_hist2: same
- *
- */
-void Voice::effects(int count, float* left, float* right, float* reverb, float* chorus)
-      {
-      /* filter (implement the voice filter according to SoundFont standard) */
+//---------------------------------------------------------
+//   filter
+//    run the resonant low pass (implement the voice filter
+//    according to SoundFont standard) over count samples;
+//    the filter is implemented in Direct-II form.
+//    While the filter changes towards its new setting the
+//    coefficients are ramped once per call instead of once
+//    per sample.
+//---------------------------------------------------------
 
-      /* Check for denormal number (too close to zero). */
-      if (fabs (hist1) < 1e-20)
-            hist1 = 0.0f;             /* FIXME JMG - Is this even needed? */
+void Voice::filter(int count, float* buf)
+      {
+      float c_a1  = a1;
+      float c_a2  = a2;
+      float c_b02 = b02;
+      float c_b1  = b1;
+      float h1    = hist1;
+      float h2    = hist2;
 
-      /* Two versions of the filter loop. One, while the filter is
-       * changing towards its new setting. The other, if the filter
-       * doesn't change.
-       */
+      for (int i = 0; i < count; i++) {
+            float centernode = buf[i] - c_a1 * h1 - c_a2 * h2;
+            buf[i] = c_b02 * (centernode + h2) + c_b1 * h1;
+            h2     = h1;
+            h1     = centernode;
+            }
+      hist1 = h1;
+      hist2 = h2;
 
       if (filter_coeff_incr_count > 0) {
-            /* Increment is added to each filter coefficient filter_coeff_incr_count times. */
-            for (int i = 0; i < count; i++) {
-                  /* The filter is implemented in Direct-II form. */
-                  float dsp_centernode = dsp_buf[i] - a1 * hist1 - a2 * hist2;
-                  dsp_buf[i] = b02 * (dsp_centernode + hist2) + b1 * hist1;
-                  hist2 = hist1;
-                  hist1 = dsp_centernode;
-
-                  if (filter_coeff_incr_count-- > 0) {
-                        a1  += a1_incr;
-                        a2  += a2_incr;
-                        b02 += b02_incr;
-                        b1  += b1_incr;
-                        }
-                  }
-            }
-      else { /* The filter parameters are constant.  This is duplicated to save time. */
-            for (int i = 0; i < count; i++) {   // The filter is implemented in Direct-II form.
-                  float dsp_centernode = dsp_buf[i] - a1 * hist1 - a2 * hist2;
-                  dsp_buf[i]     = b02 * (dsp_centernode + hist2) + b1 * hist1;
-                  hist2          = hist1;
-                  hist1          = dsp_centernode;
-                  }
+            int steps = qMin(count, filter_coeff_incr_count);
+            a1  += a1_incr * steps;
+            a2  += a2_incr * steps;
+            b02 += b02_incr * steps;
+            b1  += b1_incr * steps;
+            filter_coeff_incr_count -= steps;
             }
+      }
 
-      /* pan (Copy the signal to the left and right output buffer) The voice
-       * panning generator has a range of -500 .. 500.  If it is centered,
-       * it's close to 0.  amp_left and amp_right are then the
-       * same, and we can save one multiplication per voice and sample.
-       */
-      if ((-0.5 < pan) && (pan < 0.5)) {
-            /* The voice is centered. Use amp_left twice. */
-            for (int i = 0; i < count; i++) {
-                  float v = amp_left * dsp_buf[i];
-                  left[i]  += v;
-                  right[i] += v;
-                  }
-            }
-      else {     /* The voice is not centered. Stereo samples have one side zero. */
-            if (amp_left != 0.0) {
-                  for (int i = 0; i < count; i++)
-                        left[i] += amp_left * dsp_buf[i];
-                  }
+//---------------------------------------------------------
+//   effects
+//    - filters (applies a lowpass filter with variable cutoff
+//      frequency and quality factor)
+//    - mixes the processed sample to left and right output
+//      using the pan setting
+//    - sends the processed sample to chorus and reverb
+//
+//    The work is done in blocks of FILTER_BLOCK samples which
+//    stay in the L1 cache between filter and mix. Denormals
+//    are flushed to zero by the DenormalGuard of the rendering
+//    thread; the filter history is checked here as well as
+//    the check is cheap and covers other callers.
+//---------------------------------------------------------
 
-            if (amp_right != 0.0) {
-                  for (int i = 0; i < count; i++)
-                        right[i] += amp_right * dsp_buf[i];
-                  }
-            }
+#define FILTER_BLOCK 16
 
-      for (int i = 0; i < count; i++) {
-            float v = dsp_buf[i];
-            reverb[i] += amp_reverb * v;
-            chorus[i] += amp_chorus * v;
+void Voice::effects(int count, float* left, float* right, float* reverb, float* chorus)
+      {
+      /* Check for denormal number (too close to zero). */
+      if (fabs (hist1) < 1e-20)
+            hist1 = 0.0f;
+
+      /* The voice panning generator has a range of -500 .. 500. If it is
+       * centered, it's close to 0; amp_left is used for both sides.
+       * Stereo samples have one side zero.
+       */
+      float gain[4];
+      gain[0] = amp_left;
+      gain[1] = ((-0.5 < pan) && (pan < 0.5)) ? amp_left : amp_right;
+      gain[2] = amp_reverb;
+      gain[3] = amp_chorus;
+
+      for (int i = 0; i < count; i += FILTER_BLOCK) {
+            int n = qMin(FILTER_BLOCK, count - i);
+            filter(n, dsp_buf + i);
+            mix(dsp_buf + i, n, left + i, right + i, reverb + i, chorus + i, gain);
             }
       }
 
@@ -65,12 +65,12 @@ class Voice
       {
       static float interp_coeff_linear[FLUID_INTERP_MAX][2];
       static float interp_coeff[FLUID_INTERP_MAX][4];
-      static float sinc_table7[FLUID_INTERP_MAX][7];
+      static float sinc_table7[FLUID_INTERP_MAX][8];     // 7 coefficients, padded for simd loads
 
       Fluid* _fluid;
       double _noteTuning;             // +/- in midicent
 
-      void effects(int count, float* left, float* right, float* reverb, float* chorus);
+      void filter(int count, float* buf);
 
    public:
 	unsigned int id;                // the id is incremented for every new noteon.
@@ -80,11 +80,10 @@ class Voice
 	unsigned char key;              // the key, quick acces for noteoff
 	unsigned char vel;              // the velocity
 
-	Channel* channel;
-	Generator gen[GEN_LAST];
-	Mod mod[FLUID_NUM_MOD];
+	// state used per sample comes first, the generators and
+	// modulators, only read on note on and controller changes,
+	// are at the end of the voice
 
-	int mod_count;
 	bool has_looped;                /* Flag that is set as soon as the first loop is completed. */
 	Sample* sample;
 	int check_sample_sanity_flag;   /* Flag that initiates, that sample-related parameters
@@ -183,10 +182,31 @@ class Voice
 	/* interpolation method, as in fluid_interp in fluidsynth.h */
 	int interp_method;
 
+	/* lists of the active voices of a channel and of a
+	 * channel key, maintained by Fluid */
+	Channel* listChannel;     /* 0 if not listed */
+	Voice* chanPrev;
+	Voice* chanNext;
+	Voice* keyPrev;
+	Voice* keyNext;
+
+	/* position in Fluid::activeVoices, -1 if free */
+	int activeIndex;
+
+	/* kill priority, maintained by VoiceHeap */
+	int heapIndex;            /* position in the heap, -1 if not active */
+	int heapState;            /* state at the last priority update */
+	double heapPrio;
+
 	/* for debugging */
 	int debug;
 	double ref;
 
+	Channel* channel;
+	int mod_count;
+	Mod mod[FLUID_NUM_MOD];
+	Generator gen[GEN_LAST];
+
    public:
       Voice(Fluid*);
       Channel* get_channel() const    { return channel; }
@@ -228,13 +248,52 @@ class Voice
       int SAMPLEMODE() const   { return ((int)gen[GEN_SAMPLEMODE].val); }
 
       void write(unsigned n, float* l, float* r, float* reverb_buf, float* chorus_buf);
+      void effects(int count, float* left, float* right, float* reverb, float* chorus);
       void add_mod(const Mod* mod, int mode);
+      void setMods(const Mod* m, int n);
 
       static void dsp_float_config();
       int dsp_float_interpolate_none(unsigned);
       int dsp_float_interpolate_linear(unsigned);
       int dsp_float_interpolate_4th_order(unsigned);
       int dsp_float_interpolate_7th_order(unsigned);
+
+      //---------------------------------------------------
+      //   interpolation kernels
+      //    interpolate n samples which need no special
+      //    handling of start or end points;
+      //    phase and amp are advanced
+      //---------------------------------------------------
+
+      typedef void (*InterpKernel)(float* buf, unsigned n, const short* data,
+         Phase* phase, qint64 incr, float* amp, float amp_incr);
+
+      static InterpKernel interp4;        // selected at runtime by dsp_float_config()
+      static InterpKernel interp7;
+
+      static void interp4_scalar(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static void interp7_scalar(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static void interp4_sse2(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static void interp7_sse2(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static void interp4_avx2(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static void interp7_avx2(float*, unsigned, const short*, Phase*, qint64, float*, float);
+      static unsigned interp_count(const Phase& phase, qint64 incr, unsigned end_index, unsigned n);
+
+      //---------------------------------------------------
+      //   mix kernel
+      //    add n filtered samples to the left, right,
+      //    reverb and chorus buffers in one pass;
+      //    gain[] holds the four amplitudes
+      //---------------------------------------------------
+
+      typedef void (*MixKernel)(const float* buf, unsigned n, float* left, float* right,
+         float* reverb, float* chorus, const float* gain);
+
+      static MixKernel mix;               // selected at runtime by dsp_float_config()
+
+      static void mix_scalar(const float*, unsigned, float*, float*, float*, float*, const float*);
+      static void mix_sse2(const float*, unsigned, float*, float*, float*, float*, const float*);
+      static void mix_avx2(const float*, unsigned, float*, float*, float*, float*, const float*);
       };
 }
 
@@ -0,0 +1,210 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#include "fluid.h"
+#include "voice.h"
+#include "voiceheap.h"
+
+namespace FluidS {
+
+//---------------------------------------------------------
+//   VoiceHeap
+//---------------------------------------------------------
+
+VoiceHeap::VoiceHeap(int size)
+      {
+      heap = new Voice*[size];
+      n    = 0;
+      }
+
+VoiceHeap::~VoiceHeap()
+      {
+      delete[] heap;
+      }
+
+//---------------------------------------------------------
+//   priority
+//    Determine how 'important' a voice is. This is the
+//    priority of the former linear search in
+//    free_voice_by_kill() without the age offset: the
+//    age term -(noteid - id) only differs by the voice
+//    id, which orders the voices the same way.
+//---------------------------------------------------------
+
+double VoiceHeap::priority(const Voice* v)
+      {
+      double prio = 10000.0;
+
+      /* Voices on the drum channel are very important. Drum
+       * notes run most of the time in the release phase, so
+       * forget about the released-note condition. */
+      if (v->chan == 9)
+            prio += 4000.0;
+      else if (v->RELEASED())
+            prio -= 2000.0;
+
+      /* The sustain pedal is usually used to play more voices
+       * than fingers, it shouldn't hurt to kill one of them. */
+      if (v->SUSTAINED())
+            prio -= 1000.0;
+
+      /* An older voice is a little bit less important than a
+       * younger one, so a new chord does not kill its own notes. */
+      prio += double(v->get_id());
+
+      /* Louder voices are more important. */
+      if (v->volenv_section != FLUID_VOICE_ENVATTACK)
+            prio += v->volenv_val * 1000.0;
+      return prio;
+      }
+
+//---------------------------------------------------------
+//   state
+//    everything the priority depends on, except the
+//    envelope level
+//---------------------------------------------------------
+
+int VoiceHeap::state(const Voice* v)
+      {
+      return v->status | (v->chan << 8) | (v->volenv_section << 16);
+      }
+
+//---------------------------------------------------------
+//   changed
+//    true if the voice changed its state since its
+//    priority was computed
+//---------------------------------------------------------
+
+bool VoiceHeap::changed(const Voice* v) const
+      {
+      return v->heapState != state(v);
+      }
+
+//---------------------------------------------------------
+//   less
+//---------------------------------------------------------
+
+inline bool VoiceHeap::less(const Voice* a, const Voice* b) const
+      {
+      return a->heapPrio < b->heapPrio;
+      }
+
+//---------------------------------------------------------
+//   set
+//---------------------------------------------------------
+
+inline void VoiceHeap::set(int i, Voice* v)
+      {
+      heap[i]      = v;
+      v->heapIndex = i;
+      }
+
+//---------------------------------------------------------
+//   up
+//---------------------------------------------------------
+
+void VoiceHeap::up(int i)
+      {
+      Voice* v = heap[i];
+      while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(v, heap[parent]))
+                  break;
+            set(i, heap[parent]);
+            i = parent;
+            }
+      set(i, v);
+      }
+
+//---------------------------------------------------------
+//   down
+//---------------------------------------------------------
+
+void VoiceHeap::down(int i)
+      {
+      Voice* v = heap[i];
+      for (;;) {
+            int child = 2 * i + 1;
+            if (child >= n)
+                  break;
+            if (child + 1 < n && less(heap[child + 1], heap[child]))
+                  ++child;
+            if (!less(heap[child], v))
+                  break;
+            set(i, heap[child]);
+            i = child;
+            }
+      set(i, v);
+      }
+
+//---------------------------------------------------------
+//   insert
+//---------------------------------------------------------
+
+void VoiceHeap::insert(Voice* v)
+      {
+      v->heapPrio  = priority(v);
+      v->heapState = state(v);
+      set(n, v);
+      up(n++);
+      }
+
+//---------------------------------------------------------
+//   remove
+//---------------------------------------------------------
+
+void VoiceHeap::remove(Voice* v)
+      {
+      int i = v->heapIndex;
+      if (i < 0)
+            return;
+      v->heapIndex = -1;
+      Voice* last = heap[--n];
+      if (i == n)
+            return;
+      set(i, last);
+      if (i > 0 && less(last, heap[(i - 1) / 2]))
+            up(i);
+      else
+            down(i);
+      }
+
+//---------------------------------------------------------
+//   update
+//    recompute the priority of v and restore the heap
+//    order
+//---------------------------------------------------------
+
+void VoiceHeap::update(Voice* v)
+      {
+      int i = v->heapIndex;
+      if (i < 0)
+            return;
+      double old   = v->heapPrio;
+      v->heapPrio  = priority(v);
+      v->heapState = state(v);
+      if (v->heapPrio < old)
+            up(i);
+      else
+            down(i);
+      }
+
+}
@@ -0,0 +1,64 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ * 02111-1307, USA
+ */
+
+
+#ifndef __FLUID_VOICEHEAP_H__
+#define __FLUID_VOICEHEAP_H__
+
+namespace FluidS {
+
+class Voice;
+
+//---------------------------------------------------------
+//   VoiceHeap
+//    The active voices ordered by their kill priority,
+//    the least important voice is on top. Priorities
+//    are only recomputed when the state of a voice
+//    changes (note off, sustain, envelope section), so
+//    the level of a decaying voice is that of the last
+//    transition.
+//---------------------------------------------------------
+
+class VoiceHeap {
+      Voice** heap;
+      int n;
+
+      bool less(const Voice* a, const Voice* b) const;
+      void up(int i);
+      void down(int i);
+      void set(int i, Voice* v);
+
+   public:
+      VoiceHeap(int size);
+      ~VoiceHeap();
+      int size() const        { return n; }
+      Voice* top() const      { return n ? heap[0] : 0; }
+      void insert(Voice*);
+      void remove(Voice*);
+      void update(Voice*);
+      bool changed(const Voice*) const;
+
+      static double priority(const Voice*);
+      static int state(const Voice*);
+      };
+
+}
+
+#endif
@@ -1595,7 +1595,7 @@ bool Score::processMidiInput()
                         p = part(0);
                   else
                         p = staff(staffIdx)->part();
-                  if (p)
+                  if (p && !MScore::seq->midiThru())
                         MScore::seq->startNote(p->instr()->channel(0), ev.pitch, 80,
                            MScore::defaultPlayDuration, 0.0);
                   }
@@ -1608,6 +1608,8 @@ bool Score::processMidiInput()
                   }
             }
       if (cmdActive) {
+            if (MScore::seq->midiThru())
+                  setPlayNote(false);     // already sounding
             _layoutAll = true;
             endCmd();
             //after relayout
@@ -41,6 +41,7 @@ QString MScore::partStyle;
 QString MScore::soundFont;
 QString MScore::lastError;
 bool    MScore::layoutDebug = false;
+bool    MScore::streamLoad  = true;
 int     MScore::division    = 480;
 int     MScore::sampleRate  = 44100;
 bool    MScore::debugMsg    = false;
@@ -597,6 +597,7 @@ class MScore {
       static QString soundFont;
       static QString lastError;
       static bool layoutDebug;
+      static bool streamLoad;             // read score files with XmlReader
 
       static int division;
       static int sampleRate;
@@ -42,6 +42,7 @@ class Selection;
 class Segment;
 class Rest;
 class Xml;
+class XmlReader;
 class Articulation;
 class Note;
 class Chord;
@@ -389,6 +390,13 @@ class Score {
       void updateVelo();
       void addAudioTrack();
       void parseVersion(const QString&);
+      bool checkVersion(const QString&);
+      void setLinkIds();
+      void readScoreElement(const QDomElement&);
+      void readStaffElement(const QDomElement&, int staff, MeasureBase*& mb);
+      bool finishRead(const QDomElement&);
+      bool loadDom(QIODevice*);
+      bool loadStream(QIODevice*);
       QList<Fraction> splitGapToMeasureBoundaries(ChordRest*, Fraction);
       void pasteChordRest(ChordRest* cr, int tick);
       void init();
@@ -412,6 +420,7 @@ class Score {
       void removeStaff(Staff*);
       void addMeasure(MeasureBase*, MeasureBase*);
       void readStaff(const QDomElement&);
+      void readStaff(XmlReader&);
 
       void cmdInsertPart(Part*, int);
       void cmdRemovePart(Part*);
@@ -431,6 +440,7 @@ class Score {
 
       void write(Xml&, bool onlySelection);
       bool read(const QDomElement&);
+      bool read(XmlReader&);
       bool read1(const QDomElement&);
 
       QList<Staff*>& staves()                { return _staves; }
@@ -158,60 +158,89 @@ void Score::readStaff(const QDomElement& de)
       curTick         = 0;
       curTrack        = staff * VOICES;
 
-      for (QDomElement e = de.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
-            const QString& tag(e.tagName());
+      for (QDomElement e = de.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+            readStaffElement(e, staff, mb);
+      }
 
-            if (tag == "Measure") {
-                  Measure* measure = 0;
-                  if (staff == 0) {
-                        measure = new Measure(this);
-                        measure->setTick(curTick);
-                        add(measure);
-                        if (_mscVersion < 115) {
-                              const SigEvent& ev = sigmap()->timesig(measure->tick());
-                              measure->setLen(ev.timesig());
-                              measure->setTimesig(ev.nominal());
-                              }
-                        else {
-                              //
-                              // inherit timesig from previous measure
-                              //
-                              Measure* m = measure->prevMeasure();
-                              Fraction f(m ? m->timesig() : Fraction(4,4));
-                              measure->setLen(f);
-                              measure->setTimesig(f);
-                              }
+//---------------------------------------------------------
+//   readStaff
+//    measures and frames are read from a dom fragment
+//    each until they are ported to the stream reader
+//---------------------------------------------------------
+
+void Score::readStaff(XmlReader& e)
+      {
+      MeasureBase* mb = first();
+      int staff       = e.attribute("id", "1").toInt() - 1;
+      curTick         = 0;
+      curTrack        = staff * VOICES;
+
+      while (e.readNextStartElement()) {
+            QDomDocument doc;
+            readStaffElement(e.readDom(doc), staff, mb);
+            }
+      }
+
+//---------------------------------------------------------
+//   readStaffElement
+//    mb is the next measure of the first staff for the
+//    measures of the other staves
+//---------------------------------------------------------
+
+void Score::readStaffElement(const QDomElement& e, int staff, MeasureBase*& mb)
+      {
+      const QString& tag(e.tagName());
+
+      if (tag == "Measure") {
+            Measure* measure = 0;
+            if (staff == 0) {
+                  measure = new Measure(this);
+                  measure->setTick(curTick);
+                  add(measure);
+                  if (_mscVersion < 115) {
+                        const SigEvent& ev = sigmap()->timesig(measure->tick());
+                        measure->setLen(ev.timesig());
+                        measure->setTimesig(ev.nominal());
                         }
                   else {
-                        while (mb) {
-                              if (mb->type() != MEASURE) {
-                                    mb = mb->next();
-                                    }
-                              else {
-                                    measure = (Measure*)mb;
-                                    mb      = mb->next();
-                                    break;
-                                    }
+                        //
+                        // inherit timesig from previous measure
+                        //
+                        Measure* m = measure->prevMeasure();
+                        Fraction f(m ? m->timesig() : Fraction(4,4));
+                        measure->setLen(f);
+                        measure->setTimesig(f);
+                        }
+                  }
+            else {
+                  while (mb) {
+                        if (mb->type() != MEASURE) {
+                              mb = mb->next();
                               }
-                        if (measure == 0) {
-                              qDebug("Score::readStaff(): missing measure!\n");
-                              measure = new Measure(this);
-                              measure->setTick(curTick);
-                              add(measure);
+                        else {
+                              measure = (Measure*)mb;
+                              mb      = mb->next();
+                              break;
                               }
                         }
-                  measure->read(e, staff);
-                  curTick = measure->tick() + measure->ticks();
-                  }
-            else if (tag == "HBox" || tag == "VBox" || tag == "TBox" || tag == "FBox") {
-                  MeasureBase* mb = static_cast<MeasureBase*>(Element::name2Element(tag, this));
-                  mb->read(e);
-                  mb->setTick(curTick);
-                  add(mb);
+                  if (measure == 0) {
+                        qDebug("Score::readStaff(): missing measure!\n");
+                        measure = new Measure(this);
+                        measure->setTick(curTick);
+                        add(measure);
+                        }
                   }
-            else
-                  domError(e);
+            measure->read(e, staff);
+            curTick = measure->tick() + measure->ticks();
+            }
+      else if (tag == "HBox" || tag == "VBox" || tag == "TBox" || tag == "FBox") {
+            MeasureBase* mb = static_cast<MeasureBase*>(Element::name2Element(tag, this));
+            mb->read(e);
+            mb->setTick(curTick);
+            add(mb);
             }
+      else
+            domError(e);
       }
 
 //---------------------------------------------------------
@@ -639,19 +668,13 @@ bool Score::loadCompressedMsc(QString name)
       QBuffer dbuf;
       dbuf.open(QIODevice::WriteOnly);
       uz.extractFile(rootfile, &dbuf);
-
-      QDomDocument doc;
-      if (!doc.setContent(dbuf.data(), false, &err, &line, &column)) {
-            QString col, ln;
-            col.setNum(column);
-            ln.setNum(line);
-            QString error = err + "\n at line " + ln + " column " + col;
-            qDebug("error: %s\n", qPrintable(error));
-            return false;
-            }
       dbuf.close();
+      dbuf.open(QIODevice::ReadOnly);
+
       docName = info.completeBaseName();
-      bool retval = read1(doc.documentElement());
+      bool retval = MScore::streamLoad ? loadStream(&dbuf) : loadDom(&dbuf);
+      if (!retval)
+            qDebug("error: %s\n", qPrintable(MScore::lastError));
 
 #ifdef OMR
       //
@@ -700,19 +723,82 @@ bool Score::loadMsc(QString name)
             return false;
             }
 
+      docName = f.fileName();
+      return MScore::streamLoad ? loadStream(&f) : loadDom(&f);
+      }
+
+//---------------------------------------------------------
+//   loadDom
+//    read the score file from dev into a dom document and
+//    read the score from it
+//---------------------------------------------------------
+
+bool Score::loadDom(QIODevice* dev)
+      {
       QDomDocument doc;
       int line, column;
       QString err;
-      if (!doc.setContent(&f, false, &err, &line, &column)) {
+      if (!doc.setContent(dev, false, &err, &line, &column)) {
             QString s = QT_TRANSLATE_NOOP("file", "error reading file %1 at line %2 column %3: %4\n");
-            MScore::lastError = s.arg(f.fileName()).arg(line).arg(column).arg(err);
+            MScore::lastError = s.arg(info.filePath()).arg(line).arg(column).arg(err);
             return false;
             }
-      f.close();
-      docName = f.fileName();
+      dev->close();
       return read1(doc.documentElement());
       }
 
+//---------------------------------------------------------
+//   loadStream
+//    read the score while parsing the file from dev;
+//    files older than 1.17 are read by loadDom()
+//---------------------------------------------------------
+
+bool Score::loadStream(QIODevice* dev)
+      {
+      XmlReader e(dev);
+      _elinks.clear();
+      while (e.readNextStartElement()) {
+            if (e.name() != "museScore") {
+                  e.unknown();
+                  continue;
+                  }
+            if (!checkVersion(e.attribute("version")))
+                  return false;
+            if (_mscVersion < 117) {
+                  dev->reset();
+                  return loadDom(dev);
+                  }
+            while (e.readNextStartElement()) {
+                  const QStringRef& tag(e.name());
+                  if (tag == "programVersion") {
+                        _mscoreVersion = e.readElementText();
+                        parseVersion(_mscoreVersion);
+                        }
+                  else if (tag == "programRevision")
+                        _mscoreRevision = e.readElementText().toInt();
+                  else if (tag == "Score")
+                        read(e);
+                  else if (tag == "Revision") {
+                        QDomDocument doc;
+                        Revision* revision = new Revision;
+                        revision->read(e.readDom(doc));
+                        _revisions->add(revision);
+                        }
+                  else
+                        e.unknown();
+                  }
+            }
+      if (e.hasError()) {
+            QString s = QT_TRANSLATE_NOOP("file", "error reading file %1 at line %2 column %3: %4\n");
+            MScore::lastError = s.arg(info.filePath()).arg(e.lineNumber()).arg(e.columnNumber())
+               .arg(e.errorString());
+            return false;
+            }
+      dev->close();
+      setLinkIds();
+      return true;
+      }
+
 //---------------------------------------------------------
 //   parseVersion
 //---------------------------------------------------------
@@ -775,20 +861,8 @@ bool Score::read1(const QDomElement& de)
       _elinks.clear();
       for (QDomElement e = de; !e.isNull(); e = e.nextSiblingElement()) {
             if (e.tagName() == "museScore") {
-                  const QString& version = e.attribute("version");
-                  QStringList sl = version.split('.');
-                  _mscVersion = sl[0].toInt() * 100 + sl[1].toInt();
-                  if (_mscVersion > MSCVERSION) {
-                  // incompatible version
-                        QString message = QT_TRANSLATE_NOOP("file", "Cannot read this score:<br>Your version of MuseScore is too old.<br><a href=\"http://musescore.org\">Upgrade now!</a>");
-                        QMessageBox msgBox;
-                        msgBox.setWindowTitle(QT_TRANSLATE_NOOP(file, "MuseScore"));
-                        msgBox.setText(message);
-                        msgBox.setTextFormat(Qt::RichText);
-                        msgBox.setIcon(QMessageBox::Critical);
-                        msgBox.exec();
+                  if (!checkVersion(e.attribute("version")))
                         return false;
-                        }
                   if (_mscVersion < 117) {
                         bool rv = read(e);
                         return rv;
@@ -808,7 +882,7 @@ bool Score::read1(const QDomElement& de)
                               }
                         else if (tag == "Revision") {
                               Revision* revision = new Revision;
-                              revision->read(e);
+                              revision->read(ee);
                               _revisions->add(revision);
                               }
                         else
@@ -818,12 +892,46 @@ bool Score::read1(const QDomElement& de)
             else
                   domError(e);
             }
+      setLinkIds();
+      return true;
+      }
+
+//---------------------------------------------------------
+//   checkVersion
+//    set the file version; return false if the score
+//    cannot be read
+//---------------------------------------------------------
+
+bool Score::checkVersion(const QString& version)
+      {
+      QStringList sl = version.split('.');
+      _mscVersion = sl[0].toInt() * 100 + sl.value(1).toInt();
+      if (_mscVersion > MSCVERSION) {
+            // incompatible version
+            QString message = QT_TRANSLATE_NOOP("file", "Cannot read this score:<br>Your version of MuseScore is too old.<br><a href=\"http://musescore.org\">Upgrade now!</a>");
+            QMessageBox msgBox;
+            msgBox.setWindowTitle(QT_TRANSLATE_NOOP(file, "MuseScore"));
+            msgBox.setText(message);
+            msgBox.setTextFormat(Qt::RichText);
+            msgBox.setIcon(QMessageBox::Critical);
+            msgBox.exec();
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   setLinkIds
+//    number the linked elements after reading
+//---------------------------------------------------------
+
+void Score::setLinkIds()
+      {
       int id = 1;
       foreach(LinkedElements* le, _elinks)
             le->setLid(id++);
       _elinks.clear();
       _mscVersion = MSCVERSION;     // for later drag & drop usage
-      return true;
       }
 
 //---------------------------------------------------------
@@ -838,200 +946,254 @@ bool Score::read(const QDomElement& de)
 
       if (parentScore())
             setMscVersion(parentScore()->mscVersion());
-      for (QDomElement ee = de.firstChildElement(); !ee.isNull(); ee = ee.nextSiblingElement()) {
-            curTrack = -1;
-            const QString& tag(ee.tagName());
-            const QString& val(ee.text());
-            int i = val.toInt();
-            if (tag == "Staff")
-                  readStaff(ee);
-            else if (tag == "KeySig") {
-                  KeySig* ks = new KeySig(this);
-                  ks->read(ee);
-                  customKeysigs.append(ks);
+      for (QDomElement ee = de.firstChildElement(); !ee.isNull(); ee = ee.nextSiblingElement())
+            readScoreElement(ee);
+      return finishRead(de);
+      }
+
+//---------------------------------------------------------
+//   read
+//    read the children of <Score> from the stream; the
+//    staves and excerpts are read from the stream, all
+//    other elements from a dom fragment each
+//---------------------------------------------------------
+
+bool Score::read(XmlReader& e)
+      {
+      _fileDivision = 384;
+      spanner.clear();
+
+      if (parentScore())
+            setMscVersion(parentScore()->mscVersion());
+      while (e.readNextStartElement()) {
+            const QStringRef& tag(e.name());
+            if (tag == "Staff") {
+                  curTrack = -1;
+                  readStaff(e);
                   }
-            else if (tag == "StaffType") {
-                  int idx        = ee.attribute("idx").toInt();
-                  StaffType* ost = _staffTypes.value(idx);
-                  StaffType* st;
-                  if (ost)
-                        st = ost;
-                  else {
-                        QString group  = ee.attribute("group", "pitched");
-                        if (group == "percussion")
-                              st  = new StaffTypePercussion();
-                        else if (group == "tablature")
-                              st  = new StaffTypeTablature();
-                        else
-                              st  = new StaffTypePitched();
-                        }
-                  st->read(ee);
-                  if (idx < _staffTypes.size())
-                        _staffTypes[idx] = st;
-                  else
-                        _staffTypes.append(st);
+            else if (tag == "Score") {          // recursion
+                  Score* s = new Score(style());
+                  s->setParentScore(this);
+                  s->read(e);
+                  addExcerpt(s);
                   }
-            else if (tag == "siglist")
-                  _sigmap->read(ee, _fileDivision);
-            else if (tag == "tempolist")        // obsolete
-                  ;           // tempomap()->read(ee, _fileDivision);
-            else if (tag == "programVersion") {
-                  _mscoreVersion = val;
-                  parseVersion(val);
+            else {
+                  QDomDocument doc;
+                  readScoreElement(e.readDom(doc));
                   }
-            else if (tag == "programRevision")
-                  _mscoreRevision = val.toInt();
-            else if (tag == "Mag" || tag == "MagIdx" || tag == "xoff" || tag == "yoff") {
-                  // obsolete
-                  ;
+            }
+      return finishRead(QDomElement());
+      }
+
+//---------------------------------------------------------
+//   readScoreElement
+//    read a child element of <Score>
+//---------------------------------------------------------
+
+void Score::readScoreElement(const QDomElement& ee)
+      {
+      curTrack = -1;
+      const QString& tag(ee.tagName());
+      const QString& val(ee.text());
+      int i = val.toInt();
+      if (tag == "Staff")
+            readStaff(ee);
+      else if (tag == "KeySig") {
+            KeySig* ks = new KeySig(this);
+            ks->read(ee);
+            customKeysigs.append(ks);
+            }
+      else if (tag == "StaffType") {
+            int idx        = ee.attribute("idx").toInt();
+            StaffType* ost = _staffTypes.value(idx);
+            StaffType* st;
+            if (ost)
+                  st = ost;
+            else {
+                  QString group  = ee.attribute("group", "pitched");
+                  if (group == "percussion")
+                        st  = new StaffTypePercussion();
+                  else if (group == "tablature")
+                        st  = new StaffTypeTablature();
+                  else
+                        st  = new StaffTypePitched();
                   }
-            else if (tag == "Omr") {
+            st->read(ee);
+            if (idx < _staffTypes.size())
+                  _staffTypes[idx] = st;
+            else
+                  _staffTypes.append(st);
+            }
+      else if (tag == "siglist")
+            _sigmap->read(ee, _fileDivision);
+      else if (tag == "tempolist")        // obsolete
+            ;           // tempomap()->read(ee, _fileDivision);
+      else if (tag == "programVersion") {
+            _mscoreVersion = val;
+            parseVersion(val);
+            }
+      else if (tag == "programRevision")
+            _mscoreRevision = val.toInt();
+      else if (tag == "Mag" || tag == "MagIdx" || tag == "xoff" || tag == "yoff") {
+            // obsolete
+            ;
+            }
+      else if (tag == "Omr") {
 #ifdef OMR
-                  _omr = new Omr(this);
-                  _omr->read(ee);
+            _omr = new Omr(this);
+            _omr->read(ee);
 #endif
+            }
+      else if (tag == "showOmr")
+            _showOmr = i;
+      else if (tag == "LayerTag") {
+            int id = ee.attribute("id").toInt();
+            const QString& tag = ee.attribute("tag");
+            if (id >= 0 && id < 32) {
+                  _layerTags[id] = tag;
+                  _layerTagComments[id] = val;
                   }
-            else if (tag == "showOmr")
-                  _showOmr = i;
-            else if (tag == "LayerTag") {
-                  int id = ee.attribute("id").toInt();
-                  const QString& tag = ee.attribute("tag");
-                  if (id >= 0 && id < 32) {
-                        _layerTags[id] = tag;
-                        _layerTagComments[id] = val;
-                        }
-                  }
-            else if (tag == "Layer") {
-                  Layer layer;
-                  layer.name = ee.attribute("name");
-                  layer.tags = ee.attribute("mask").toUInt();
-                  _layer.append(layer);
-                  }
-            else if (tag == "currentLayer")
-                  _currentLayer = val.toInt();
-            else if (tag == "SyntiSettings") {
-                  _syntiState.clear();
-                  _syntiState.read(ee);
-                  }
-            else if (tag == "Spatium")
-                  _style.setSpatium (val.toDouble() * DPMM); // obsolete, moved to Style
-            else if (tag == "page-offset")            // obsolete, moved to Score
-                  setPageNumberOffset(i);
-            else if (tag == "Division")
-                  _fileDivision = i;
-            else if (tag == "showInvisible")
-                  _showInvisible = i;
-            else if (tag == "showUnprintable")
-                  _showUnprintable = i;
-            else if (tag == "showFrames")
-                  _showFrames = i;
-            else if (tag == "showMargins")
-                  _showPageborders = i;
-            else if (tag == "Style") {
-                  qreal sp      = _style.spatium();
-                  // PageFormat pf = *_style.pageFormat();
-                  _style.load(ee);
-                  if (_layoutMode == LayoutFloat) {
-                        _style.setSpatium(sp);
-                        // _style.setPageFormat(pf);
-                        }
-                  }
-            else if (tag == "TextStyle") {      // obsolete: is now part of style
-                  TextStyle s;
-                  s.read(ee);
-                  // settings for _reloff::x and _reloff::y in old formats
-                  // is now included in style; setting them to 0 fixes most
-                  // cases of backward compatibility
-                  s.setRxoff(0);
-                  s.setRyoff(0);
-                  _style.setTextStyle(s);
-                  }
-            else if (tag == "page-layout") {
-                  if (_layoutMode != LayoutFloat) {
-                        PageFormat pf = *pageFormat();
-                        pf.read(ee, this);
-                        setPageFormat(pf);
-                        }
-                  }
-            else if (tag == "copyright" || tag == "rights") {
-                  Text* text = new Text(this);
-                  text->read(ee);
-                  setMetaTag("copyright", text->getText());
-                  delete text;
-                  }
-            else if (tag == "movement-number")
-                  setMetaTag("movementNumber", val);
-            else if (tag == "movement-title")
-                  setMetaTag("movementTitle", val);
-            else if (tag == "work-number")
-                  setMetaTag("workNumber", val);
-            else if (tag == "work-title")
-                  setMetaTag("workTitle", val);
-            else if (tag == "source")
-                  setMetaTag("source", val);
-            else if (tag == "metaTag") {
-                  QString name = ee.attribute("name");
-                  setMetaTag(name, val);
-                  }
-            else if (tag == "Part") {
-                  Part* part = new Part(this);
-                  part->read(ee);
-                  _parts.push_back(part);
-                  }
-            else if (tag == "Symbols")    // obsolete
-                  ;
-            else if (tag == "cursorTrack") {
-                  if (i >= 0)
-                        setInputTrack(i);
-                  }
-            else if (tag == "Slur") {
-                  Slur* slur = new Slur(this);
-                  slur->read(ee);
-                  spanner.append(slur);
-                  }
-            else if ((_mscVersion < 116) &&     // skip and process in II. pass
-               ((tag == "HairPin")
-                || (tag == "Ottava")
-                || (tag == "TextLine")
-                || (tag == "Volta")
-                || (tag == "Trill")
-                || (tag == "Pedal"))) {
-                  ;
-                  }
-            else if (tag == "Excerpt") {
-                  Excerpt* e = new Excerpt(this);
-                  e->read(ee);
-                  _excerpts.append(e);
-                  }
-            else if (tag == "Beam") {
-                  Beam* beam = new Beam(this);
-                  beam->read(ee);
-                  beam->setParent(0);
-                  // _beams.append(beam);
+            }
+      else if (tag == "Layer") {
+            Layer layer;
+            layer.name = ee.attribute("name");
+            layer.tags = ee.attribute("mask").toUInt();
+            _layer.append(layer);
+            }
+      else if (tag == "currentLayer")
+            _currentLayer = val.toInt();
+      else if (tag == "SyntiSettings") {
+            _syntiState.clear();
+            _syntiState.read(ee);
+            }
+      else if (tag == "Spatium")
+            _style.setSpatium (val.toDouble() * DPMM); // obsolete, moved to Style
+      else if (tag == "page-offset")            // obsolete, moved to Score
+            setPageNumberOffset(i);
+      else if (tag == "Division")
+            _fileDivision = i;
+      else if (tag == "showInvisible")
+            _showInvisible = i;
+      else if (tag == "showUnprintable")
+            _showUnprintable = i;
+      else if (tag == "showFrames")
+            _showFrames = i;
+      else if (tag == "showMargins")
+            _showPageborders = i;
+      else if (tag == "Style") {
+            qreal sp      = _style.spatium();
+            // PageFormat pf = *_style.pageFormat();
+            _style.load(ee);
+            if (_layoutMode == LayoutFloat) {
+                  _style.setSpatium(sp);
+                  // _style.setPageFormat(pf);
                   }
-            else if (tag == "Score") {          // recursion
-                  Score* s = new Score(style());
-                  s->setParentScore(this);
-                  s->read(ee);
-                  addExcerpt(s);
+            }
+      else if (tag == "TextStyle") {      // obsolete: is now part of style
+            TextStyle s;
+            s.read(ee);
+            // settings for _reloff::x and _reloff::y in old formats
+            // is now included in style; setting them to 0 fixes most
+            // cases of backward compatibility
+            s.setRxoff(0);
+            s.setRyoff(0);
+            _style.setTextStyle(s);
+            }
+      else if (tag == "page-layout") {
+            if (_layoutMode != LayoutFloat) {
+                  PageFormat pf = *pageFormat();
+                  pf.read(ee, this);
+                  setPageFormat(pf);
                   }
-            else if (tag == "PageList") {
-                  for (QDomElement e = ee.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
-                        if (e.tagName() == "Page") {
-                              Page* page = new Page(this);
-                              _pages.append(page);
-                              page->read(e);
-                              }
-                        else
-                              domError(e);
+            }
+      else if (tag == "copyright" || tag == "rights") {
+            Text* text = new Text(this);
+            text->read(ee);
+            setMetaTag("copyright", text->getText());
+            delete text;
+            }
+      else if (tag == "movement-number")
+            setMetaTag("movementNumber", val);
+      else if (tag == "movement-title")
+            setMetaTag("movementTitle", val);
+      else if (tag == "work-number")
+            setMetaTag("workNumber", val);
+      else if (tag == "work-title")
+            setMetaTag("workTitle", val);
+      else if (tag == "source")
+            setMetaTag("source", val);
+      else if (tag == "metaTag") {
+            QString name = ee.attribute("name");
+            setMetaTag(name, val);
+            }
+      else if (tag == "Part") {
+            Part* part = new Part(this);
+            part->read(ee);
+            _parts.push_back(part);
+            }
+      else if (tag == "Symbols")    // obsolete
+            ;
+      else if (tag == "cursorTrack") {
+            if (i >= 0)
+                  setInputTrack(i);
+            }
+      else if (tag == "Slur") {
+            Slur* slur = new Slur(this);
+            slur->read(ee);
+            spanner.append(slur);
+            }
+      else if ((_mscVersion < 116) &&     // skip and process in II. pass
+         ((tag == "HairPin")
+          || (tag == "Ottava")
+          || (tag == "TextLine")
+          || (tag == "Volta")
+          || (tag == "Trill")
+          || (tag == "Pedal"))) {
+            ;
+            }
+      else if (tag == "Excerpt") {
+            Excerpt* e = new Excerpt(this);
+            e->read(ee);
+            _excerpts.append(e);
+            }
+      else if (tag == "Beam") {
+            Beam* beam = new Beam(this);
+            beam->read(ee);
+            beam->setParent(0);
+            // _beams.append(beam);
+            }
+      else if (tag == "Score") {          // recursion
+            Score* s = new Score(style());
+            s->setParentScore(this);
+            s->read(ee);
+            addExcerpt(s);
+            }
+      else if (tag == "PageList") {
+            for (QDomElement e = ee.firstChildElement(); !e.isNull(); e = e.nextSiblingElement()) {
+                  if (e.tagName() == "Page") {
+                        Page* page = new Page(this);
+                        _pages.append(page);
+                        page->read(e);
                         }
+                  else
+                        domError(e);
                   }
-            else if (tag == "name")
-                  setName(val);
-            else
-                  domError(ee);
             }
+      else if (tag == "name")
+            setName(val);
+      else
+            domError(ee);
+      }
 
+//---------------------------------------------------------
+//   finishRead
+//    fix up the score after all elements were read; de
+//    is the <Score> element of files older than 1.16,
+//    whose spanners are read in a second pass
+//---------------------------------------------------------
+
+bool Score::finishRead(const QDomElement& de)
+      {
       if (_mscVersion < 121) {            // 115
             for (int staffIdx = 0; staffIdx < _staves.size(); ++staffIdx) {
                   Staff* s = _staves[staffIdx];
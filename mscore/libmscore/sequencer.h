@@ -28,6 +28,8 @@ class Sequencer {
 
       virtual void sendEvent(const Event&) = 0;
       virtual void startNote(const Channel&, int, int, int, double nt) = 0;
+      // true if midi input is played without the help of the gui
+      virtual bool midiThru() const { return false; }
       };
 #endif
 
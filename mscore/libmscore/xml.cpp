@@ -576,3 +576,66 @@ void Xml::writeHtml(const QString& s)
       }
 
 
+//---------------------------------------------------------
+//   attribute
+//---------------------------------------------------------
+
+QString XmlReader::attribute(const char* name, const QString& dflt) const
+      {
+      QXmlStreamAttributes a = attributes();
+      return a.hasAttribute(name) ? a.value(name).toString() : dflt;
+      }
+
+//---------------------------------------------------------
+//   readDom
+//    read the current element into a tree of doc, the
+//    reader is left at its end tag. Like
+//    QDomDocument::setContent() whitespace only text is
+//    dropped.
+//---------------------------------------------------------
+
+QDomElement XmlReader::readDom(QDomDocument& doc)
+      {
+      QDomElement e = doc.createElement(qualifiedName().toString());
+      foreach(const QXmlStreamAttribute& a, attributes())
+            e.setAttribute(a.qualifiedName().toString(), a.value().toString());
+      QString text;           // text can be reported in several pieces
+      while (!atEnd()) {
+            TokenType t = readNext();
+            if (t == Characters && !isCDATA()) {
+                  text.append(this->text());
+                  continue;
+                  }
+            if (!text.isEmpty()) {
+                  if (!text.trimmed().isEmpty())
+                        e.appendChild(doc.createTextNode(text));
+                  text.clear();
+                  }
+            if (t == StartElement)
+                  e.appendChild(readDom(doc));
+            else if (t == Characters)
+                  e.appendChild(doc.createCDATASection(this->text().toString()));
+            else if (t == Comment)
+                  e.appendChild(doc.createComment(this->text().toString()));
+            else if (t == EndElement)
+                  break;
+            }
+      return e;
+      }
+
+//---------------------------------------------------------
+//   unknown
+//    report and skip the current element
+//---------------------------------------------------------
+
+void XmlReader::unknown()
+      {
+      QString m;
+      if (!docName.isEmpty())
+            m = QString("<%1>:").arg(docName);
+      m += QString("line:%1 col:%2 Unknown Node <%3>")
+         .arg(lineNumber()).arg(columnNumber()).arg(name().toString());
+      qDebug("%s", qPrintable(m));
+      skipCurrentElement();
+      }
+
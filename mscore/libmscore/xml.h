@@ -76,6 +76,23 @@ class Xml : public QTextStream {
       static QString htmlToString(const QDomElement&);
       };
 
+//---------------------------------------------------------
+//   XmlReader
+//    pull parser for score files. Classes which do not
+//    read from the stream yet get a dom fragment of the
+//    current element from readDom().
+//---------------------------------------------------------
+
+class XmlReader : public QXmlStreamReader {
+   public:
+      XmlReader(QIODevice* d) : QXmlStreamReader(d)   { setNamespaceProcessing(false); }
+      XmlReader(const QByteArray& d) : QXmlStreamReader(d) { setNamespaceProcessing(false); }
+
+      QString attribute(const char* name, const QString& dflt = QString()) const;
+      QDomElement readDom(QDomDocument&);
+      void unknown();
+      };
+
 extern Placement readPlacement(const QDomElement&);
 extern Fraction  readFraction(const QDomElement&);
 extern QString docName;
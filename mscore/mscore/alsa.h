@@ -27,77 +27,10 @@
 
 #include "driver.h"
 #include "mididriver.h"
-#include "config.h"
-
-#define ALSA_PCM_NEW_HW_PARAMS_API
-#define ALSA_PCM_NEW_SW_PARAMS_API
+#include "alsadriver.h"
 
 class MidiDriver;
 
-#include <alsa/asoundlib.h>
-
-//---------------------------------------------------------
-//   AlsaDriver
-//---------------------------------------------------------
-
-class AlsaDriver {
-      QString _name;
-      typedef char* (*play_function)(const float*, char*, int, int);
-      typedef char* (*clear_function)(char*, int, int);
-
-      enum { MAXPFD = 8, MAXPLAY = 4 };
-
-      int setHwpar(snd_pcm_t* handle, snd_pcm_hw_params_t* hwpar);
-      int setSwpar(snd_pcm_t* handle, snd_pcm_sw_params_t* swpar);
-      int recover();
-
-      unsigned int           _rate;
-      snd_pcm_uframes_t      _frsize;
-      unsigned int           _nfrags;
-      snd_pcm_format_t       _play_format;
-      snd_pcm_access_t       _play_access;
-      snd_pcm_t*             _play_handle;
-      snd_pcm_hw_params_t*   _play_hwpar;
-      snd_pcm_sw_params_t*   _play_swpar;
-      unsigned int           _play_nchan;
-      int                    _play_npfd;
-      struct pollfd          _pfd [MAXPFD];
-      snd_pcm_uframes_t      _capt_offs;
-      snd_pcm_uframes_t      _play_offs;
-      int                    _play_step;
-      char*                  _play_ptr [MAXPLAY];
-      int                    _stat;
-      int                    _pcnt;
-      bool                   _xrun;
-      clear_function         _clear_func;
-      play_function          _play_func;
-      bool                   mmappedInterface;
-
-      static char* clear_32le(char* dst, int step, int nfrm);
-      static char* clear_24le(char* dst, int step, int nfrm);
-      static char* clear_16le(char* dst, int step, int nfrm);
-      static char* play_32le(const float* src, char* dst, int step, int nfrm);
-      static char* play_24le(const float* src, char* dst, int step, int nfrm);
-      static char* play_16le(const float* src, char* dst, int step, int nfrm);
-      int playInit(snd_pcm_uframes_t len);
-      snd_pcm_sframes_t pcmWait();
-      snd_pcm_t* playHandle() const   { return _play_handle; }
-      void clearChan(int chan, snd_pcm_uframes_t len) {
-            _play_ptr[chan] = _clear_func(_play_ptr[chan], _play_step, len);
-            }
-
-    public:
-      AlsaDriver(QString, unsigned, snd_pcm_uframes_t, unsigned);
-      ~AlsaDriver();
-      bool init();
-      void printinfo();
-      bool pcmStart();
-      int pcmStop();
-      snd_pcm_uframes_t fsize() const { return _frsize;      }
-      unsigned int sampleRate() const { return _rate; }
-      void write(int n, float* l, float* r);
-      };
-
 //---------------------------------------------------------
 //   AlsaAudio
 //---------------------------------------------------------
@@ -132,8 +65,6 @@ class AlsaAudio : public Driver {
       void alsaLoop();
       void write(int n, void* l, void* r);
 
-      virtual void midiRead();
-
       virtual void registerPort(const QString& name, bool input, bool midi);
       virtual void unregisterPort(int);
       };
@@ -45,8 +45,8 @@ class AlsaMidiDriver : public MidiDriver {
       bool connect(Port src, Port dst);
 
    public:
-      AlsaMidiDriver(Seq* s);
-      virtual ~AlsaMidiDriver() {}
+      AlsaMidiDriver(SeqPlayer* s, MidiInput* in);
+      virtual ~AlsaMidiDriver() { stopInput(); }
       virtual bool init();
       virtual Port registerOutPort(const QString& name);
       virtual Port registerInPort(const QString& name);
@@ -0,0 +1,392 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "audiorender.h"
+#include "libmscore/score.h"
+#include "libmscore/part.h"
+#include "libmscore/mscore.h"
+#include "msynth/synti.h"
+#include "seq.h"
+
+//---------------------------------------------------------
+//   AudioRenderer
+//    renders the events of a score, or only those of one
+//    of its parts, into a temporary file of interleaved
+//    stereo float frames and records the peak
+//---------------------------------------------------------
+
+class AudioRenderer : public QThread {
+      Score* score;
+      const EventMap* events;
+      const Part* _part;            // 0: all parts
+      int sampleRate;               // of the export, not MScore::sampleRate
+      int endFrame;
+      MasterSynth* synti;
+      QTemporaryFile file;
+      float _peak;
+      bool _ok;
+      QAtomicInt _frames;           // rendered so far
+
+      virtual void run();
+
+   public:
+      AudioRenderer(Score*, const EventMap*, const Part*, int sr, int endFrame, int threads);
+      ~AudioRenderer()              { delete synti; }
+      bool open()                   { return file.open(); }
+      const Part* part() const      { return _part;   }
+      float peak() const            { return _peak;   }
+      bool ok() const               { return _ok;     }
+      int frames()                  { return _frames.fetchAndAddAcquire(0); }
+      const float* data();
+      };
+
+//---------------------------------------------------------
+//   AudioRenderer
+//    the synthesizer is set up here on the gui thread
+//---------------------------------------------------------
+
+AudioRenderer::AudioRenderer(Score* s, const EventMap* ev, const Part* p, int sr, int ef, int threads)
+   : file(QDir::tempPath() + QString("/audioXXXXXX.raw"))
+      {
+      score      = s;
+      events     = ev;
+      _part      = p;
+      sampleRate = sr;
+      endFrame   = ef;
+      _peak      = 0.0;
+      _ok        = false;
+      synti      = new MasterSynth();
+      synti->init(sampleRate);
+      synti->setOffline(true);
+      synti->setRenderThreads(threads);
+      synti->setState(score->syntiState());
+      synti->setGain(1.0);
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void AudioRenderer::run()
+      {
+      //
+      // init instruments
+      //
+      foreach(const Part* part, *score->parts()) {
+            if (_part && part != _part)
+                  continue;
+            foreach(const Channel& a, part->instr()->channel()) {
+                  a.updateInitList();
+                  foreach(Event e, a.init) {
+                        if (e.type() == ME_INVALID)
+                              continue;
+                        e.setChannel(a.channel);
+                        int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
+                        synti->play(e, syntiIdx);
+                        }
+                  }
+            }
+
+      static const unsigned FRAMES = 512;
+      float buffer[FRAMES * 2];
+      float b[FRAMES * 2];
+      int playTime = 0;
+      EventMap::const_iterator playPos = events->constBegin();
+
+      for (;;) {
+            unsigned frames = FRAMES;
+            //
+            // collect events for one segment
+            //
+            memset(buffer, 0, sizeof(float) * FRAMES * 2);
+            int endTime = playTime + frames;
+            float* l = buffer;
+            float* r = buffer + FRAMES;
+            for (; playPos != events->constEnd(); ++playPos) {
+                  int f = score->utick2utime(playPos.key()) * sampleRate;
+                  if (f >= endTime)
+                        break;
+                  int n = f - playTime;
+                  synti->process(n, l, r);
+
+                  l         += n;
+                  r         += n;
+                  playTime  += n;
+                  frames    -= n;
+                  const Event& e = playPos.value();
+                  if (e.isChannelEvent()) {
+                        MidiMapping* mm = score->midiMapping(e.channel());
+                        if (_part && mm->part != _part)
+                              continue;
+                        Channel* c = mm->articulation;
+                        if (!c->mute) {
+                              synti->play(e, c->synti);
+                              }
+                        }
+                  }
+            if (frames) {
+                  synti->process(frames, l, r);
+                  playTime += frames;
+                  }
+            float* dp  = b;
+            float* spl = buffer;
+            float* spr = buffer + FRAMES;
+            for (unsigned i = 0; i < FRAMES; ++i) {
+                  if (qAbs(*spl) > _peak)
+                        _peak = qAbs(*spl);
+                  if (qAbs(*spr) > _peak)
+                        _peak = qAbs(*spr);
+                  *dp++ = *spl++;
+                  *dp++ = *spr++;
+                  }
+            if (file.write((const char*)b, sizeof(b)) != sizeof(b)) {
+                  qDebug("AudioRenderer: write failed: %s\n", qPrintable(file.errorString()));
+                  _frames.fetchAndStoreRelease(endFrame);
+                  return;
+                  }
+            playTime = endTime;
+            _frames.fetchAndStoreRelease(playTime);
+            if (playTime >= endFrame)
+                  break;
+            }
+      _ok = file.flush();
+      }
+
+//---------------------------------------------------------
+//   data
+//    map the rendered frames
+//---------------------------------------------------------
+
+const float* AudioRenderer::data()
+      {
+      return (const float*)file.map(0, file.size());
+      }
+
+//---------------------------------------------------------
+//   mixPeak
+//---------------------------------------------------------
+
+static float mixPeak(const QList<const float*>& src, int frames)
+      {
+      float peak = 0.0;
+      for (int i = 0; i < frames * 2; ++i) {
+            float v = 0.0;
+            foreach(const float* sp, src)
+                  v += sp[i];
+            if (qAbs(v) > peak)
+                  peak = qAbs(v);
+            }
+      return peak;
+      }
+
+//---------------------------------------------------------
+//   EncoderThread
+//---------------------------------------------------------
+
+EncoderThread::EncoderThread(AudioEncoder* e)
+   : freeBlocks(BLOCKS)
+      {
+      encoder  = e;
+      blocks   = new float[BLOCKS * FRAMES * 2];
+      writeIdx = 0;
+      readIdx  = 0;
+      _ok      = true;
+      }
+
+EncoderThread::~EncoderThread()
+      {
+      delete[] blocks;
+      }
+
+//---------------------------------------------------------
+//   block
+//    the next free block, waits for the encoder if the
+//    queue is full
+//---------------------------------------------------------
+
+float* EncoderThread::block()
+      {
+      freeBlocks.acquire();
+      return blocks + writeIdx * FRAMES * 2;
+      }
+
+//---------------------------------------------------------
+//   push
+//    queue n frames of the block returned by block();
+//    n == 0 ends the stream
+//---------------------------------------------------------
+
+void EncoderThread::push(int n)
+      {
+      size[writeIdx] = n;
+      writeIdx = (writeIdx + 1) % BLOCKS;
+      usedBlocks.release();
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void EncoderThread::run()
+      {
+      for (;;) {
+            usedBlocks.acquire();
+            int n = size[readIdx];
+            if (n == 0)
+                  break;
+            // after an error the queue is drained to not block
+            // the producer
+            if (_ok && !encoder->write(blocks + readIdx * FRAMES * 2, n))
+                  _ok = false;
+            readIdx = (readIdx + 1) % BLOCKS;
+            freeBlocks.release();
+            _frames.fetchAndAddRelease(n);
+            }
+      if (!encoder->close())
+            _ok = false;
+      }
+
+//---------------------------------------------------------
+//   renderAudio
+//    Render the score once into float temp files, then
+//    feed the normalized frames to the encoders. Every
+//    encoder runs in its own thread, overlapping with the
+//    mixing on the calling thread. With stems every part
+//    is rendered by its own synthesizer in parallel and
+//    encoded separately with the gain of the mix.
+//    The progress bar is only updated from the calling
+//    thread.
+//---------------------------------------------------------
+
+bool renderAudio(Score* score, int sampleRate, AudioEncoder* mix,
+   const QList<AudioEncoder*>& stems, QProgressBar* pBar)
+      {
+      EventMap events;
+      score->toEList(&events);
+      if (events.isEmpty())
+            return false;
+
+      EventMap::const_iterator endPos = events.constEnd();
+      --endPos;
+      const int et = (score->utick2utime(endPos.key()) + 1) * sampleRate;
+
+      QList<AudioRenderer*> renderers;
+      if (!stems.isEmpty()) {
+            int threads = qMax(1, QThread::idealThreadCount() / score->parts()->size());
+            foreach(const Part* part, *score->parts())
+                  renderers.append(new AudioRenderer(score, &events, part, sampleRate, et, threads));
+            }
+      else
+            renderers.append(new AudioRenderer(score, &events, 0, sampleRate, et, QThread::idealThreadCount()));
+
+      bool ok = true;
+      foreach(AudioRenderer* r, renderers) {
+            if (!r->open()) {
+                  qDebug("renderAudio: cannot create temporary file\n");
+                  ok = false;
+                  }
+            }
+      if (!ok) {
+            qDeleteAll(renderers);
+            return false;
+            }
+
+      if (pBar) {
+            pBar->reset();
+            pBar->setRange(0, 2 * et);
+            }
+
+      foreach(AudioRenderer* r, renderers)
+            r->start();
+      foreach(AudioRenderer* r, renderers) {
+            while (!r->wait(100)) {
+                  int frames = et;
+                  foreach(AudioRenderer* rr, renderers)
+                        frames = qMin(frames, rr->frames());
+                  if (pBar)
+                        pBar->setValue(frames);
+                  }
+            }
+
+      int frames = et;
+      QList<const float*> data;
+      foreach(AudioRenderer* r, renderers) {
+            const float* d = r->ok() ? r->data() : 0;
+            if (d == 0) {
+                  qDeleteAll(renderers);
+                  return false;
+                  }
+            frames = qMin(frames, r->frames());
+            data.append(d);
+            }
+      float peak = data.size() == 1 ? renderers[0]->peak() : mixPeak(data, frames);
+      float gain = peak > 0.0 ? 0.99 / peak : 1.0;
+
+      QList<EncoderThread*> encoders;
+      encoders.append(new EncoderThread(mix));
+      foreach(AudioEncoder* e, stems)
+            encoders.append(new EncoderThread(e));
+      foreach(EncoderThread* e, encoders)
+            e->start();
+
+      const int FRAMES = EncoderThread::FRAMES;
+      for (int pos = 0; pos < frames; pos += FRAMES) {
+            int n = qMin(FRAMES, frames - pos);
+
+            float* b = encoders[0]->block();
+            const float* sp = data[0] + pos * 2;
+            for (int i = 0; i < n * 2; ++i)
+                  b[i] = sp[i];
+            for (int k = 1; k < data.size(); ++k) {
+                  sp = data[k] + pos * 2;
+                  for (int i = 0; i < n * 2; ++i)
+                        b[i] += sp[i];
+                  }
+            for (int i = 0; i < n * 2; ++i)
+                  b[i] *= gain;
+            encoders[0]->push(n);
+
+            for (int k = 0; k < stems.size(); ++k) {
+                  b  = encoders[k + 1]->block();
+                  sp = data[k] + pos * 2;
+                  for (int i = 0; i < n * 2; ++i)
+                        b[i] = sp[i] * gain;
+                  encoders[k + 1]->push(n);
+                  }
+            if (pBar && (pos % (FRAMES * 64)) == 0) {
+                  int encoded = frames;
+                  foreach(EncoderThread* e, encoders)
+                        encoded = qMin(encoded, e->frames());
+                  pBar->setValue(et + encoded);
+                  }
+            }
+      foreach(EncoderThread* e, encoders) {
+            e->block();
+            e->push(0);
+            }
+      foreach(EncoderThread* e, encoders) {
+            e->wait();
+            ok = ok && e->ok();
+            }
+      qDeleteAll(encoders);
+      qDeleteAll(renderers);
+      return ok;
+      }
+
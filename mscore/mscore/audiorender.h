@@ -0,0 +1,79 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __AUDIORENDER_H__
+#define __AUDIORENDER_H__
+
+class Score;
+class Part;
+class QProgressBar;
+
+//---------------------------------------------------------
+//   AudioEncoder
+//    sink for interleaved stereo float frames; write()
+//    and close() are called on an encoder thread
+//---------------------------------------------------------
+
+class AudioEncoder {
+   public:
+      virtual ~AudioEncoder() {}
+      virtual bool write(const float* frames, int n) = 0;
+      virtual bool close() = 0;
+      };
+
+//---------------------------------------------------------
+//   EncoderThread
+//    drains a bounded queue of blocks into an encoder;
+//    push() blocks while the queue is full
+//---------------------------------------------------------
+
+class EncoderThread : public QThread {
+   public:
+      static const int FRAMES = 512;      // frames per block
+
+   private:
+      static const int BLOCKS = 32;
+
+      AudioEncoder* encoder;
+      float* blocks;
+      int size[BLOCKS];
+      int writeIdx;
+      int readIdx;
+      QSemaphore freeBlocks;
+      QSemaphore usedBlocks;
+      QAtomicInt _frames;           // encoded so far
+      bool _ok;
+
+      virtual void run();
+
+   public:
+      EncoderThread(AudioEncoder*);
+      ~EncoderThread();
+      float* block();
+      void push(int n);
+      int frames()                  { return _frames.fetchAndAddAcquire(0); }
+      bool ok() const               { return _ok; }
+      };
+
+extern bool renderAudio(Score*, int sampleRate, AudioEncoder* mix,
+   const QList<AudioEncoder*>& stems, QProgressBar*);
+
+#endif
+
@@ -0,0 +1,196 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "audiostats.h"
+
+//---------------------------------------------------------
+//   atomicMax
+//    there is only one writer, the audio thread
+//---------------------------------------------------------
+
+static inline void atomicMax(QAtomicInt& a, int val)
+      {
+      if (val > a.fetchAndAddRelaxed(0))
+            a.fetchAndStoreRelaxed(val);
+      }
+
+//---------------------------------------------------------
+//   AudioStats
+//---------------------------------------------------------
+
+AudioStats::AudioStats()
+      {
+      cycleStart = 0;
+      clock.start();
+      reset();
+      }
+
+//---------------------------------------------------------
+//   endCycle
+//    the callback started with beginCycle() produced
+//    frames; the deadline is the duration of the frames
+//---------------------------------------------------------
+
+void AudioStats::endCycle(int frames, int sampleRate)
+      {
+      qint64 t        = clock.nsecsElapsed() - cycleStart;
+      qint64 deadline = qint64(frames) * 1000000000LL / qMax(sampleRate, 1);
+      int load        = deadline ? int(qMin(t * 1000 / deadline, qint64(1000000))) : 0;
+
+      _load.fetchAndStoreRelaxed(load);
+      atomicMax(_maxLoad, load);
+      loadHist[qMin(load / AudioStatsData::LOAD_STEP, int(AudioStatsData::LOAD_BINS) - 1)].fetchAndAddRelaxed(1);
+      if (load > 1000)
+            _misses.fetchAndAddRelaxed(1);
+      _cycles.fetchAndAddRelaxed(1);
+      }
+
+//---------------------------------------------------------
+//   voices
+//    number of voices sounding in the last block
+//---------------------------------------------------------
+
+void AudioStats::voices(int n)
+      {
+      _voices.fetchAndStoreRelaxed(n);
+      atomicMax(_maxVoices, n);
+      voiceHist[qMin(n / AudioStatsData::VOICE_STEP, int(AudioStatsData::VOICE_BINS) - 1)].fetchAndAddRelaxed(1);
+      }
+
+//---------------------------------------------------------
+//   get
+//---------------------------------------------------------
+
+void AudioStats::get(AudioStatsData* d)
+      {
+      d->cycles    = _cycles.fetchAndAddRelaxed(0);
+      d->misses    = _misses.fetchAndAddRelaxed(0);
+      d->xruns     = _xruns.fetchAndAddRelaxed(0);
+      d->dropped   = _dropped.fetchAndAddRelaxed(0);
+      d->load      = _load.fetchAndAddRelaxed(0);
+      d->maxLoad   = _maxLoad.fetchAndAddRelaxed(0);
+      d->voices    = _voices.fetchAndAddRelaxed(0);
+      d->maxVoices = _maxVoices.fetchAndAddRelaxed(0);
+      for (int i = 0; i < AudioStatsData::LOAD_BINS; ++i)
+            d->loadHist[i] = loadHist[i].fetchAndAddRelaxed(0);
+      for (int i = 0; i < AudioStatsData::VOICE_BINS; ++i)
+            d->voiceHist[i] = voiceHist[i].fetchAndAddRelaxed(0);
+      }
+
+//---------------------------------------------------------
+//   reset
+//    called from the gui; an update of the audio thread
+//    which runs at the same time may get lost
+//---------------------------------------------------------
+
+void AudioStats::reset()
+      {
+      _cycles.fetchAndStoreRelaxed(0);
+      _misses.fetchAndStoreRelaxed(0);
+      _xruns.fetchAndStoreRelaxed(0);
+      _dropped.fetchAndStoreRelaxed(0);
+      _load.fetchAndStoreRelaxed(0);
+      _maxLoad.fetchAndStoreRelaxed(0);
+      _voices.fetchAndStoreRelaxed(0);
+      _maxVoices.fetchAndStoreRelaxed(0);
+      for (int i = 0; i < AudioStatsData::LOAD_BINS; ++i)
+            loadHist[i].fetchAndStoreRelaxed(0);
+      for (int i = 0; i < AudioStatsData::VOICE_BINS; ++i)
+            voiceHist[i].fetchAndStoreRelaxed(0);
+      }
+
+//---------------------------------------------------------
+//   dump
+//    write a report to path
+//---------------------------------------------------------
+
+bool AudioStats::dump(const QString& path)
+      {
+      QFile f(path);
+      if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+            return false;
+      AudioStatsData d;
+      get(&d);
+      f.write(d.report().toUtf8());
+      return f.error() == QFile::NoError;
+      }
+
+//---------------------------------------------------------
+//   averageLoad
+//    estimated from the histogram, in permille
+//---------------------------------------------------------
+
+int AudioStatsData::averageLoad() const
+      {
+      qint64 sum = 0;
+      qint64 n   = 0;
+      for (int i = 0; i < LOAD_BINS; ++i) {
+            sum += qint64(loadHist[i]) * (i * LOAD_STEP + LOAD_STEP / 2);
+            n   += loadHist[i];
+            }
+      return n ? sum / n : 0;
+      }
+
+//---------------------------------------------------------
+//   report
+//    the counters and histograms as text
+//---------------------------------------------------------
+
+QString AudioStatsData::report() const
+      {
+      QString s;
+      s += QString("callbacks        %1\n").arg(cycles);
+      s += QString("deadline misses  %1\n").arg(misses);
+      s += QString("xruns            %1\n").arg(xruns);
+      s += QString("dropped events   %1\n").arg(dropped);
+      s += QString("load             %1% avg %2% max\n")
+         .arg(averageLoad() / 10.0, 0, 'f', 1).arg(maxLoad / 10.0, 0, 'f', 1);
+      s += QString("voices           %1 max\n").arg(maxVoices);
+
+      int n = 0;
+      for (int i = 0; i < LOAD_BINS; ++i)
+            n = qMax(n, loadHist[i]);
+      s += "\nload (percent of the buffer deadline)\n";
+      for (int i = 0; i < LOAD_BINS; ++i) {
+            if (loadHist[i] == 0)
+                  continue;
+            QString range = i == LOAD_BINS - 1
+               ? QString(">= %1%").arg(i * LOAD_STEP / 10)
+               : QString("%1-%2%").arg(i * LOAD_STEP / 10, 3).arg((i + 1) * LOAD_STEP / 10, 3);
+            s += QString("  %1 %2 %3\n").arg(range, -9).arg(loadHist[i], 9)
+               .arg(QString(qMax(1, loadHist[i] * 40 / n), '#'));
+            }
+
+      n = 0;
+      for (int i = 0; i < VOICE_BINS; ++i)
+            n = qMax(n, voiceHist[i]);
+      s += "\nvoices\n";
+      for (int i = 0; i < VOICE_BINS; ++i) {
+            if (voiceHist[i] == 0)
+                  continue;
+            QString range = i == VOICE_BINS - 1
+               ? QString(">= %1").arg(i * VOICE_STEP)
+               : QString("%1-%2").arg(i * VOICE_STEP, 3).arg((i + 1) * VOICE_STEP - 1, 3);
+            s += QString("  %1 %2 %3\n").arg(range, -9).arg(voiceHist[i], 9)
+               .arg(QString(qMax(1, voiceHist[i] * 40 / n), '#'));
+            }
+      return s;
+      }
+
@@ -0,0 +1,89 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __AUDIOSTATS_H__
+#define __AUDIOSTATS_H__
+
+//---------------------------------------------------------
+//   AudioStatsData
+//    a copy of the counters; load is in permille of
+//    the buffer deadline
+//---------------------------------------------------------
+
+struct AudioStatsData {
+      enum {
+            LOAD_BINS  = 32,        // 5% of the deadline per bin, the last bin
+            LOAD_STEP  = 50,        //   counts everything above 155%
+            VOICE_BINS = 33,        // 8 voices per bin
+            VOICE_STEP = 8
+            };
+      int cycles;
+      int misses;                   // callbacks which took longer than the deadline
+      int xruns;                    // reported by the driver
+      int dropped;                  // events the synthesizer could not queue
+      int load;                     // of the last callback
+      int maxLoad;
+      int voices;                   // of the last block
+      int maxVoices;
+      int loadHist[LOAD_BINS];
+      int voiceHist[VOICE_BINS];
+
+      int averageLoad() const;
+      QString report() const;
+      };
+
+//---------------------------------------------------------
+//   AudioStats
+//    audio callback telemetry. beginCycle(), endCycle()
+//    voices() and dropped() are called by the audio thread,
+//    xrun() may be called from a driver thread; the gui reads a
+//    copy with get(). No locks are taken.
+//---------------------------------------------------------
+
+class AudioStats {
+      QElapsedTimer clock;
+      qint64 cycleStart;            // audio thread only
+
+      QAtomicInt _cycles;
+      QAtomicInt _misses;
+      QAtomicInt _xruns;
+      QAtomicInt _dropped;
+      QAtomicInt _load;
+      QAtomicInt _maxLoad;
+      QAtomicInt _voices;
+      QAtomicInt _maxVoices;
+      QAtomicInt loadHist[AudioStatsData::LOAD_BINS];
+      QAtomicInt voiceHist[AudioStatsData::VOICE_BINS];
+
+   public:
+      AudioStats();
+      void beginCycle()             { cycleStart = clock.nsecsElapsed(); }
+      void endCycle(int frames, int sampleRate);
+      void voices(int n);
+      void xrun(int n = 1)          { _xruns.fetchAndAddRelaxed(n); }
+      void dropped(int n)           { _dropped.fetchAndAddRelaxed(n); }
+
+      void get(AudioStatsData*);
+      void reset();
+      bool dump(const QString& path);
+      };
+
+#endif
+
@@ -21,10 +21,11 @@
 #ifndef __DRIVER_H__
 #define __DRIVER_H__
 
-class Seq;
+class SeqPlayer;
 struct MidiPatch;
 class Synth;
 class Event;
+class Score;
 
 //---------------------------------------------------------
 //   Driver
@@ -33,10 +34,10 @@ class Event;
 class Driver {
 
    protected:
-      Seq* seq;
+      SeqPlayer* seq;
 
    public:
-      Driver(Seq* s)    { seq = s; }
+      Driver(SeqPlayer* s) { seq = s; }
       virtual ~Driver() {}
       virtual bool init() = 0;
       virtual bool start() = 0;
@@ -49,7 +50,15 @@ class Driver {
       virtual void registerPort(const QString& name, bool input, bool midi) = 0;
       virtual void unregisterPort(int) = 0;
       virtual void putEvent(const Event&, unsigned /*framePos*/) {}
-      virtual void midiRead() {}
+
+      // transport position in frames shared with other
+      // applications, -1 if there is none; audio thread
+      virtual int transportFrame()            { return -1; }
+      virtual void seekTransport(int /*frame*/) {}
+
+      // the parts of the score changed, for drivers with
+      // outputs per part; gui thread
+      virtual void updateOutputPorts(Score*)  {}
       };
 
 #endif
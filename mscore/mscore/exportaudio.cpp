@@ -32,9 +32,87 @@
 #include "preferences.h"
 #include "seq.h"
 #include "libmscore/mscore.h"
+#include "audiorender.h"
+
+//---------------------------------------------------------
+//   SndfileEncoder
+//---------------------------------------------------------
+
+class SndfileEncoder : public AudioEncoder {
+      SNDFILE* sf;
+
+   public:
+      SndfileEncoder() : sf(0) {}
+      ~SndfileEncoder()       { close(); }
+      bool open(const QString& name, int format, int sampleRate);
+      virtual bool write(const float* frames, int n);
+      virtual bool close();
+      };
+
+//---------------------------------------------------------
+//   open
+//---------------------------------------------------------
+
+bool SndfileEncoder::open(const QString& name, int format, int sampleRate)
+      {
+      SF_INFO info;
+      memset(&info, 0, sizeof(info));
+      info.channels   = 2;
+      info.samplerate = sampleRate;
+      info.format     = format;
+      sf              = sf_open(qPrintable(name), SFM_WRITE, &info);
+      if (sf == 0) {
+            qDebug("open soundfile failed: %s\n", sf_strerror(sf));
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+bool SndfileEncoder::write(const float* frames, int n)
+      {
+      return sf_writef_float(sf, frames, n) == n;
+      }
+
+//---------------------------------------------------------
+//   close
+//---------------------------------------------------------
+
+bool SndfileEncoder::close()
+      {
+      if (sf == 0)
+            return true;
+      int rv = sf_close(sf);
+      sf = 0;
+      if (rv) {
+            qDebug("close soundfile failed\n");
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   stemName
+//    file name for the stem of part
+//---------------------------------------------------------
+
+static QString stemName(const QString& name, const Part* part, int idx)
+      {
+      QFileInfo fi(name);
+      QString pn = part->partName();
+      pn.replace(QRegExp("[^\\w\\d]+"), "_");
+      if (pn.isEmpty())
+            pn = QString("part%1").arg(idx + 1);
+      return fi.path() + "/" + fi.completeBaseName() + "-" + pn + "." + fi.suffix();
+      }
 
 //---------------------------------------------------------
 //   saveAudio
+//    With exportAudioStems every part is additionally
+//    written to its own file.
 //---------------------------------------------------------
 
 bool MuseScore::saveAudio(Score* score, const QString& name, const QString& ext)
@@ -52,126 +130,26 @@ bool MuseScore::saveAudio(Score* score, const QString& name, const QString& ext)
             }
       int sampleRate = preferences.exportAudioSampleRate;
 
-      MasterSynth* synti = new MasterSynth();
-      synti->init(sampleRate);
-      synti->setState(score->syntiState());
-
-      EventMap events;
-      score->toEList(&events);
-
-      SF_INFO info;
-      memset(&info, 0, sizeof(info));
-      info.channels   = 2;
-      info.samplerate = sampleRate;
-      info.format     = format;
-      SNDFILE* sf     = sf_open(qPrintable(name), SFM_WRITE, &info);
-      if (sf == 0) {
-            qDebug("open soundfile failed: %s\n", sf_strerror(sf));
-            delete synti;
-            return false;
-            }
-
-      QProgressBar* pBar = showProgressBar();
-      pBar->reset();
-
-      double peak = 0.0;
-      double gain = 1.0;
-      EventMap::const_iterator endPos = events.constEnd();
-      --endPos;
-      const int et = (score->utick2utime(endPos.key()) + 1) * MScore::sampleRate;
-      for (int pass = 0; pass < 2; ++pass) {
-            EventMap::const_iterator playPos;
-            playPos = events.constBegin();
-            pBar->setRange(0, et);
-
-            //
-            // init instruments
-            //
+      SndfileEncoder mix;
+      QList<AudioEncoder*> stems;
+      bool ok = mix.open(name, format, sampleRate);
+      if (ok && preferences.exportAudioStems && score->parts()->size() > 1) {
+            int idx = 0;
             foreach(const Part* part, *score->parts()) {
-                  foreach(const Channel& a, part->instr()->channel()) {
-                        a.updateInitList();
-                        foreach(Event e, a.init) {
-                              if (e.type() == ME_INVALID)
-                                    continue;
-                              e.setChannel(a.channel);
-                              int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
-                              synti->play(e, syntiIdx);
-                              }
-                        }
-                  }
-
-            static const unsigned FRAMES = 512;
-            float buffer[FRAMES * 2];
-            int playTime = 0;
-            synti->setGain(gain);
-
-            for (;;) {
-                  unsigned frames = FRAMES;
-                  //
-                  // collect events for one segment
-                  //
-                  memset(buffer, 0, sizeof(float) * FRAMES * 2);
-                  int endTime = playTime + frames;
-                  float* l = buffer;
-                  float* r = buffer + FRAMES;
-                  for (; playPos != events.constEnd(); ++playPos) {
-                        int f = score->utick2utime(playPos.key()) * MScore::sampleRate;
-                        if (f >= endTime)
-                              break;
-                        int n = f - playTime;
-                        synti->process(n, l, r);
-
-                        l         += n;
-                        r         += n;
-                        playTime  += n;
-                        frames    -= n;
-                        const Event& e = playPos.value();
-                        if (e.isChannelEvent()) {
-                              int channelIdx = e.channel();
-                              Channel* c = score->midiMapping(channelIdx)->articulation;
-                              if (!c->mute) {
-                                    synti->play(e, c->synti);
-                                    }
-                              }
-                        }
-                  if (frames) {
-                        synti->process(frames, l, r);
-                        playTime += frames;
-                        }
-                  if (pass == 1) {
-                        float b[FRAMES * 2];
-                        float* dp = b;
-                        float* spl = buffer;
-                        float* spr = buffer + FRAMES;
-                        for (unsigned i = 0; i < FRAMES; ++i) {
-                              *dp++ = *spl++;
-                              *dp++ = *spr++;
-                              }
-                        sf_writef_float(sf, b, FRAMES);
-                        }
-                  else {
-                        for (unsigned i = 0; i < FRAMES * 2; ++i) {
-                              if (qAbs(buffer[i]) > peak)
-                                    peak = qAbs(buffer[i]);
-                              }
-                        }
-                  playTime = endTime;
-                  pBar->setValue(playTime);
-                  if (playTime >= et)
+                  SndfileEncoder* e = new SndfileEncoder;
+                  stems.append(e);
+                  if (!e->open(stemName(name, part, idx++), format, sampleRate)) {
+                        ok = false;
                         break;
+                        }
                   }
-            gain = 0.99 / peak;
             }
-
-      hideProgressBar();
-
-      delete synti;
-      if (sf_close(sf)) {
-            qDebug("close soundfile failed\n");
-            return false;
+      if (ok) {
+            ok = renderAudio(score, sampleRate, &mix, stems, showProgressBar());
+            hideProgressBar();
             }
-
-      return true;
+      qDeleteAll(stems);
+      return ok;
       }
 
 #endif // HAS_AUDIOFILE
@@ -27,6 +27,7 @@
 #include "preferences.h"
 #include "seq.h"
 #include "exportmp3.h"
+#include "audiorender.h"
 
 //---------------------------------------------------------
 //   MP3Exporter
@@ -604,6 +605,66 @@ QString MP3Exporter::getLibraryTypeString()
 #endif //mac
 
 
+//---------------------------------------------------------
+//   Mp3Encoder
+//    feeds the frames of renderAudio() to lame
+//---------------------------------------------------------
+
+class Mp3Encoder : public AudioEncoder {
+      MP3Exporter* exporter;
+      QFile* file;
+      unsigned char* bufferOut;
+      float bufferL[EncoderThread::FRAMES];
+      float bufferR[EncoderThread::FRAMES];
+      int _error;
+
+   public:
+      Mp3Encoder(MP3Exporter*, QFile*);
+      ~Mp3Encoder()           { delete[] bufferOut; }
+      virtual bool write(const float* frames, int n);
+      virtual bool close();
+      int error() const       { return _error; }
+      };
+
+Mp3Encoder::Mp3Encoder(MP3Exporter* e, QFile* f)
+      {
+      exporter  = e;
+      file      = f;
+      bufferOut = new unsigned char[exporter->getOutBufferSize()];
+      _error    = 0;
+      }
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+bool Mp3Encoder::write(const float* frames, int n)
+      {
+      for (int i = 0; i < n; ++i) {
+            bufferL[i] = *frames++;
+            bufferR[i] = *frames++;
+            }
+      // blocks are never larger than a lame chunk
+      int bytes = exporter->encodeRemainder(bufferL, bufferR, n, bufferOut);
+      if (bytes < 0) {
+            _error = bytes;
+            return false;
+            }
+      return file->write((const char*)bufferOut, bytes) == bytes;
+      }
+
+//---------------------------------------------------------
+//   close
+//---------------------------------------------------------
+
+bool Mp3Encoder::close()
+      {
+      int bytes = exporter->finishStream(bufferOut);
+      if (bytes > 0)
+            return file->write((const char*)bufferOut, bytes) == bytes;
+      return true;
+      }
+
 //---------------------------------------------------------
 //   saveMp3
 //---------------------------------------------------------
@@ -663,10 +724,6 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
             return false;
             }
 
-      int bufferSize = exporter.getOutBufferSize();
-      unsigned char *bufferOut = new unsigned char[bufferSize];
-      long bytes; // output length
-
       QFile file(name);
       if(! file.open(QIODevice::WriteOnly)) {
             if(!noGui)
@@ -677,138 +734,16 @@ bool MuseScore::saveMp3(Score* score, const QString& name)
             return false;
             }
 
-      QDataStream out(&file);
-
-      MasterSynth* synti = new MasterSynth();
-      synti->init(sampleRate);
-      synti->setState(score->syntiState());
-
-      EventMap events;
-      score->toEList(&events);
-
-      QProgressBar* pBar = showProgressBar();
-      pBar->reset();
-
-      double peak = 0.0;
-      double gain = 1.0;
-      for (int pass = 0; pass < 2; ++pass) {
-            EventMap::const_iterator playPos;
-            playPos = events.constBegin();
-            EventMap::const_iterator endPos = events.constEnd();
-            --endPos;
-            double et = score->utick2utime(endPos.key());
-            et += 1.0;   // add trailer (sec)
-            pBar->setRange(0, int(et));
-
-            //
-            // init instruments
-            //
-            foreach(const Part* part, *score->parts()) {
-                  foreach(const Channel& a, part->instr()->channel()) {
-                        a.updateInitList();
-                        foreach(Event e, a.init) {
-                              if (e.type() == ME_INVALID)
-                                    continue;
-                              e.setChannel(a.channel);
-                              int syntiIdx= score->midiMapping(a.channel)->articulation->synti;
-                              synti->play(e, syntiIdx);
-                              }
-                        }
-                  }
-
-            int FRAMES = 512;
-            float bufferL[FRAMES];
-            float bufferR[FRAMES];
-            double playTime = 0.0;
-            synti->setGain(gain);
-
-            for (;;) {
-                  unsigned frames = FRAMES;
-                  //
-                  // collect events for one segment
-                  //
-                  memset(bufferL, 0, sizeof(float) * FRAMES);
-                  memset(bufferR, 0, sizeof(float) * FRAMES);
-                  double endTime = playTime + double(frames)/double(sampleRate);
-                  float* l = bufferL;
-                  float* r = bufferR;
-                  for (; playPos != events.constEnd(); ++playPos) {
-                        double f = score->utick2utime(playPos.key());
-                        if (f >= endTime)
-                              break;
-                        int n = lrint((f - playTime) * sampleRate);
-                        synti->process(n, l, r);
-
-                        l         += n;
-                        r         += n;
-                        playTime += double(n)/double(sampleRate);
-                        frames    -= n;
-                        const Event& e = playPos.value();
-                        if (e.isChannelEvent()) {
-                              int channelIdx = e.channel();
-                              Channel* c = score->midiMapping(channelIdx)->articulation;
-                              if (!c->mute) {
-                                    synti->play(e, c->synti);
-                                    }
-                              }
-                        }
-                  if (frames) {
-                        synti->process(frames, l, r);
-                        playTime += double(frames)/double(sampleRate);
-                        }
-                  if (pass == 1) {
-                        if (FRAMES < inSamples) {
-                              if (channels > 1) {
-                                    bytes = exporter.encodeRemainder(bufferL, bufferR,  FRAMES , bufferOut);
-                                    }
-                              else {
-                                    bytes = exporter.encodeRemainderMono(bufferL,  FRAMES , bufferOut);
-                                    }
-                              }
-                              else {
-                                    if (channels > 1) {
-                                          bytes = exporter.encodeBuffer(bufferL, bufferR, bufferOut);
-                                          }
-                                    else {
-                                          bytes = exporter.encodeBufferMono(bufferL, bufferOut);
-                                          }
-                                    }
-                              if (bytes < 0) {
-                                    if(!noGui)
-                                          QMessageBox::warning(0,
-                                           tr("Encoding error"),
-                                           tr("Error %1 returned from MP3 encoder").arg(bytes),
-                                           QString::null, QString::null);
-                                    break;
-                                    }
-                              for (unsigned j = 0; j < bytes; ++j)
-                                    out << bufferOut[j];
-                        }
-                  else {
-                        for (int i = 0; i < FRAMES; ++i) {
-                              if (qAbs(bufferL[i]) > peak)
-                                    peak = qAbs(bufferL[i]);
-                              if (qAbs(bufferR[i]) > peak)
-                                    peak = qAbs(bufferR[i]);
-                              }
-                        }
-                  playTime = endTime;
-                  pBar->setValue(int(playTime));
-                  if (playTime > et)
-                        break;
-                  }
-            gain = 0.99 / peak;
-            }
-
-      bytes = exporter.finishStream(bufferOut);
-      if (bytes) {
-            for (unsigned j = 0; j < bytes; ++j)
-                  out << bufferOut[j];
-            }
-
+      Mp3Encoder encoder(&exporter, &file);
+      QList<AudioEncoder*> stems;
+      bool ok = renderAudio(score, sampleRate, &encoder, stems, showProgressBar());
       hideProgressBar();
-      delete synti;
       file.close();
-      return true;
+      if (!ok && encoder.error() && !noGui)
+            QMessageBox::warning(0,
+               tr("Encoding error"),
+               tr("Error %1 returned from MP3 encoder").arg(encoder.error()),
+               QString::null, QString::null);
+      return ok;
       }
 
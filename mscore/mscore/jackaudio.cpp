@@ -25,7 +25,11 @@
 #include "msynth/synti.h"
 #include "musescore.h"
 #include "seq.h"
+#include "libmscore/score.h"
+#include "libmscore/part.h"
+#include "libmscore/instrument.h"
 
+#include <unistd.h>
 #include <jack/midiport.h>
 
 //---------------------------------------------------------
@@ -36,6 +40,7 @@ JackAudio::JackAudio(Seq* s)
    : Driver(s)
       {
       client = 0;
+      active = false;
       }
 
 //---------------------------------------------------------
@@ -50,6 +55,8 @@ JackAudio::~JackAudio()
                      strerror(errno));
                   }
             }
+      synti->setDirectOutputs(0, 0);
+      delete routing.fetchAndStoreOrdered(0);
       }
 
 //---------------------------------------------------------
@@ -155,6 +162,7 @@ bool JackAudio::start()
             qDebug("JACK: cannot activate client\n");
             return false;
             }
+      active = true;
       if (preferences.useJackAudio) {
             /* connect the ports. Note: you can't do this before
                the client is activated, because we can't allow
@@ -265,6 +273,9 @@ bool JackAudio::stop()
             qDebug("cannot deactivate client");
             return false;
             }
+      active = false;
+      // the next driver does not know the port buffers
+      synti->setDirectOutputs(0, 0);
       return true;
       }
 
@@ -318,6 +329,8 @@ static int graph_callback(void*)
 int JackAudio::processAudio(jack_nframes_t frames, void* p)
       {
       JackAudio* audio = (JackAudio*)p;
+      AudioStats* stats = audio->seq->audioStats();
+      stats->beginCycle();
       float* l;
       float* r;
       if (preferences.useJackAudio) {
@@ -364,7 +377,52 @@ int JackAudio::processAudio(jack_nframes_t frames, void* p)
                         }
                   }
             }
+      audio->routeParts(frames);
       audio->seq->process((unsigned)frames, l, r);
+      stats->endCycle(frames, MScore::sampleRate);
+      audio->cycles.fetchAndAddRelease(1);
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   routeParts
+//    clear the part ports and pass their buffers to the
+//    synthesizer as direct outputs of the channels
+//    realtime environment
+//---------------------------------------------------------
+
+void JackAudio::routeParts(jack_nframes_t frames)
+      {
+      PartRouting* pr = routing;
+      if (pr == 0) {
+            synti->setDirectOutputs(0, 0);
+            return;
+            }
+      int nports  = pr->ports.size();
+      float** pb  = pr->portBuffer.data();
+      for (int i = 0; i < nports; ++i) {
+            pb[i] = (float*)jack_port_get_buffer(pr->ports.at(i), frames);
+            memset(pb[i], 0, frames * sizeof(float));
+            }
+      int channels = pr->channelPort.size();
+      float** cb   = pr->channelBuffer.data();
+      for (int i = 0; i < channels; ++i) {
+            int port = pr->channelPort.at(i);
+            cb[i * 2]     = port >= 0 ? pb[port]     : 0;
+            cb[i * 2 + 1] = port >= 0 ? pb[port + 1] : 0;
+            }
+      synti->setDirectOutputs(cb, channels);
+      }
+
+//---------------------------------------------------------
+//   processXrun
+//    JACK callback
+//---------------------------------------------------------
+
+int JackAudio::processXrun(void* p)
+      {
+      JackAudio* audio = (JackAudio*)p;
+      audio->seq->audioStats()->xrun();
       return 0;
       }
 
@@ -407,6 +465,7 @@ bool JackAudio::init()
 
       jack_set_error_function(jackError);
       jack_set_process_callback(client, processAudio, this);
+      jack_set_xrun_callback(client, processXrun, this);
       //jack_on_shutdown(client, processShutdown, this);
       jack_set_buffer_size_callback(client, bufsize_callback, this);
       jack_set_sample_rate_callback(client, srate_callback, this);
@@ -578,11 +637,130 @@ void JackAudio::putEvent(const Event& e, unsigned framePos)
       }
 
 //---------------------------------------------------------
-//   midiRead
+//   transportFrame
+//    realtime environment
 //---------------------------------------------------------
 
-void JackAudio::midiRead()
+int JackAudio::transportFrame()
       {
-//      midiDriver->read();
+      jack_position_t pos;
+      jack_transport_query(client, &pos);
+      return pos.frame;
+      }
+
+//---------------------------------------------------------
+//   seekTransport
+//    realtime environment
+//---------------------------------------------------------
+
+void JackAudio::seekTransport(int frame)
+      {
+      if (jack_transport_locate(client, frame))
+            qDebug("JackAudio::seekTransport: locate %d failed\n", frame);
+      }
+
+//---------------------------------------------------------
+//   waitCycle
+//    wait until the audio thread finished a cycle and no
+//    longer uses a replaced routing
+//---------------------------------------------------------
+
+void JackAudio::waitCycle()
+      {
+      if (!active)
+            return;
+      int cycle = cycles.fetchAndAddAcquire(0);
+      for (int i = 0; i < 200 && cycles.fetchAndAddAcquire(0) == cycle; ++i)
+            usleep(5000);
+      }
+
+//---------------------------------------------------------
+//   updateOutputPorts
+//    register output ports for every part of the score
+//    and route its channels to them. The ports of parts
+//    which are still there are kept with their
+//    connections.
+//---------------------------------------------------------
+
+void JackAudio::updateOutputPorts(Score* score)
+      {
+      if (!preferences.useJackAudio || !preferences.jackPartPorts || client == 0)
+            return;
+      QList<PartPorts> oldPorts = partPorts;
+      partPorts.clear();
+      PartRouting* pr = new PartRouting;
+
+      if (score) {
+            const QList<Part*>* parts = score->parts();
+            QList<int> partPort;          // left port of every part in pr->ports, -1: none
+            foreach(Part* part, *parts) {
+                  // jack port names must not contain ':'
+                  QString base = part->partName().replace(':', '-');
+                  if (base.isEmpty())
+                        base = "part";
+                  QString name = base;
+                  for (int n = 2;; ++n) {
+                        bool used = false;
+                        foreach(const PartPorts& pp, partPorts)
+                              used = used || pp.name == name;
+                        if (!used)
+                              break;
+                        name = QString("%1-%2").arg(base).arg(n);
+                        }
+                  PartPorts pp;
+                  pp.name    = name;
+                  pp.port[0] = 0;
+                  pp.port[1] = 0;
+                  for (int i = 0; i < oldPorts.size(); ++i) {
+                        if (oldPorts[i].name == name) {
+                              pp = oldPorts.takeAt(i);
+                              break;
+                              }
+                        }
+                  if (pp.port[0] == 0) {
+                        pp.port[0] = jack_port_register(client, qPrintable(name + "-left"),
+                           JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+                        pp.port[1] = jack_port_register(client, qPrintable(name + "-right"),
+                           JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+                        if (pp.port[0] == 0 || pp.port[1] == 0) {
+                              qDebug("JackAudio::updateOutputPorts: cannot register ports for <%s>\n",
+                                 qPrintable(name));
+                              if (pp.port[0])
+                                    jack_port_unregister(client, pp.port[0]);
+                              if (pp.port[1])
+                                    jack_port_unregister(client, pp.port[1]);
+                              pp.port[0] = 0;
+                              pp.port[1] = 0;
+                              }
+                        }
+                  partPorts.append(pp);
+                  if (pp.port[0]) {
+                        partPort.append(pr->ports.size());
+                        pr->ports.append(pp.port[0]);
+                        pr->ports.append(pp.port[1]);
+                        }
+                  else
+                        partPort.append(-1);
+                  }
+            pr->channelPort.fill(-1, score->midiMapping()->size());
+            foreach(const MidiMapping& mm, *score->midiMapping()) {
+                  int idx = parts->indexOf(mm.part);
+                  int ch  = mm.articulation->channel;
+                  if (idx >= 0 && ch >= 0 && ch < pr->channelPort.size())
+                        pr->channelPort[ch] = partPort[idx];
+                  }
+            }
+      pr->portBuffer.resize(pr->ports.size());
+      pr->channelBuffer.resize(pr->channelPort.size() * 2);
+
+      PartRouting* old = routing.fetchAndStoreOrdered(pr);
+      waitCycle();
+      delete old;
+      foreach(const PartPorts& pp, oldPorts) {
+            if (pp.port[0]) {
+                  jack_port_unregister(client, pp.port[0]);
+                  jack_port_unregister(client, pp.port[1]);
+                  }
+            }
       }
 
@@ -29,8 +29,36 @@ class Synth;
 class Seq;
 class MidiDriver;
 
+//---------------------------------------------------------
+//   PartPorts
+//    the stereo output of a part
+//---------------------------------------------------------
+
+struct PartPorts {
+      QString name;
+      jack_port_t* port[2];
+      };
+
+//---------------------------------------------------------
+//   PartRouting
+//    the direct outputs of the channels, built by the gui
+//    thread and used by the audio thread
+//---------------------------------------------------------
+
+struct PartRouting {
+      QVector<jack_port_t*> ports;        // left and right port of every part
+      QVector<int> channelPort;           // left port of a channel, -1: main output
+      QVector<float*> portBuffer;         // buffers of the ports in this cycle
+      QVector<float*> channelBuffer;      // left and right buffer of every channel
+      };
+
 //---------------------------------------------------------
 //   JackAudio
+//    The synthesizer mixes directly into the buffers of
+//    the output ports. With preferences.jackPartPorts
+//    every part gets its own output ports with the dry
+//    signal of its channels; reverb and chorus stay on
+//    the main output.
 //---------------------------------------------------------
 
 class JackAudio : public Driver {
@@ -43,7 +71,15 @@ class JackAudio : public Driver {
       QList<jack_port_t*> midiOutputPorts;
       QList<jack_port_t*> midiInputPorts;
 
+      QList<PartPorts> partPorts;         // gui thread
+      QAtomicPointer<PartRouting> routing;
+      QAtomicInt cycles;                  // process cycles run
+      bool active;
+
       static int processAudio(jack_nframes_t, void*);
+      static int processXrun(void*);
+      void routeParts(jack_nframes_t);
+      void waitCycle();
 
    public:
       JackAudio(Seq*);
@@ -61,7 +97,9 @@ class JackAudio : public Driver {
       virtual int getState();
       virtual int sampleRate() const    { return jack_get_sample_rate(client); }
       virtual void putEvent(const Event&, unsigned framePos);
-      virtual void midiRead();
+      virtual int transportFrame();
+      virtual void seekTransport(int frame);
+      virtual void updateOutputPorts(Score*);
 
       virtual void registerPort(const QString& name, bool input, bool midi);
       virtual void unregisterPort(int);
@@ -27,10 +27,10 @@
 #include "config.h"
 #include "mididriver.h"
 #include "preferences.h"
-#include "musescore.h"
 #include "midifile.h"
+#include "midiinput.h"
 #include "globals.h"
-#include "seq.h"
+#include "seqplayer.h"
 #include "libmscore/utils.h"
 #include "libmscore/score.h"
 
@@ -105,8 +105,8 @@ static const unsigned int outCap = SND_SEQ_PORT_CAP_SUBS_WRITE;
 //   AlsaMidiDriver
 //---------------------------------------------------------
 
-AlsaMidiDriver::AlsaMidiDriver(Seq* s)
-   : MidiDriver(s)
+AlsaMidiDriver::AlsaMidiDriver(SeqPlayer* s, MidiInput* in)
+   : MidiDriver(s, in)
       {
       }
 
@@ -161,16 +161,7 @@ bool AlsaMidiDriver::init()
       for (int i = 0; i < preferences.midiPorts; ++i)
             midiOutPorts[i] = registerInPort(QString("MuseScore Port-%1").arg(i));
 
-      struct pollfd* pfd;
-      int npfd;
-      getInputPollFd(&pfd, &npfd);
-      for (int i = 0; i < npfd; ++i) {
-            int fd = pfd[i].fd;
-            if (fd != -1) {
-                  QSocketNotifier* s = new QSocketNotifier(fd, QSocketNotifier::Read,  mscore);
-                  s->connect(s, SIGNAL(activated(int)), seq, SLOT(midiInputReady()));
-                  }
-            }
+      startInput();
 #if 0
       // TODO: autoconnect all output ports
       QList<PortName> ol = outputPorts();
@@ -345,6 +336,7 @@ void AlsaMidiDriver::getOutputPollFd(struct pollfd** p, int* n)
 
 //---------------------------------------------------------
 //   read
+//    midi input thread
 //---------------------------------------------------------
 
 void AlsaMidiDriver::read()
@@ -355,23 +347,18 @@ void AlsaMidiDriver::read()
             if (rv < 0)
                   return;
 
-            if (!mscore || !mscore->midiinEnabled()) {
-                  snd_seq_free_event(ev);
-                  return;
-                  }
-
             if (ev->type == SND_SEQ_EVENT_NOTEON) {
                   int pitch = ev->data.note.note;
                   int velo  = ev->data.note.velocity;
-                  mscore->midiNoteReceived(ev->data.note.channel, pitch, velo);
+                  input->event(ME_NOTEON, ev->data.note.channel, pitch, velo);
                   }
             else if (ev->type == SND_SEQ_EVENT_NOTEOFF) {    // "Virtual Keyboard" sends this
                   int pitch = ev->data.note.note;
-                  mscore->midiNoteReceived(ev->data.note.channel, pitch, 0);
+                  input->event(ME_NOTEOFF, ev->data.note.channel, pitch, 0);
                   }
             else if (ev->type == SND_SEQ_EVENT_CONTROLLER) {
-                  mscore->midiCtrlReceived(ev->data.control.param,
-                     ev->data.control.value);
+                  input->event(ME_CONTROLLER, ev->data.control.channel,
+                     ev->data.control.param, ev->data.control.value);
                   }
 
             if (midiInputTrace) {
@@ -431,7 +418,7 @@ void AlsaMidiDriver::read()
 
 void AlsaMidiDriver::write(const Event& e)
       {
-      Score* cs = mscore->currentScore();
+      Score* cs = seq->score();
       int port  = cs->midiPort(e.channel());
       int chn   = cs->midiChannel(e.channel());
       int a     = e.dataA();
@@ -29,7 +29,9 @@
 #include "driver.h"
 
 class Event;
-class Seq;
+class SeqPlayer;
+class MidiInput;
+class MidiInputThread;
 
 //---------------------------------------------------------
 //    Port
@@ -60,17 +62,24 @@ class Port {
 //---------------------------------------------------------
 
 class MidiDriver {
+      MidiInputThread* inputThread;
+
    protected:
       Port midiInPort;
       Port* midiOutPorts;
-      Seq* seq;
+      SeqPlayer* seq;
+      MidiInput* input;                   // takes the events read()
+
+      void startInput();
+      void stopInput();
 
    public:
-      MidiDriver(Seq* s) { seq = s; }
-      virtual ~MidiDriver() {}
+      MidiDriver(SeqPlayer* s, MidiInput* in) { seq = s; input = in; inputThread = 0; }
+      virtual ~MidiDriver();
       virtual bool init() = 0;
       virtual void getInputPollFd(struct pollfd**, int* n) = 0;
       virtual void getOutputPollFd(struct pollfd**, int* n) = 0;
+      // called from the midi input thread
       virtual void read() = 0;
       virtual void write(const Event&) = 0;
       };
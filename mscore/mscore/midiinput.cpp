@@ -0,0 +1,296 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "config.h"
+#include "midiinput.h"
+#include "mididriver.h"
+#include "libmscore/event.h"
+
+#ifdef Q_OS_UNIX
+#include <time.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#endif
+
+//---------------------------------------------------------
+//   put
+//    called from the midi input thread; returns false
+//    if the fifo is full
+//---------------------------------------------------------
+
+bool MidiThruFifo::put(const MidiThruEvent& e)
+      {
+      int w = widx.fetchAndAddAcquire(0);
+      if (w - ridx.fetchAndAddAcquire(0) >= SIZE)
+            return false;
+      events[w & (SIZE - 1)] = e;
+      widx.fetchAndStoreRelease(w + 1);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   get
+//    called from the reader thread; returns false if the
+//    fifo is empty
+//---------------------------------------------------------
+
+bool MidiThruFifo::get(MidiThruEvent* e)
+      {
+      int r = ridx.fetchAndAddAcquire(0);
+      if (r == widx.fetchAndAddAcquire(0))
+            return false;
+      *e = events[r & (SIZE - 1)];
+      ridx.fetchAndStoreRelease(r + 1);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   MidiInput
+//---------------------------------------------------------
+
+MidiInput::MidiInput()
+      {
+      receiver = 0;
+      _enabled.fetchAndStoreRelaxed(1);
+      playNotes.fetchAndStoreRelaxed(0);
+      thruChannel.fetchAndStoreRelaxed(-1);
+      for (int i = 0; i < 4; ++i)
+            remoteNotes[i].fetchAndStoreRelaxed(0);
+      _midiThru = false;
+      }
+
+//---------------------------------------------------------
+//   setEnabled
+//    called from the gui thread; without midi input
+//    only note offs are played
+//---------------------------------------------------------
+
+void MidiInput::setEnabled(bool val)
+      {
+      _enabled.fetchAndStoreRelease(val);
+      }
+
+//---------------------------------------------------------
+//   setThru
+//    called from the gui thread; channel is the channel
+//    of the selected part, play is false while the gui
+//    would ignore note ons; remote is a bitmap of 128
+//    pitches mapped to midi remote actions
+//---------------------------------------------------------
+
+void MidiInput::setThru(int channel, bool play, const unsigned* remote)
+      {
+      for (int i = 0; i < 4; ++i)
+            remoteNotes[i].fetchAndStoreRelease(int(remote[i]));
+      thruChannel.fetchAndStoreRelease(channel);
+      playNotes.fetchAndStoreRelease(play);
+      }
+
+//---------------------------------------------------------
+//   remote
+//    true if note ons of pitch trigger a midi remote
+//    action
+//---------------------------------------------------------
+
+bool MidiInput::remote(int pitch)
+      {
+      if (pitch < 0 || pitch > 127)
+            return false;
+      unsigned bits = remoteNotes[pitch >> 5].fetchAndAddAcquire(0);
+      return bits & (1u << (pitch & 31));
+      }
+
+//---------------------------------------------------------
+//   event
+//    called from the midi input thread
+//---------------------------------------------------------
+
+void MidiInput::event(int type, int channel, int a, int b)
+      {
+      bool enabled = _enabled.fetchAndAddAcquire(0);
+      MidiThruEvent e;
+      e.type    = type;
+      e.channel = channel;
+      e.dataA   = a;
+      e.dataB   = b;
+      e.time    = MidiInputThread::time();
+
+      if (type == ME_NOTEON || type == ME_NOTEOFF) {
+            // a note off always passes, its note on may have
+            // been played before the gui closed the gate
+            bool off = type == ME_NOTEOFF || b == 0;
+            if (off || (enabled && playNotes.fetchAndAddAcquire(0) && !remote(a))) {
+                  MidiThruEvent te = e;
+                  te.type   = ME_NOTEON;
+                  te.dataB  = off ? 0 : b;
+                  _midiThru = true;
+                  if (!thruFifo.put(te))
+                        qDebug("MidiInput: thru fifo overflow\n");
+                  }
+            }
+      if (!enabled)
+            return;
+      if (!guiFifo.put(e)) {
+            qDebug("MidiInput: gui fifo overflow\n");
+            return;
+            }
+      if (receiver)
+            QMetaObject::invokeMethod(receiver, "midiInputReady", Qt::QueuedConnection);
+      }
+
+//---------------------------------------------------------
+//   thru
+//    called from the audio thread; returns the next note
+//    to play on the channel of the selected part
+//---------------------------------------------------------
+
+bool MidiInput::thru(MidiThruEvent* e)
+      {
+      while (thruFifo.get(e)) {
+            int channel = thruChannel.fetchAndAddAcquire(0);
+            if (channel < 0)
+                  continue;
+            e->channel = channel;
+            return true;
+            }
+      return false;
+      }
+
+//---------------------------------------------------------
+//   guiEvent
+//    called from the gui thread
+//---------------------------------------------------------
+
+bool MidiInput::guiEvent(MidiThruEvent* e)
+      {
+      return guiFifo.get(e);
+      }
+
+//---------------------------------------------------------
+//   MidiInputThread
+//---------------------------------------------------------
+
+MidiInputThread::MidiInputThread(MidiDriver* d)
+      {
+      driver   = d;
+      quitFlag = false;
+      }
+
+//---------------------------------------------------------
+//   stop
+//---------------------------------------------------------
+
+void MidiInputThread::stop()
+      {
+      if (!isRunning())
+            return;
+      quitFlag = true;
+      wait();
+      }
+
+//---------------------------------------------------------
+//   time
+//    monotonic time in nanoseconds
+//---------------------------------------------------------
+
+qint64 MidiInputThread::time()
+      {
+#ifdef Q_OS_UNIX
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#else
+      QElapsedTimer t;
+      t.start();
+      return t.msecsSinceReference() * 1000000LL;
+#endif
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void MidiInputThread::run()
+      {
+#ifdef Q_OS_UNIX
+      //
+      // try to get realtime priviledges, slightly above
+      // the alsa audio thread
+      //
+      struct sched_param rt_param;
+      memset(&rt_param, 0, sizeof(rt_param));
+      rt_param.sched_priority = 55;
+      if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &rt_param))
+            qDebug("MidiInputThread: no realtime scheduling\n");
+#endif
+      struct pollfd* pfd = 0;
+      int npfd = 0;
+      driver->getInputPollFd(&pfd, &npfd);
+
+      while (!quitFlag) {
+#ifdef Q_OS_UNIX
+            if (npfd) {
+                  // time out to look at quitFlag
+                  if (poll(pfd, npfd, 100) > 0)
+                        driver->read();
+                  continue;
+                  }
+#endif
+            driver->read();
+            msleep(1);
+            }
+      delete[] pfd;
+      }
+
+//---------------------------------------------------------
+//   MidiDriver
+//---------------------------------------------------------
+
+MidiDriver::~MidiDriver()
+      {
+      stopInput();
+      delete inputThread;
+      }
+
+//---------------------------------------------------------
+//   startInput
+//    start reading the midi input in its own thread
+//---------------------------------------------------------
+
+void MidiDriver::startInput()
+      {
+      if (inputThread == 0)
+            inputThread = new MidiInputThread(this);
+      inputThread->start(QThread::TimeCriticalPriority);
+      }
+
+//---------------------------------------------------------
+//   stopInput
+//    derived drivers call this before they close their
+//    input
+//---------------------------------------------------------
+
+void MidiDriver::stopInput()
+      {
+      if (inputThread)
+            inputThread->stop();
+      }
+
@@ -0,0 +1,113 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __MIDIINPUT_H__
+#define __MIDIINPUT_H__
+
+class MidiDriver;
+
+//---------------------------------------------------------
+//   MidiThruEvent
+//    plain data, so that the audio thread does not
+//    allocate when taking it from the fifo
+//---------------------------------------------------------
+
+struct MidiThruEvent {
+      int type;
+      int channel;
+      int dataA;
+      int dataB;
+      qint64 time;            // MidiInputThread::time() of arrival
+      };
+
+//---------------------------------------------------------
+//   MidiThruFifo
+//    lock free fifo from the midi input thread to the
+//    audio or the gui thread (one writer, one reader)
+//---------------------------------------------------------
+
+class MidiThruFifo {
+      static const int SIZE = 256;        // power of two
+
+      MidiThruEvent events[SIZE];
+      QAtomicInt widx;                    // free running indices
+      QAtomicInt ridx;
+
+   public:
+      MidiThruFifo() {}
+      bool put(const MidiThruEvent&);
+      bool get(MidiThruEvent*);
+      };
+
+//---------------------------------------------------------
+//   MidiInput
+//    events from the midi input thread. Note events are
+//    played by the audio thread without waiting for the
+//    gui, all events are passed on to the gui for note
+//    entry. The gui decides which note ons are played
+//    like MuseScore::midiNoteReceived() decides which
+//    notes it takes.
+//---------------------------------------------------------
+
+class MidiInput {
+      MidiThruFifo thruFifo;              // midi input thread -> audio thread
+      MidiThruFifo guiFifo;               // midi input thread -> gui thread
+      QObject* receiver;                  // its midiInputReady() is called for gui events
+      QAtomicInt _enabled;                // the gui takes midi input
+      QAtomicInt playNotes;               // note ons are played by midi thru
+      QAtomicInt thruChannel;             // channel played by midi thru, -1: none
+      QAtomicInt remoteNotes[4];          // pitches mapped to midi remote actions
+      volatile bool _midiThru;
+
+      bool remote(int pitch);
+
+   public:
+      MidiInput();
+      void setReceiver(QObject* o)  { receiver = o; }
+      void setEnabled(bool val);
+      void setThru(int channel, bool play, const unsigned* remote);
+      bool midiThru() const         { return _midiThru; }
+
+      void event(int type, int channel, int a, int b);
+      bool thru(MidiThruEvent*);
+      bool guiEvent(MidiThruEvent*);
+      };
+
+//---------------------------------------------------------
+//   MidiInputThread
+//    waits on the input poll fds of a midi driver and
+//    calls MidiDriver::read() when events arrive; drivers
+//    without fds are polled every millisecond
+//---------------------------------------------------------
+
+class MidiInputThread : public QThread {
+      MidiDriver* driver;
+      volatile bool quitFlag;
+
+      virtual void run();
+
+   public:
+      MidiInputThread(MidiDriver*);
+      void stop();
+      static qint64 time();
+      };
+
+#endif
+
@@ -82,6 +82,8 @@
 #include "libmscore/volta.h"
 
 #include "msynth/synti.h"
+#include "fluid/sfont.h"
+#include "renderdriver.h"
 
 //import qt bindings for plugin framework
 #if ( defined(BUILD_SCRIPTGEN) && defined(STATIC_SCRIPT_BINDINGS) )
@@ -107,6 +109,8 @@ bool converterMode = false;
 bool noGui = false;
 bool externalIcons = false;
 static bool pluginMode = false;
+static bool benchmarkMode = false;
+static bool renderMode = false;       // the sequencer plays into a RenderDriver
 static bool startWithNewScore = false;
 double converterDpi = 0;
 
@@ -1231,6 +1235,8 @@ static void usage()
         "   -I        dump midi input\n"
         "   -O        dump midi output\n"
         "   -o file   export to 'file'; format depends on file extension\n"
+        "             .raw or - (stdout): the playback as stereo float frames\n"
+        "   -b        render the playback as fast as possible, print blocks/s\n"
         "   -r dpi    set output resolution for image export\n"
         "   -S style  load style file\n"
         "   -p name   execute named plugin\n"
@@ -1539,6 +1545,21 @@ void MeasuresDialog::accept()
 void MuseScore::midiinToggled(bool val)
       {
       _midiinEnabled = val;
+      if (seq)
+            seq->updateThruChannel();
+      }
+
+//---------------------------------------------------------
+//   setMidiRecordId
+//    the next midi note or controller is assigned to the
+//    remote action id
+//---------------------------------------------------------
+
+void MuseScore::setMidiRecordId(int id)
+      {
+      _midiRecordId = id;
+      if (seq)
+            seq->updateThruChannel();
       }
 
 //---------------------------------------------------------
@@ -1903,6 +1924,44 @@ static void loadScores(const QStringList& argv)
       mscore->setCurrentView(1, currentScoreView);
       }
 
+//---------------------------------------------------------
+//   renderPlayback
+//    play the current score through the sequencer as
+//    fast as possible into outFileName ("-": stdout);
+//    with -b and no output file the frames are discarded
+//---------------------------------------------------------
+
+static bool renderPlayback()
+      {
+      RenderDriver* driver = noSeq ? 0 : static_cast<RenderDriver*>(seq->getDriver());
+      if (driver == 0 || mscore->currentScore() == 0)
+            return false;
+      QFile f;
+      RawAudioSink* sink = 0;
+      if (!outFileName.isEmpty()) {
+            bool ok;
+            if (outFileName == "-")
+                  ok = f.open(stdout, QIODevice::WriteOnly);
+            else {
+                  f.setFileName(outFileName);
+                  ok = f.open(QIODevice::WriteOnly);
+                  }
+            if (!ok) {
+                  qDebug("cannot open %s", qPrintable(outFileName));
+                  return false;
+                  }
+            sink = new RawAudioSink(&f);
+            }
+      seq->rewindStart();
+      bool ok = driver->render(sink);
+      delete sink;
+      if (benchmarkMode) {
+            fprintf(stderr, "%d blocks, %.0f blocks/s, %.1f x realtime\n",
+               driver->blocks(), driver->blocksPerSecond(), driver->realtimeFactor());
+            }
+      return ok;
+      }
+
 //---------------------------------------------------------
 //   processNonGui
 //---------------------------------------------------------
@@ -1929,6 +1988,9 @@ static bool processNonGui()
                   return res;
             }
 
+      if (renderMode)
+            return renderPlayback();
+
       if (converterMode) {
             QString fn(outFileName);
             Score* cs = mscore->currentScore();
@@ -2067,6 +2129,11 @@ int main(int argc, char* av[])
                               usage();
                         outFileName = argv.takeAt(i + 1);
                         break;
+                  case 'b':
+                        benchmarkMode = true;
+                        converterMode = true;
+                        noGui = true;
+                        break;
                   case 'p':
                         pluginMode = true;
                         noGui = true;
@@ -2111,6 +2178,7 @@ int main(int argc, char* av[])
                   }
             argv.removeAt(i);
             }
+      renderMode = benchmarkMode || outFileName == "-" || outFileName.endsWith(".raw");
       mscoreGlobalShare = getSharePath();
       iconPath = externalIcons ? mscoreGlobalShare + QString("icons/") :  QString(":/data/");
       iconGroup = "icons-dark/";
@@ -2142,6 +2210,8 @@ int main(int argc, char* av[])
       // if not already there:
       QDir dir;
       dir.mkpath(dataPath + "/plugins");
+      // decoded samples of compressed soundfonts
+      FluidS::SFont::setPcmCacheDir(dataPath + "/sf3cache");
 
       if (debugMode)
             qDebug("global share: <%s>", qPrintable(mscoreGlobalShare));
@@ -2254,7 +2324,10 @@ int main(int argc, char* av[])
       gscore = new Score(MScore::defaultStyle());
 
       if (!noSeq) {
-            if (!seq->init()) {
+            bool ok = renderMode
+               ? seq->init(new RenderDriver(seq, preferences.exportAudioSampleRate))
+               : seq->init();
+            if (!ok) {
                   qDebug("sequencer init failed");
                   noSeq = true;
                   }
@@ -500,7 +500,7 @@ class MuseScore : public QMainWindow {
       bool hasToCheckForUpdate();
       static bool unstable();
       bool eventFilter(QObject *, QEvent *);
-      void setMidiRecordId(int id) { _midiRecordId = id; }
+      void setMidiRecordId(int id);
       int midiRecordId() const { return _midiRecordId; }
       void populatePalette();
       void excerptsChanged(Score*);
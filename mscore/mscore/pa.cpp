@@ -45,8 +45,12 @@ static PaStream* stream;
 //---------------------------------------------------------
 
 int paCallback(const void*, void* out, long unsigned frames,
-   const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags, void *)
+   const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags flags, void *)
       {
+      AudioStats* stats = seq->audioStats();
+      stats->beginCycle();
+      if (flags & (paOutputUnderflow | paOutputOverflow))
+            stats->xrun();
 #ifdef INTERLEAVED_AUDIO
       float lb[frames];
       float rb[frames];
@@ -61,6 +65,7 @@ int paCallback(const void*, void* out, long unsigned frames,
       float* o2 = ((float**)out)[1];
       seq->process((unsigned)frames, o1, o2);
 #endif
+      stats->endCycle(frames, MScore::sampleRate);
       return 0;
       }
 
@@ -138,10 +143,10 @@ bool Portaudio::init()
                   }
             }
 #ifdef USE_ALSA
-      midiDriver = new AlsaMidiDriver(seq);
+      midiDriver = new AlsaMidiDriver(seq, seq->midiInput());
 #endif
 #ifdef USE_PORTMIDI
-      midiDriver = new PortMidiDriver(seq);
+      midiDriver = new PortMidiDriver(seq, seq->midiInput());
 #endif
       if (midiDriver && !midiDriver->init()) {
             qDebug("Init midi driver failed\n");
@@ -307,16 +312,6 @@ int Portaudio::getState()
       return state;
       }
 
-//---------------------------------------------------------
-//   midiRead
-//---------------------------------------------------------
-
-void Portaudio::midiRead()
-      {
-      if (midiDriver)
-            midiDriver->read();
-      }
-
 //---------------------------------------------------------
 //   currentApi
 //---------------------------------------------------------
@@ -55,7 +55,6 @@ class Portaudio : public Driver {
       virtual int sampleRate() const { return _sampleRate; }
       virtual void registerPort(const QString& name, bool input, bool midi);
       virtual void unregisterPort(int);
-      virtual void midiRead();
 
       int framePos() const;
       void connect(void*, void*);
@@ -0,0 +1,221 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "config.h"
+#include "pcmconvert.h"
+#include <math.h>
+
+//
+//    16 bit samples are scaled to +-32767, 24 and 32 bit
+//    samples to +-8388607; 32 bit samples are the 24 bit
+//    value shifted left by 8. Dither is one (rectangular)
+//    or the sum of two (triangular) uniform values of
+//    +-0.5 lsb.
+//
+static const float SCALE16     = 32767.0f;
+static const float SCALE24     = 8388607.0f;
+static const float DITHERSCALE = 1.0f / 4294967296.0f;
+
+//---------------------------------------------------------
+//   cpuHasSse2
+//---------------------------------------------------------
+
+static bool cpuHasSse2()
+      {
+#ifdef AUDIO_SIMD
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+#else
+      return false;
+#endif
+      }
+
+bool PcmConverter::_simd = cpuHasSse2();
+
+//---------------------------------------------------------
+//   xorshift
+//---------------------------------------------------------
+
+static inline quint32 xorshift(quint32* s)
+      {
+      quint32 x = *s;
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      *s = x;
+      return x;
+      }
+
+//---------------------------------------------------------
+//   sample
+//    the operations are done in the same order as in
+//    the simd kernels to get identical results
+//---------------------------------------------------------
+
+static inline int sample(float s, float scale, quint32* seed, int dither)
+      {
+      float v = s * scale;
+      if (dither != PcmConverter::DITHER_NONE) {
+            float d = float(qint32(xorshift(seed)));
+            if (dither == PcmConverter::DITHER_TRIANGULAR)
+                  d += float(qint32(xorshift(seed)));
+            v += d * DITHERSCALE;
+            }
+      v = v > -scale ? v : -scale;
+      v = v < scale ? v : scale;
+      return lrintf(v);
+      }
+
+//---------------------------------------------------------
+//   put
+//    store a sample of size bytes
+//---------------------------------------------------------
+
+static inline void put(char* dst, int v, int size)
+      {
+      switch (size) {
+            case 2:
+                  *((short*) dst) = v;
+                  break;
+            case 3:
+                  dst[0] = v;
+                  dst[1] = v >> 8;
+                  dst[2] = v >> 16;
+                  break;
+            case 4:
+                  *((int*) dst) = v << 8;
+                  break;
+            }
+      }
+
+//---------------------------------------------------------
+//   pcm_scalar
+//---------------------------------------------------------
+
+template <int size>
+static void pcm_scalar(const float* l, const float* r, char* dst, int n, quint32* seed, int dither)
+      {
+      const float scale = size == 2 ? SCALE16 : SCALE24;
+      if (r) {
+            for (int i = 0; i < n; ++i) {
+                  put(dst,        sample(l[i], scale, seed + (i & 3), dither), size);
+                  put(dst + size, sample(r[i], scale, seed + 4 + (i & 3), dither), size);
+                  dst += size * 2;
+                  }
+            }
+      else {
+            for (int i = 0; i < n; ++i) {
+                  put(dst, sample(l[i], scale, seed + (i & 3), dither), size);
+                  dst += size;
+                  }
+            }
+      }
+
+static const PcmKernel scalarKernels[] = {
+      pcm_scalar<2>, pcm_scalar<3>, pcm_scalar<4>
+      };
+
+#ifdef AUDIO_SIMD
+static const PcmKernel simdKernels[] = {
+      pcm16_sse2, pcm24_sse2, pcm32_sse2
+      };
+#endif
+
+//---------------------------------------------------------
+//   PcmConverter
+//---------------------------------------------------------
+
+PcmConverter::PcmConverter(Format f, Dither d)
+      {
+      _format = f;
+      _dither = d;
+      reset();
+      }
+
+//---------------------------------------------------------
+//   reset
+//    restart the dither generators
+//---------------------------------------------------------
+
+void PcmConverter::reset()
+      {
+      quint32 s = 0x9e3779b9;
+      for (int i = 0; i < 8; ++i) {
+            s = s * 1664525 + 1013904223;
+            seed[i] = s | 1;              // xorshift state must not be zero
+            }
+      }
+
+//---------------------------------------------------------
+//   setSimd
+//    use the simd kernels if val is set and the cpu
+//    supports them
+//---------------------------------------------------------
+
+void PcmConverter::setSimd(bool val)
+      {
+      _simd = val && cpuHasSse2();
+      }
+
+//---------------------------------------------------------
+//   convert
+//    convert n samples of channel (0 or 1) to dst;
+//    consecutive samples are step bytes apart
+//---------------------------------------------------------
+
+void PcmConverter::convert(int channel, const float* src, char* dst, int step, int n)
+      {
+      int size   = sampleSize();
+      quint32* s = seed + (channel ? 4 : 0);
+      if (step == size) {
+            int m = 0;
+#ifdef AUDIO_SIMD
+            if (_simd) {
+                  m = n & ~3;
+                  simdKernels[_format](src, 0, dst, m, s, _dither);
+                  }
+#endif
+            scalarKernels[_format](src + m, 0, dst + m * size, n - m, s, _dither);
+            return;
+            }
+      const float scale = _format == S16_LE ? SCALE16 : SCALE24;
+      for (int i = 0; i < n; ++i) {
+            put(dst, sample(src[i], scale, s + (i & 3), _dither), size);
+            dst += step;
+            }
+      }
+
+//---------------------------------------------------------
+//   interleave
+//    convert n stereo frames
+//---------------------------------------------------------
+
+void PcmConverter::interleave(const float* l, const float* r, char* dst, int n)
+      {
+      int m = 0;
+#ifdef AUDIO_SIMD
+      if (_simd) {
+            m = n & ~3;
+            simdKernels[_format](l, r, dst, m, seed, _dither);
+            }
+#endif
+      scalarKernels[_format](l + m, r + m, dst + m * sampleSize() * 2, n - m, seed, _dither);
+      }
+
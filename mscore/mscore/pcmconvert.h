@@ -0,0 +1,77 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __PCMCONVERT_H__
+#define __PCMCONVERT_H__
+
+//---------------------------------------------------------
+//   PcmKernel
+//    convert n samples of l into dst; with r set, l and
+//    r are interleaved into stereo frames. Every channel
+//    has four dither generators in seed, r uses seed + 4;
+//    sample i takes its dither from generator i % 4.
+//    The simd kernels only accept multiples of four
+//    samples and produce the same output as the scalar
+//    ones.
+//---------------------------------------------------------
+
+typedef void (*PcmKernel)(const float* l, const float* r, char* dst, int n,
+   quint32* seed, int dither);
+
+extern void pcm16_sse2(const float*, const float*, char*, int, quint32*, int);
+extern void pcm24_sse2(const float*, const float*, char*, int, quint32*, int);
+extern void pcm32_sse2(const float*, const float*, char*, int, quint32*, int);
+
+//---------------------------------------------------------
+//   PcmConverter
+//    float to little endian integer pcm with optional
+//    dither; samples are clipped to +-1.0 and rounded
+//    to the nearest integer
+//---------------------------------------------------------
+
+class PcmConverter {
+   public:
+      enum Format { S16_LE, S24_3LE, S32_LE };
+      enum Dither { DITHER_NONE, DITHER_RECTANGULAR, DITHER_TRIANGULAR };
+
+   private:
+      Format _format;
+      Dither _dither;
+      quint32 seed[8];
+
+      static bool _simd;
+
+   public:
+      PcmConverter(Format, Dither = DITHER_NONE);
+      Format format() const       { return _format; }
+      Dither dither() const       { return _dither; }
+      void setDither(Dither d)    { _dither = d;    }
+      int sampleSize() const      { return _format == S16_LE ? 2 : (_format == S24_3LE ? 3 : 4); }
+      void reset();
+
+      void convert(int channel, const float* src, char* dst, int step, int n);
+      void interleave(const float* l, const float* r, char* dst, int n);
+
+      static void setSimd(bool val);
+      static bool simd()          { return _simd; }
+      };
+
+#endif
+
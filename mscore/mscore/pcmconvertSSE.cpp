@@ -0,0 +1,161 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+//
+//    SSE2 pcm conversion kernels, compiled with -msse2 and
+//    selected at runtime by PcmConverter. Four samples of
+//    a channel are converted at once; the four dither
+//    generators of a channel are the lanes of a register.
+//    cvtps2dq rounds to nearest like lrintf() in the
+//    scalar kernels.
+//
+
+#include <emmintrin.h>
+#include "pcmconvert.h"
+
+//---------------------------------------------------------
+//   xorshift4
+//---------------------------------------------------------
+
+static inline __m128i xorshift4(__m128i* s)
+      {
+      __m128i x = *s;
+      x  = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+      x  = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+      x  = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+      *s = x;
+      return x;
+      }
+
+//---------------------------------------------------------
+//   samples4
+//    convert four samples to 32 bit integers
+//---------------------------------------------------------
+
+static inline __m128i samples4(const float* src, __m128 scale, __m128i* seed, int dither)
+      {
+      __m128 v = _mm_mul_ps(_mm_loadu_ps(src), scale);
+      if (dither != PcmConverter::DITHER_NONE) {
+            __m128 d = _mm_cvtepi32_ps(xorshift4(seed));
+            if (dither == PcmConverter::DITHER_TRIANGULAR)
+                  d = _mm_add_ps(d, _mm_cvtepi32_ps(xorshift4(seed)));
+            v = _mm_add_ps(v, _mm_mul_ps(d, _mm_set1_ps(1.0f / 4294967296.0f)));
+            }
+      v = _mm_max_ps(v, _mm_sub_ps(_mm_setzero_ps(), scale));
+      v = _mm_min_ps(v, scale);
+      return _mm_cvtps_epi32(v);
+      }
+
+//---------------------------------------------------------
+//   pcm16_sse2
+//---------------------------------------------------------
+
+void pcm16_sse2(const float* l, const float* r, char* dst, int n, quint32* seed, int dither)
+      {
+      const __m128 scale = _mm_set1_ps(32767.0f);
+      __m128i sl = _mm_loadu_si128((__m128i*)seed);
+      __m128i sr = _mm_loadu_si128((__m128i*)(seed + 4));
+      __m128i* d = (__m128i*)dst;
+
+      if (r) {
+            for (int i = 0; i < n; i += 4) {
+                  __m128i a = samples4(l + i, scale, &sl, dither);
+                  __m128i b = samples4(r + i, scale, &sr, dither);
+                  __m128i lo = _mm_unpacklo_epi32(a, b);
+                  __m128i hi = _mm_unpackhi_epi32(a, b);
+                  _mm_storeu_si128(d++, _mm_packs_epi32(lo, hi));
+                  }
+            }
+      else {
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                  __m128i a = samples4(l + i, scale, &sl, dither);
+                  __m128i b = samples4(l + i + 4, scale, &sl, dither);
+                  _mm_storeu_si128(d++, _mm_packs_epi32(a, b));
+                  }
+            if (i < n) {
+                  __m128i a = samples4(l + i, scale, &sl, dither);
+                  _mm_storel_epi64(d, _mm_packs_epi32(a, a));
+                  }
+            }
+      _mm_storeu_si128((__m128i*)seed, sl);
+      _mm_storeu_si128((__m128i*)(seed + 4), sr);
+      }
+
+//---------------------------------------------------------
+//   pcm24_sse2
+//    there is no three byte store; the converted values
+//    are written byte wise
+//---------------------------------------------------------
+
+void pcm24_sse2(const float* l, const float* r, char* dst, int n, quint32* seed, int dither)
+      {
+      const __m128 scale = _mm_set1_ps(8388607.0f);
+      __m128i sl = _mm_loadu_si128((__m128i*)seed);
+      __m128i sr = _mm_loadu_si128((__m128i*)(seed + 4));
+      int a[4] __attribute__((aligned(16)));
+      int b[4] __attribute__((aligned(16)));
+      const int frame = r ? 6 : 3;
+
+      for (int i = 0; i < n; i += 4) {
+            _mm_store_si128((__m128i*)a, samples4(l + i, scale, &sl, dither));
+            if (r)
+                  _mm_store_si128((__m128i*)b, samples4(r + i, scale, &sr, dither));
+            for (int k = 0; k < 4; ++k) {
+                  dst[0] = a[k];
+                  dst[1] = a[k] >> 8;
+                  dst[2] = a[k] >> 16;
+                  if (r) {
+                        dst[3] = b[k];
+                        dst[4] = b[k] >> 8;
+                        dst[5] = b[k] >> 16;
+                        }
+                  dst += frame;
+                  }
+            }
+      _mm_storeu_si128((__m128i*)seed, sl);
+      _mm_storeu_si128((__m128i*)(seed + 4), sr);
+      }
+
+//---------------------------------------------------------
+//   pcm32_sse2
+//---------------------------------------------------------
+
+void pcm32_sse2(const float* l, const float* r, char* dst, int n, quint32* seed, int dither)
+      {
+      const __m128 scale = _mm_set1_ps(8388607.0f);
+      __m128i sl = _mm_loadu_si128((__m128i*)seed);
+      __m128i sr = _mm_loadu_si128((__m128i*)(seed + 4));
+      __m128i* d = (__m128i*)dst;
+
+      for (int i = 0; i < n; i += 4) {
+            __m128i a = _mm_slli_epi32(samples4(l + i, scale, &sl, dither), 8);
+            if (r) {
+                  __m128i b = _mm_slli_epi32(samples4(r + i, scale, &sr, dither), 8);
+                  _mm_storeu_si128(d++, _mm_unpacklo_epi32(a, b));
+                  _mm_storeu_si128(d++, _mm_unpackhi_epi32(a, b));
+                  }
+            else
+                  _mm_storeu_si128(d++, a);
+            }
+      _mm_storeu_si128((__m128i*)seed, sl);
+      _mm_storeu_si128((__m128i*)(seed + 4), sr);
+      }
+
@@ -94,15 +94,15 @@ bool Port::operator<(const Port& p) const
 //   PortMidiDriver
 //---------------------------------------------------------
 
-PortMidiDriver::PortMidiDriver(Seq* s)
-  : MidiDriver(s)
+PortMidiDriver::PortMidiDriver(SeqPlayer* s, MidiInput* in)
+  : MidiDriver(s, in)
       {
       inputStream = 0;
-      timer = 0;
       }
 
 PortMidiDriver::~PortMidiDriver()
       {
+      stopInput();
       if (inputStream) {
             Pt_Stop();
             Pm_Close(inputStream);
@@ -148,10 +148,7 @@ bool PortMidiDriver::init()
       while (Pm_Poll(inputStream))
             Pm_Read(inputStream, buffer, 1);
 
-      timer = new QTimer();
-      timer->setInterval(20);       // 20 msec
-      timer->start();
-      timer->connect(timer, SIGNAL(timeout()), seq, SLOT(midiInputReady()));
+      startInput();
       return true;
       }
 
@@ -193,20 +190,14 @@ void PortMidiDriver::getOutputPollFd(struct pollfd**, int* n)
 
 //---------------------------------------------------------
 //   read
+//    midi input thread
 //---------------------------------------------------------
 
 void PortMidiDriver::read()
       {
-      static const int THRESHOLD = 3; // iterations required before consecutive drum notes are not considered part of a chord
-      static int active = 0;
-      static int iter = 0;
-      //for some reason, some users could have "active" blocked in < 0
-      if (active < 0)
-        active = 0;
       if (!inputStream)
             return;
       PmEvent buffer[1];
-      iter = (iter >= THRESHOLD) ? iter : (iter+1);
       while (Pm_Poll(inputStream)) {
             int n = Pm_Read(inputStream, buffer, 1);
             if (n > 0) {
@@ -216,12 +207,11 @@ void PortMidiDriver::read()
                   if (type == ME_NOTEON) {
                         int pitch = Pm_MessageData1(buffer[0].message);
                         int velo = Pm_MessageData2(buffer[0].message);
-                        mscore->midiNoteReceived(channel, pitch, velo);
+                        input->event(ME_NOTEON, channel, pitch, velo);
                         }
                   else if (type == ME_NOTEOFF) {
                         int pitch = Pm_MessageData1(buffer[0].message);
-                        int velo  = Pm_MessageData2(buffer[0].message);
-                        mscore->midiNoteReceived(channel, pitch, 0);
+                        input->event(ME_NOTEOFF, channel, pitch, 0);
                         }
                   }
             }
@@ -26,7 +26,7 @@
 
 #include "portmidi/pm_common/portmidi.h"
 
-class Seq;
+class SeqPlayer;
 
 //---------------------------------------------------------
 //   PortMidiDriver
@@ -36,10 +36,9 @@ class PortMidiDriver : public MidiDriver {
       int inputId;
       int outputId;
       PmStream* inputStream;
-      QTimer* timer;
 
    public:
-      PortMidiDriver(Seq*);
+      PortMidiDriver(SeqPlayer*, MidiInput*);
       virtual ~PortMidiDriver();
       virtual bool init();
       virtual Port registerOutPort(const QString& name);
@@ -179,6 +179,7 @@ void Preferences::init()
       playNotes          = true;
       lPort              = "";
       rPort              = "";
+      jackPartPorts      = false;
 
       showNavigator      = true;
       showPlayPanel      = false;
@@ -205,6 +206,7 @@ void Preferences::init()
       alsaSampleRate     = 48000;
       alsaPeriodSize     = 1024;
       alsaFragments      = 3;
+      alsaDither         = 0;
       portaudioDevice    = -1;
       portMidiInput      = "";
 
@@ -291,6 +293,7 @@ void Preferences::init()
 #endif
 
       exportAudioSampleRate   = exportAudioSampleRates[0];
+      exportAudioStems        = false;
 
       profile                 = "default";
 
@@ -329,6 +332,7 @@ void Preferences::write()
       s.setValue("soundFont",          MScore::soundFont);
       s.setValue("lPort",              lPort);
       s.setValue("rPort",              rPort);
+      s.setValue("jackPartPorts",      jackPartPorts);
       s.setValue("showNavigator",      showNavigator);
       s.setValue("showPlayPanel",      showPlayPanel);
       s.setValue("showWebPanel",       showWebPanel);
@@ -345,6 +349,7 @@ void Preferences::write()
       s.setValue("alsaSampleRate",     alsaSampleRate);
       s.setValue("alsaPeriodSize",     alsaPeriodSize);
       s.setValue("alsaFragments",      alsaFragments);
+      s.setValue("alsaDither",         alsaDither);
       s.setValue("portaudioDevice",    portaudioDevice);
       s.setValue("portMidiInput",   portMidiInput);
 
@@ -423,6 +428,7 @@ void Preferences::write()
       s.setValue("vraster", MScore::vRaster());
       s.setValue("nativeDialogs", nativeDialogs);
       s.setValue("exportAudioSampleRate", exportAudioSampleRate);
+      s.setValue("exportAudioStems", exportAudioStems);
 
       s.setValue("profile", profile);
 
@@ -481,6 +487,7 @@ void Preferences::read()
       playNotes               = s.value("playNotes", playNotes).toBool();
       lPort                   = s.value("lPort", lPort).toString();
       rPort                   = s.value("rPort", rPort).toString();
+      jackPartPorts           = s.value("jackPartPorts", jackPartPorts).toBool();
 
       MScore::soundFont = s.value("soundFont", MScore::soundFont).toString();
       if (MScore::soundFont == ":/data/piano1.sf2") {
@@ -501,6 +508,7 @@ void Preferences::read()
       alsaSampleRate     = s.value("alsaSampleRate", alsaSampleRate).toInt();
       alsaPeriodSize     = s.value("alsaPeriodSize", alsaPeriodSize).toInt();
       alsaFragments      = s.value("alsaFragments", alsaFragments).toInt();
+      alsaDither         = s.value("alsaDither", alsaDither).toInt();
       portaudioDevice    = s.value("portaudioDevice", portaudioDevice).toInt();
       portMidiInput      = s.value("portMidiInput", portMidiInput).toString();
       MScore::layoutBreakColor   = s.value("layoutBreakColor", MScore::layoutBreakColor).value<QColor>();
@@ -603,6 +611,7 @@ void Preferences::read()
 
       nativeDialogs    = s.value("nativeDialogs", nativeDialogs).toBool();
       exportAudioSampleRate = s.value("exportAudioSampleRate", exportAudioSampleRate).toInt();
+      exportAudioStems      = s.value("exportAudioStems", exportAudioStems).toBool();
 
       profile          = s.value("profile", profile).toString();
 
@@ -899,6 +908,7 @@ void PreferenceDialog::updateValues(Preferences* p)
             jackRPort->setEnabled(false);
             jackLPort->setEnabled(false);
             }
+      jackPartPorts->setChecked(p->jackPartPorts);
 
       soundFont->setText(MScore::soundFont);
       navigatorShow->setChecked(p->showNavigator);
@@ -918,6 +928,7 @@ void PreferenceDialog::updateValues(Preferences* p)
       alsaPeriodSize->setCurrentIndex(index);
 
       alsaFragments->setValue(p->alsaFragments);
+      alsaDither->setCurrentIndex(p->alsaDither);
       drawAntialiased->setChecked(p->antialiasedDrawing);
       switch(p->sessionStart) {
             case EMPTY_SESSION:  emptySession->setChecked(true); break;
@@ -1098,6 +1109,7 @@ void PreferenceDialog::updateValues(Preferences* p)
       if (idx == n)     // if not found in table
             idx = 0;
       exportAudioSampleRate->setCurrentIndex(idx);
+      exportAudioStems->setChecked(p->exportAudioStems);
 
       p->updatePluginList();
       pluginTable->setRowCount(p->pluginList.size());
@@ -1411,20 +1423,24 @@ void PreferenceDialog::apply()
          || (preferences.useJackAudio != jackDriver->isChecked())
          || (preferences.usePortaudioAudio != portaudioDriver->isChecked())
          || (preferences.useJackMidi != useJackMidi->isChecked())
+         || (preferences.jackPartPorts != jackPartPorts->isChecked())
          || (preferences.alsaDevice != alsaDevice->text())
          || (preferences.alsaSampleRate != alsaSampleRate->currentText().toInt())
          || (preferences.alsaPeriodSize != alsaPeriodSize->currentText().toInt())
          || (preferences.alsaFragments != alsaFragments->value())
+         || (preferences.alsaDither != alsaDither->currentIndex())
             ) {
             seq->exit();
             preferences.useAlsaAudio       = alsaDriver->isChecked();
             preferences.useJackAudio       = jackDriver->isChecked();
             preferences.usePortaudioAudio  = portaudioDriver->isChecked();
             preferences.useJackMidi        = useJackMidi->isChecked();
+            preferences.jackPartPorts      = jackPartPorts->isChecked();
             preferences.alsaDevice         = alsaDevice->text();
             preferences.alsaSampleRate     = alsaSampleRate->currentText().toInt();
             preferences.alsaPeriodSize     = alsaPeriodSize->currentText().toInt();
             preferences.alsaFragments      = alsaFragments->value();
+            preferences.alsaDither         = alsaDither->currentIndex();
             if (!seq->init()) {
                   qDebug("sequencer init failed\n");
                   }
@@ -1459,6 +1475,7 @@ void PreferenceDialog::apply()
       preferences.nativeDialogs      = nativeDialogs->isChecked();
       int idx = exportAudioSampleRate->currentIndex();
       preferences.exportAudioSampleRate = exportAudioSampleRates[idx];
+      preferences.exportAudioStems   = exportAudioStems->isChecked();
 
       preferences.showSplashScreen   = showSplashScreen->isChecked();
       preferences.midiExpandRepeats  = expandRepeats->isChecked();
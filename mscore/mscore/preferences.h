@@ -84,6 +84,7 @@ struct Preferences {
       bool playNotes;         // play notes on click
       QString lPort;          // audio port left
       QString rPort;          // audio port right
+      bool jackPartPorts;     // jack output ports for every part
       bool showNavigator;
       bool showPlayPanel;
       bool showWebPanel;
@@ -101,6 +102,7 @@ struct Preferences {
       int alsaSampleRate;
       int alsaPeriodSize;
       int alsaFragments;
+      int alsaDither;               // PcmConverter::Dither
       int portaudioDevice;
       QString portMidiInput;
 
@@ -167,6 +169,7 @@ struct Preferences {
       bool nativeDialogs;
 
       int exportAudioSampleRate;
+      bool exportAudioStems;        // also write every part into its own file
 
       QString profile;
 
@@ -0,0 +1,278 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "renderdriver.h"
+#include "seqplayer.h"
+#include "msynth/synti.h"
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+bool RawAudioSink::write(const float* frames, int n)
+      {
+      qint64 size = qint64(n) * 2 * sizeof(float);
+      return device->write((const char*)frames, size) == size;
+      }
+
+//---------------------------------------------------------
+//   close
+//---------------------------------------------------------
+
+bool RawAudioSink::close()
+      {
+      bool ok = true;
+      QFile* f = qobject_cast<QFile*>(device);
+      if (f)
+            ok = f->flush();
+      device->close();
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   RenderThread
+//---------------------------------------------------------
+
+class RenderThread : public QThread {
+      RenderDriver* driver;
+      virtual void run()      { driver->renderLoop(); }
+
+   public:
+      RenderThread(RenderDriver* d) : driver(d) {}
+      };
+
+//---------------------------------------------------------
+//   RenderDriver
+//---------------------------------------------------------
+
+RenderDriver::RenderDriver(SeqPlayer* s, int sr, int bs)
+   : Driver(s)
+      {
+      thread      = 0;
+      encoder     = 0;
+      _sampleRate = sr;
+      blockSize   = qBound(1, bs, int(EncoderThread::FRAMES));
+      running     = false;
+      state       = SeqPlayer::TRANSPORT_STOP;
+      resetCounters();
+      }
+
+RenderDriver::~RenderDriver()
+      {
+      stop();
+      }
+
+//---------------------------------------------------------
+//   start
+//    the synthesizer waits for samples which are not
+//    loaded yet instead of skipping the notes
+//---------------------------------------------------------
+
+bool RenderDriver::start()
+      {
+      synti->setOffline(true);
+      running = true;
+      thread  = new RenderThread(this);
+      thread->start();
+      return true;
+      }
+
+//---------------------------------------------------------
+//   stop
+//---------------------------------------------------------
+
+bool RenderDriver::stop()
+      {
+      if (thread) {
+            mutex.lock();
+            running = false;
+            wake.wakeAll();
+            mutex.unlock();
+            thread->wait();
+            delete thread;
+            thread = 0;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   startTransport
+//    called from the gui thread
+//---------------------------------------------------------
+
+void RenderDriver::startTransport()
+      {
+      mutex.lock();
+      state = SeqPlayer::TRANSPORT_PLAY;
+      wake.wakeAll();
+      mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   stopTransport
+//    called from the gui thread or from SeqPlayer::process()
+//    at the end of the score; the render thread is
+//    busy and does not need to be woken up
+//---------------------------------------------------------
+
+void RenderDriver::stopTransport()
+      {
+      state = SeqPlayer::TRANSPORT_STOP;
+      }
+
+//---------------------------------------------------------
+//   getState
+//---------------------------------------------------------
+
+int RenderDriver::getState()
+      {
+      return state.fetchAndAddRelaxed(0);
+      }
+
+//---------------------------------------------------------
+//   writeBlock
+//    interleave n frames into the queue of the encoder
+//---------------------------------------------------------
+
+void RenderDriver::writeBlock(const float* l, const float* r, int n)
+      {
+      if (encoder == 0)
+            return;
+      float* dp = encoder->block();
+      for (int i = 0; i < n; ++i) {
+            *dp++ = l[i];
+            *dp++ = r[i];
+            }
+      encoder->push(n);
+      }
+
+//---------------------------------------------------------
+//   renderLoop
+//    only the time spent in SeqPlayer::process() counts as
+//    load and render time, not the wait for the encoder
+//---------------------------------------------------------
+
+void RenderDriver::renderLoop()
+      {
+      float lbuffer[EncoderThread::FRAMES];
+      float rbuffer[EncoderThread::FRAMES];
+      AudioStats* stats = seq->audioStats();
+      QElapsedTimer clock;
+      clock.start();
+      int tail = 0;
+
+      while (running) {
+            bool playing = getState() == SeqPlayer::TRANSPORT_PLAY;
+            if (!playing && tail == 0) {
+                  //
+                  // idle; the message fifo must not run full
+                  //
+                  mutex.lock();
+                  if (running && getState() == SeqPlayer::TRANSPORT_STOP)
+                        wake.wait(&mutex, 10);
+                  mutex.unlock();
+                  if (getState() == SeqPlayer::TRANSPORT_STOP)
+                        seq->processMessages();
+                  continue;
+                  }
+            int n = blockSize;
+            if (playing)
+                  tail = TAIL * _sampleRate;
+            else {
+                  n = qMin(n, tail);
+                  tail -= n;
+                  }
+            qint64 t = clock.nsecsElapsed();
+            stats->beginCycle();
+            seq->process(n, lbuffer, rbuffer);
+            stats->endCycle(n, _sampleRate);
+            renderTime += clock.nsecsElapsed() - t;
+            ++_blocks;
+            _frames += n;
+            writeBlock(lbuffer, rbuffer, n);
+            if (!playing && tail == 0)
+                  finished.release();
+            }
+      }
+
+//---------------------------------------------------------
+//   render
+//    play the score of the sequencer from its play
+//    position to the end into encoder e, which is closed
+//    afterwards; with e == 0 the frames are discarded.
+//    Called from the gui thread, returns after the
+//    release tail was rendered.
+//---------------------------------------------------------
+
+bool RenderDriver::render(AudioEncoder* e)
+      {
+      if (!seq->canStart())
+            return false;
+      if (e) {
+            encoder = new EncoderThread(e);
+            encoder->start();
+            }
+      resetCounters();
+      finished.tryAcquire(finished.available());
+      seq->start();
+      waitFinished();
+
+      bool ok = true;
+      if (encoder) {
+            encoder->block();
+            encoder->push(0);
+            encoder->wait();
+            ok = encoder->ok();
+            delete encoder;
+            encoder = 0;
+            }
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   resetCounters
+//---------------------------------------------------------
+
+void RenderDriver::resetCounters()
+      {
+      _blocks    = 0;
+      _frames    = 0;
+      renderTime = 0;
+      }
+
+//---------------------------------------------------------
+//   blocksPerSecond
+//---------------------------------------------------------
+
+double RenderDriver::blocksPerSecond() const
+      {
+      return renderTime ? _blocks * 1e9 / renderTime : 0.0;
+      }
+
+//---------------------------------------------------------
+//   realtimeFactor
+//    seconds of audio rendered per second
+//---------------------------------------------------------
+
+double RenderDriver::realtimeFactor() const
+      {
+      return renderTime ? (double(_frames) / _sampleRate) / (renderTime * 1e-9) : 0.0;
+      }
+
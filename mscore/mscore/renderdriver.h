@@ -0,0 +1,102 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __RENDERDRIVER_H__
+#define __RENDERDRIVER_H__
+
+#include "driver.h"
+#include "audiorender.h"
+
+class RenderThread;
+
+//---------------------------------------------------------
+//   RawAudioSink
+//    writes interleaved stereo float frames to a file,
+//    a pipe or a QBuffer
+//---------------------------------------------------------
+
+class RawAudioSink : public AudioEncoder {
+      QIODevice* device;
+
+   public:
+      RawAudioSink(QIODevice* d) : device(d) {}
+      virtual bool write(const float* frames, int n);
+      virtual bool close();
+      };
+
+//---------------------------------------------------------
+//   RenderDriver
+//    audio driver without a device: a thread calls
+//    SeqPlayer::process() as fast as possible while the
+//    transport plays, followed by a release tail, and
+//    feeds the frames to an encoder thread. While the
+//    transport is stopped nothing is rendered, only the
+//    messages to the sequencer are processed.
+//    The counters are written by the render thread and
+//    valid after waitFinished().
+//---------------------------------------------------------
+
+class RenderDriver : public Driver {
+      static const int TAIL = 1;    // seconds rendered after the transport stops
+
+      RenderThread* thread;
+      EncoderThread* encoder;       // 0: frames are discarded
+      int _sampleRate;
+      int blockSize;
+      volatile bool running;
+      QAtomicInt state;
+      QMutex mutex;
+      QWaitCondition wake;          // the idle render thread waits here
+      QSemaphore finished;          // a playback and its tail were rendered
+
+      int _blocks;
+      qint64 _frames;
+      qint64 renderTime;            // nsec spent in SeqPlayer::process()
+
+      void writeBlock(const float* l, const float* r, int n);
+
+   public:
+      RenderDriver(SeqPlayer*, int sampleRate = 44100, int blockSize = 256);
+      virtual ~RenderDriver();
+      virtual bool init()                     { return true; }
+      virtual bool start();
+      virtual bool stop();
+      virtual QList<QString> inputPorts()     { return QList<QString>(); }
+      virtual void startTransport();
+      virtual void stopTransport();
+      virtual int getState();
+      virtual int sampleRate() const          { return _sampleRate; }
+      virtual void registerPort(const QString&, bool, bool) {}
+      virtual void unregisterPort(int)        {}
+
+      void renderLoop();
+      bool render(AudioEncoder*);
+      void waitFinished()                     { finished.acquire(); }
+
+      int blocks() const                      { return _blocks; }
+      qint64 frames() const                   { return _frames; }
+      qint64 renderNsec() const               { return renderTime; }
+      double blocksPerSecond() const;
+      double realtimeFactor() const;
+      void resetCounters();
+      };
+
+#endif
+
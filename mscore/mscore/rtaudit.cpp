@@ -0,0 +1,411 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "config.h"
+#include "rtaudit.h"
+
+#ifdef RT_AUDIT
+
+//
+//    The functions below replace the libc functions of
+//    the same name for the whole program; they must be
+//    linked into the executable. The allocator is reached
+//    through the __libc_* entry points, everything else
+//    through dlsym(RTLD_NEXT). The QMutex and QSemaphore
+//    members are replaced the same way.
+//
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+extern "C" {
+      void* __libc_malloc(size_t);
+      void* __libc_calloc(size_t, size_t);
+      void* __libc_realloc(void*, size_t);
+      void __libc_free(void*);
+      }
+
+static const int MAX_FRAMES = 32;
+static const int MAX_TRACES = 512;        // distinct stacks reported
+
+static __thread int depth;                // audit scopes of this thread
+static __thread int inside;               // in a report, don't audit
+
+static QAtomicInt _violations;
+static QAtomicInt traces[MAX_TRACES];     // hashes of the reported stacks
+
+//---------------------------------------------------------
+//   Init
+//    backtrace() loads libgcc on its first call; this
+//    must not happen in the audio thread
+//---------------------------------------------------------
+
+static struct Init {
+      Init() {
+            void* frames[2];
+            backtrace(frames, 2);
+            }
+      } init;
+
+//---------------------------------------------------------
+//   newTrace
+//    returns true if the stack with hash h was not
+//    reported before
+//---------------------------------------------------------
+
+static bool newTrace(int h)
+      {
+      if (h == 0)
+            h = 1;
+      for (int i = 0; i < MAX_TRACES; ++i) {
+            QAtomicInt* t = &traces[(h + i) & (MAX_TRACES - 1)];
+            if (t->testAndSetRelaxed(0, h))
+                  return true;
+            if (t->fetchAndAddRelaxed(0) == h)
+                  return false;
+            }
+      return false;                       // table full, stop reporting
+      }
+
+//---------------------------------------------------------
+//   violation
+//---------------------------------------------------------
+
+static void violation(const char* call)
+      {
+      ++inside;
+      _violations.fetchAndAddRelaxed(1);
+      void* frames[MAX_FRAMES];
+      int n = backtrace(frames, MAX_FRAMES);
+      unsigned h = 2166136261u;
+      for (int i = 2; i < n; ++i)
+            h = (h ^ unsigned(quintptr(frames[i]))) * 16777619u;
+      if (newTrace(int(h))) {
+            char buffer[128];
+            int len = snprintf(buffer, sizeof(buffer), "RT_AUDIT: %s in the audio thread\n", call);
+            if (write(2, buffer, len) == len)
+                  backtrace_symbols_fd(frames + 2, n - 2, 2);
+            }
+      --inside;
+      }
+
+//---------------------------------------------------------
+//   audit
+//---------------------------------------------------------
+
+static inline void audit(const char* call)
+      {
+      if (depth > 0 && inside == 0)
+            violation(call);
+      }
+
+//---------------------------------------------------------
+//   next
+//    the function replaced by the one calling next()
+//---------------------------------------------------------
+
+template <typename F> static inline F next(F* fp, const char* name, const char* version = 0)
+      {
+      if (*fp == 0) {
+            ++inside;
+            void* p = version ? dlvsym(RTLD_NEXT, name, version) : 0;
+            if (p == 0)
+                  p = dlsym(RTLD_NEXT, name);
+            *fp = reinterpret_cast<F>(p);
+            --inside;
+            }
+      return *fp;
+      }
+
+//---------------------------------------------------------
+//   RtAudit
+//---------------------------------------------------------
+
+void RtAudit::enter()
+      {
+      ++depth;
+      }
+
+void RtAudit::leave()
+      {
+      --depth;
+      }
+
+int RtAudit::violations()
+      {
+      return _violations.fetchAndAddRelaxed(0);
+      }
+
+void RtAudit::reset()
+      {
+      _violations.fetchAndStoreRelaxed(0);
+      for (int i = 0; i < MAX_TRACES; ++i)
+            traces[i].fetchAndStoreRelaxed(0);
+      }
+
+//---------------------------------------------------------
+//   memory
+//---------------------------------------------------------
+
+extern "C" void* malloc(size_t size) __THROW
+      {
+      audit("malloc");
+      return __libc_malloc(size);
+      }
+
+extern "C" void* calloc(size_t n, size_t size) __THROW
+      {
+      audit("calloc");
+      return __libc_calloc(n, size);
+      }
+
+extern "C" void* realloc(void* p, size_t size) __THROW
+      {
+      audit("realloc");
+      return __libc_realloc(p, size);
+      }
+
+extern "C" void free(void* p) __THROW
+      {
+      if (p)
+            audit("free");
+      __libc_free(p);
+      }
+
+extern "C" int posix_memalign(void** p, size_t align, size_t size) __THROW
+      {
+      static int (*fp)(void**, size_t, size_t);
+      audit("posix_memalign");
+      return next(&fp, "posix_memalign")(p, align, size);
+      }
+
+//---------------------------------------------------------
+//   locks
+//---------------------------------------------------------
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* m) __THROWNL
+      {
+      static int (*fp)(pthread_mutex_t*);
+      audit("pthread_mutex_lock");
+      return next(&fp, "pthread_mutex_lock")(m);
+      }
+
+extern "C" int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m)
+      {
+      static int (*fp)(pthread_cond_t*, pthread_mutex_t*);
+      audit("pthread_cond_wait");
+      return next(&fp, "pthread_cond_wait", "GLIBC_2.3.2")(c, m);
+      }
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t)
+      {
+      static int (*fp)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+      audit("pthread_cond_timedwait");
+      return next(&fp, "pthread_cond_timedwait", "GLIBC_2.3.2")(c, m, t);
+      }
+
+extern "C" int sem_wait(sem_t* s)
+      {
+      static int (*fp)(sem_t*);
+      audit("sem_wait");
+      return next(&fp, "sem_wait")(s);
+      }
+
+extern "C" int sem_timedwait(sem_t* s, const struct timespec* t)
+      {
+      static int (*fp)(sem_t*, const struct timespec*);
+      audit("sem_timedwait");
+      return next(&fp, "sem_timedwait")(s, t);
+      }
+
+//---------------------------------------------------------
+//   Qt locks
+//    the members of QMutex and QSemaphore defined here
+//    replace the ones of QtCore for the code linked into
+//    the executable; the originals are found through
+//    their mangled names. The inline lock of QMutexLocker
+//    does not call QMutex::lock() and is seen only when
+//    it is contended.
+//---------------------------------------------------------
+
+void QMutex::lock()
+      {
+      static void (*fp)(QMutex*);
+      audit("QMutex::lock");
+      next(&fp, "_ZN6QMutex4lockEv")(this);
+      }
+
+bool QMutex::tryLock()
+      {
+      static bool (*fp)(QMutex*);
+      audit("QMutex::tryLock");
+      return next(&fp, "_ZN6QMutex7tryLockEv")(this);
+      }
+
+bool QMutex::tryLock(int timeout)
+      {
+      static bool (*fp)(QMutex*, int);
+      audit("QMutex::tryLock");
+      return next(&fp, "_ZN6QMutex7tryLockEi")(this, timeout);
+      }
+
+void QSemaphore::acquire(int n)
+      {
+      static void (*fp)(QSemaphore*, int);
+      audit("QSemaphore::acquire");
+      next(&fp, "_ZN10QSemaphore7acquireEi")(this, n);
+      }
+
+bool QSemaphore::tryAcquire(int n)
+      {
+      static bool (*fp)(QSemaphore*, int);
+      audit("QSemaphore::tryAcquire");
+      return next(&fp, "_ZN10QSemaphore10tryAcquireEi")(this, n);
+      }
+
+bool QSemaphore::tryAcquire(int n, int timeout)
+      {
+      static bool (*fp)(QSemaphore*, int, int);
+      audit("QSemaphore::tryAcquire");
+      return next(&fp, "_ZN10QSemaphore10tryAcquireEii")(this, n, timeout);
+      }
+
+void QSemaphore::release(int n)
+      {
+      static void (*fp)(QSemaphore*, int);
+      audit("QSemaphore::release");
+      next(&fp, "_ZN10QSemaphore7releaseEi")(this, n);
+      }
+
+//---------------------------------------------------------
+//   syscall
+//    a contended QMutex waits in the futex system call;
+//    the arguments are passed on as they are
+//---------------------------------------------------------
+
+extern "C" long syscall(long number, ...) __THROW
+      {
+      static long (*fp)(long, ...);
+      va_list ap;
+      va_start(ap, number);
+      long a[6];
+      for (int i = 0; i < 6; ++i)
+            a[i] = va_arg(ap, long);
+      va_end(ap);
+      if (number == SYS_futex) {
+            int op = a[1] & FUTEX_CMD_MASK;
+            if (op == FUTEX_WAIT || op == FUTEX_WAIT_BITSET || op == FUTEX_LOCK_PI)
+                  audit("futex wait");
+            }
+      return next(&fp, "syscall")(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+      }
+
+//---------------------------------------------------------
+//   file i/o and sleeping
+//---------------------------------------------------------
+
+extern "C" int open(const char* path, int flags, ...)
+      {
+      static int (*fp)(const char*, int, ...);
+      va_list ap;
+      va_start(ap, flags);
+      int mode = va_arg(ap, int);
+      va_end(ap);
+      audit("open");
+      return next(&fp, "open")(path, flags, mode);
+      }
+
+extern "C" int open64(const char* path, int flags, ...)
+      {
+      static int (*fp)(const char*, int, ...);
+      va_list ap;
+      va_start(ap, flags);
+      int mode = va_arg(ap, int);
+      va_end(ap);
+      audit("open");
+      return next(&fp, "open64")(path, flags, mode);
+      }
+
+extern "C" ssize_t read(int fd, void* buffer, size_t n)
+      {
+      static ssize_t (*fp)(int, void*, size_t);
+      audit("read");
+      return next(&fp, "read")(fd, buffer, n);
+      }
+
+extern "C" ssize_t write(int fd, const void* buffer, size_t n)
+      {
+      static ssize_t (*fp)(int, const void*, size_t);
+      audit("write");
+      return next(&fp, "write")(fd, buffer, n);
+      }
+
+extern "C" FILE* fopen(const char* path, const char* mode)
+      {
+      static FILE* (*fp)(const char*, const char*);
+      audit("fopen");
+      return next(&fp, "fopen")(path, mode);
+      }
+
+extern "C" size_t fwrite(const void* buffer, size_t size, size_t n, FILE* f)
+      {
+      static size_t (*fp)(const void*, size_t, size_t, FILE*);
+      audit("fwrite");
+      return next(&fp, "fwrite")(buffer, size, n, f);
+      }
+
+extern "C" int fflush(FILE* f)
+      {
+      static int (*fp)(FILE*);
+      audit("fflush");
+      return next(&fp, "fflush")(f);
+      }
+
+extern "C" int poll(struct pollfd* fds, nfds_t n, int timeout)
+      {
+      static int (*fp)(struct pollfd*, nfds_t, int);
+      if (timeout != 0)
+            audit("poll");
+      return next(&fp, "poll")(fds, n, timeout);
+      }
+
+extern "C" int nanosleep(const struct timespec* req, struct timespec* rem)
+      {
+      static int (*fp)(const struct timespec*, struct timespec*);
+      audit("nanosleep");
+      return next(&fp, "nanosleep")(req, rem);
+      }
+
+extern "C" int usleep(useconds_t usec)
+      {
+      static int (*fp)(useconds_t);
+      audit("usleep");
+      return next(&fp, "usleep")(usec);
+      }
+
+#endif
+
@@ -0,0 +1,65 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __RTAUDIT_H__
+#define __RTAUDIT_H__
+
+#include "config.h"
+
+//---------------------------------------------------------
+//   RtAudit
+//    Debug aid, built with cmake -DRT_AUDIT=ON (Linux
+//    only). While a thread is between enter() and leave()
+//    the memory allocator, mutex and semaphore waits,
+//    QMutex and QSemaphore calls, futex waits and blocking
+//    file or sleep calls are intercepted; every call is
+//    counted and reported on stderr with a stack trace,
+//    once per distinct stack. An uncontended QMutexLocker
+//    locks inline and is not seen; threads started by the
+//    audio thread (render workers) are not audited.
+//    Without RT_AUDIT all functions are empty.
+//---------------------------------------------------------
+
+class RtAudit {
+   public:
+#ifdef RT_AUDIT
+      static void enter();
+      static void leave();
+      static int violations();
+      static void reset();
+#else
+      static void enter()     {}
+      static void leave()     {}
+      static int violations() { return 0; }
+      static void reset()     {}
+#endif
+      };
+
+//---------------------------------------------------------
+//   RtAuditScope
+//---------------------------------------------------------
+
+struct RtAuditScope {
+      RtAuditScope()  { RtAudit::enter(); }
+      ~RtAuditScope() { RtAudit::leave(); }
+      };
+
+#endif
+
@@ -57,10 +57,8 @@
 #endif
 
 #include "fluid.h"
-#include "click.h"
 
 Seq* seq;
-MasterSynth* synti;
 
 static const int guiRefresh   = 10;       // Hz
 static const int peakHoldTime = 1400;     // msec
@@ -72,25 +70,8 @@ static const int peakHold     = (peakHoldTime * guiRefresh) / 1000;
 
 Seq::Seq()
       {
-      running         = false;
-      playlistChanged = false;
-      cs              = 0;
-      cv              = 0;
-
-      endTick  = 0;
-      state    = TRANSPORT_STOP;
-      driver   = 0;
-      playPos  = events.constBegin();
-
-      playTime  = 0;
-      metronomeVolume = 0.3;
-
-      meterValue[0]     = 0.0;
-      meterValue[1]     = 0.0;
-      meterPeakValue[0] = 0.0;
-      meterPeakValue[1] = 0.0;
-      peakTimer[0]       = 0;
-      peakTimer[1]       = 0;
+      cv = 0;
+      _midiInput.setReceiver(this);
 
       heartBeatTimer = new QTimer(this);
       connect(heartBeatTimer, SIGNAL(timeout()), this, SLOT(heartBeat()));
@@ -99,8 +80,6 @@ Seq::Seq()
       noteTimer->setSingleShot(true);
       connect(noteTimer, SIGNAL(timeout()), this, SLOT(stopNotes()));
       noteTimer->stop();
-
-      connect(this, SIGNAL(toGui(int)), this, SLOT(seqMessage(int)), Qt::QueuedConnection);
       }
 
 //---------------------------------------------------------
@@ -141,20 +120,14 @@ void Seq::setScoreView(ScoreView* v)
             stopWait();
             }
       cv = v;
-      cs = cv ? cv->score() : 0;
 
       if (!heartBeatTimer->isActive())
             heartBeatTimer->start(1000/guiRefresh);
 
-      playlistChanged = true;
-      synti->reset();
-      if (cs) {
-            synti->setState(cs->syntiState());
-            initInstruments();
+      setScore(cv ? cv->score() : 0);
+      if (cs)
             seek(cs->playPos());
-            }
-      tackRest = 0;
-      tickRest = 0;
+      updateThruChannel();
       }
 
 //---------------------------------------------------------
@@ -165,6 +138,7 @@ void Seq::selectionChanged(int mode)
       {
       if (cs == 0 || driver == 0)
             return;
+      updateThruChannel();
 
       int tick = cs->pos();
       if (tick == -1)
@@ -248,15 +222,7 @@ bool Seq::init()
             qDebug("init audio driver failed\n");
             return false;
             }
-      MScore::sampleRate = driver->sampleRate();
-      synti->init(MScore::sampleRate);
-
-      if (!driver->start()) {
-            qDebug("Cannot start I/O\n");
-            return false;
-            }
-      running = true;
-      return true;
+      return init(driver);
       }
 
 //---------------------------------------------------------
@@ -295,20 +261,6 @@ void Seq::rewindStart()
       seek(0);
       }
 
-//---------------------------------------------------------
-//   canStart
-//    return true if sequencer can be started
-//---------------------------------------------------------
-
-bool Seq::canStart()
-      {
-      if (!driver)
-            return false;
-      if (events.empty() || cs->playlistDirty() || playlistChanged)
-            collectEvents();
-      return (!events.empty() && endTick != 0);
-      }
-
 //---------------------------------------------------------
 //   start
 //    called from gui thread
@@ -319,6 +271,8 @@ void Seq::start()
       if (events.empty() || cs->playlistDirty() || playlistChanged)
             collectEvents();
       seek(cs->playPos());
+      _metronome = mscore->metronome();
+      atEnd      = false;
       driver->startTransport();
       }
 
@@ -396,7 +350,8 @@ void Seq::guiStop()
 
 //---------------------------------------------------------
 //   seqSignal
-//    sequencer message to GUI
+//    sequencer message to GUI, from the transport flags
+//    of the audio thread
 //    execution environment: gui thread
 //---------------------------------------------------------
 
@@ -405,6 +360,10 @@ void Seq::seqMessage(int msg)
       switch(msg) {
             case '0':         // STOP
                   guiStop();
+                  if (atEnd) {
+                        atEnd = false;
+                        rewindStart();
+                        }
 //                  heartBeatTimer->stop();
                   if (driver && mscore->getSynthControl()) {
                         meterValue[0]     = .0f;
@@ -428,266 +387,16 @@ void Seq::seqMessage(int msg)
             }
       }
 
-//---------------------------------------------------------
-//   stopTransport
-//    JACK has stopped
-//    executed in realtime environment
-//---------------------------------------------------------
-
-void Seq::stopTransport()
-      {
-      state = TRANSPORT_STOP;
-      if (cs == 0)
-            return;
-      stopNotes();
-      // send sustain off
-      Event e;
-      e.setType(ME_CONTROLLER);
-      e.setController(CTRL_SUSTAIN);
-      e.setValue(0);
-      putEvent(e);
-      emit toGui('0');
-      }
-
-//---------------------------------------------------------
-//   startTransport
-//    JACK has started
-//    executed in realtime environment
-//---------------------------------------------------------
-
-void Seq::startTransport()
-      {
-      emit toGui('1');
-      state = TRANSPORT_PLAY;
-      }
-
-//---------------------------------------------------------
-//   playEvent
-//    send one event to the synthesizer
-//---------------------------------------------------------
-
-void Seq::playEvent(const Event& event)
-      {
-      int type = event.type();
-      if (type == ME_NOTEON) {
-            bool mute;
-            const Note* note = event.note();
-
-            if (note) {
-                  Instrument* instr = note->staff()->part()->instr();
-                  const Channel& a = instr->channel(note->subchannel());
-                  mute = a.mute || a.soloMute;
-                  }
-            else
-                  mute = false;
-
-            if (!mute)
-                  putEvent(event);
-            }
-      else if (type == ME_CONTROLLER)
-            putEvent(event);
-      }
-
-//---------------------------------------------------------
-//   processMessages
-//---------------------------------------------------------
-
-void Seq::processMessages()
-      {
-      for (;;) {
-            if (toSeq.isEmpty())
-                  break;
-            SeqMsg msg = toSeq.dequeue();
-            switch(msg.id) {
-                  case SEQ_TEMPO_CHANGE:
-                        {
-                        if (playTime != 0) {
-                              int tick = cs->utime2utick(qreal(playTime) / qreal(MScore::sampleRate));
-                              cs->tempomap()->setRelTempo(msg.data.realVal);
-                              cs->repeatList()->update();
-                              playTime = cs->utick2utime(tick) * MScore::sampleRate;
-                              }
-                        else
-                              cs->tempomap()->setRelTempo(msg.data.realVal);
-                        }
-                        break;
-                  case SEQ_PLAY:
-                        putEvent(msg.event);
-                        break;
-                  case SEQ_SEEK:
-                        setPos(msg.data.intVal);
-                        break;
-                  }
-            }
-      }
-
-//---------------------------------------------------------
-//   metronome
-//---------------------------------------------------------
-
-void Seq::metronome(unsigned n, float* l, float* r)
-      {
-      if (!mscore->metronome()) {
-            tickRest = 0;
-            tackRest = 0;
-            return;
-            }
-      if (tickRest) {
-            int idx = tickLength - tickRest;
-            int nn = n < tickRest ? n : tickRest;
-            for (int i = 0; i < nn; ++i) {
-                  l[i] += tick[idx] * metronomeVolume;
-                  r[i] += tick[idx] * metronomeVolume;
-                  ++idx;
-                  }
-            tickRest -= nn;
-            }
-      if (tackRest) {
-            int idx = tackLength - tackRest;
-            int nn = n < tackRest ? n : tackRest;
-            for (int i = 0; i < nn; ++i) {
-                  l[i] += tack[idx] * metronomeVolume;
-                  r[i] += tack[idx] * metronomeVolume;
-                  ++idx;
-                  }
-            tackRest -= nn;
-            }
-      }
-
-//---------------------------------------------------------
-//   process
-//---------------------------------------------------------
-
-void Seq::process(unsigned n, float* lbuffer, float* rbuffer)
-      {
-      unsigned frames = n;
-      int driverState = driver->getState();
-
-      if (driverState != state) {
-            if (state == TRANSPORT_STOP && driverState == TRANSPORT_PLAY)
-                  startTransport();
-            else if (state == TRANSPORT_PLAY && driverState == TRANSPORT_STOP)
-                  stopTransport();
-            else if (state != driverState)
-                  qDebug("Seq: state transition %d -> %d ?\n",
-                     state, driverState);
-            }
-
-      float* l = lbuffer;
-      float* r = rbuffer;
-      memset(l, 0, sizeof(float) * n);
-      memset(r, 0, sizeof(float) * n);
-      processMessages();
-
-      if (state == TRANSPORT_PLAY) {
-            //
-            // play events for one segment
-            //
-            unsigned framePos = 0;
-            int endTime = playTime + frames;
-            for (; playPos != events.constEnd(); ++playPos) {
-                  int f = cs->utick2utime(playPos.key()) * MScore::sampleRate;
-                  if (f >= endTime)
-                        break;
-                  int n = f - playTime;
-                  if (n < 0) {
-                        qDebug("%d:  %d - %d\n", playPos.key(), f, playTime);
-				n = 0;
-                        }
-                  if (n) {
-                        metronome(n, l, r);
-                        synti->process(n, l, r);
-                        l += n;
-                        r += n;
-                        playTime  += n;
-                        frames    -= n;
-                        framePos  += n;
-                        }
-                  const Event& event = playPos.value();
-                  playEvent(event);
-                  if (event.type() == ME_TICK1)
-                        tickRest = tickLength;
-                  else if (event.type() == ME_TICK2)
-                        tackRest = tackLength;
-                  }
-            if (frames) {
-                  metronome(frames, l, r);
-                  synti->process(frames, l, r);
-                  playTime += frames;
-                  }
-            if (playPos == events.constEnd()) {
-                  driver->stopTransport();
-                  rewindStart();
-                  }
-            }
-      else {
-            synti->process(frames, l, r);
-            }
-      //
-      // metering
-      //
-      int k    = 0;
-      float lv = 0.0f;
-      float rv = 0.0f;
-      for (unsigned i = 0; i < n; ++i) {
-            float val = fabs(lbuffer[k]);
-            if (lv < val)
-                  lv = val;
-            val = fabs(rbuffer[k]);
-            if (rv < val)
-                  rv = val;
-            k++;
-            }
-      meterValue[0] = lv;
-      meterValue[1] = rv;
-      if (meterPeakValue[0] < lv) {
-            meterPeakValue[0] = lv;
-            peakTimer[0] = 0;
-            }
-      if (meterPeakValue[1] < rv) {
-            meterPeakValue[1] = rv;
-            peakTimer[1] = 0;
-            }
-      }
-
-//---------------------------------------------------------
-//   initInstruments
-//---------------------------------------------------------
-
-void Seq::initInstruments()
-      {
-      foreach(const MidiMapping& mm, *cs->midiMapping()) {
-            Channel* channel = mm.articulation;
-            foreach(Event e, channel->init) {
-                  if (e.type() == ME_INVALID)
-                        continue;
-                  e.setChannel(channel->channel);
-                  sendEvent(e);
-                  }
-            }
-      }
-
 //---------------------------------------------------------
 //   collectEvents
 //---------------------------------------------------------
 
 void Seq::collectEvents()
       {
-      events.clear();
-
-      cs->toEList(&events);
-      endTick = 0;
-      if (!events.empty()) {
-            EventMap::const_iterator e = events.constEnd();
-            --e;
-            endTick = e.key();
-            }
-
+      SeqPlayer::collectEvents();
       PlayPanel* pp = mscore->getPlayPanel();
       if (pp)
             pp->setEndpos(endTick);
-      playlistChanged = false;
-      cs->setPlaylistDirty(false);
       }
 
 //---------------------------------------------------------
@@ -707,6 +416,16 @@ int Seq::getCurTick()
 
 void Seq::processToGuiMessages()
       {
+      updateThruChannel();
+      MidiThruEvent e;
+      while (_midiInput.guiEvent(&e)) {
+            if (e.type == ME_NOTEON)
+                  mscore->midiNoteReceived(e.channel, e.dataA, e.dataB);
+            else if (e.type == ME_NOTEOFF)
+                  mscore->midiNoteReceived(e.channel, e.dataA, 0);
+            else if (e.type == ME_CONTROLLER)
+                  mscore->midiCtrlReceived(e.dataA, e.dataB);
+            }
       for (;;) {
             if (fromSeq.isEmpty())
                   break;
@@ -744,21 +463,6 @@ void Seq::setRelTempo(double relTempo)
             }
       }
 
-//---------------------------------------------------------
-//   setPos
-//    seek
-//    realtime environment
-//---------------------------------------------------------
-
-void Seq::setPos(int utick)
-      {
-      stopNotes();
-
-      playTime  = cs->utick2utime(utick) * MScore::sampleRate;
-      playPos   = events.lowerBound(utick);
-      guiPos    = playPos;
-      }
-
 //---------------------------------------------------------
 //   seek
 //    send seek message to sequencer
@@ -996,29 +700,6 @@ void Seq::seekEnd()
       qDebug("seek to end\n");
       }
 
-//---------------------------------------------------------
-//   guiToSeq
-//---------------------------------------------------------
-
-void Seq::guiToSeq(const SeqMsg& msg)
-      {
-      if (!driver || !running)
-            return;
-      toSeq.enqueue(msg);
-      }
-
-//---------------------------------------------------------
-//   eventToGui
-//---------------------------------------------------------
-
-void Seq::eventToGui(Event e)
-      {
-      SeqMsg msg;
-      msg.event = e;
-      msg.id    = SEQ_MIDI_INPUT_EVENT;
-      fromSeq.enqueue(msg);
-      }
-
 //---------------------------------------------------------
 //   getPatchInfo
 //---------------------------------------------------------
@@ -1034,54 +715,45 @@ QList<MidiPatch*> Seq::getPatchInfo() const
 
 void Seq::midiInputReady()
       {
-      if (driver)
-            driver->midiRead();
-      }
-
-//---------------------------------------------------------
-//   SeqMsgFifo
-//---------------------------------------------------------
-
-SeqMsgFifo::SeqMsgFifo()
-      {
-      maxCount = SEQ_MSG_FIFO_SIZE;
-      clear();
+      processToGuiMessages();
       }
 
 //---------------------------------------------------------
-//   enqueue
+//   updateThruChannel
+//    the part which plays midi input is chosen like in
+//    Score::processMidiInput(); note ons are played only
+//    if MuseScore::midiNoteReceived() would take them
 //---------------------------------------------------------
 
-void SeqMsgFifo::enqueue(const SeqMsg& msg)
+void Seq::updateThruChannel()
       {
-      int i = 0;
-      int n = 50;
-
-      QMutex mutex;
-      QWaitCondition qwc;
-      mutex.lock();
-      for (; i < n; ++i) {
-            if (!isFull())
-                  break;
-            qwc.wait(&mutex,100);
-            }
-      if (i == n) {
-            qDebug("===SeqMsgFifo: overflow\n");
+      if (!mscore)
             return;
+      unsigned remote[4] = { 0, 0, 0, 0 };
+      if (preferences.useMidiRemote) {
+            for (int i = 0; i < MIDI_REMOTES; ++i) {
+                  const MidiRemote& r = preferences.midiRemote[i];
+                  if (r.type == MIDI_REMOTE_TYPE_NOTEON && r.data >= 0 && r.data < 128)
+                        remote[r.data >> 5] |= 1u << (r.data & 31);
+                  }
             }
-      messages[widx] = msg;
-      push();
-      }
-
-//---------------------------------------------------------
-//   dequeue
-//---------------------------------------------------------
-
-SeqMsg SeqMsgFifo::dequeue()
-      {
-      SeqMsg msg = messages[ridx];
-      pop();
-      return msg;
+      bool enabled = mscore->midiinEnabled();
+      bool play    = enabled && cv && mscore->midiRecordId() == -1
+         && !QApplication::activeModalWidget();
+      int channel  = -1;
+      if (cs) {
+            int staffIdx = cs->noteEntryMode()
+               ? cs->inputState().track() / VOICES : cs->selection().staffStart();
+            Part* p;
+            if (staffIdx < 0 || staffIdx >= cs->nstaves())
+                  p = cs->part(0);
+            else
+                  p = cs->staff(staffIdx)->part();
+            if (p)
+                  channel = p->instr()->channel(0).channel;
+            }
+      _midiInput.setEnabled(enabled);
+      _midiInput.setThru(channel, play, remote);
       }
 
 //---------------------------------------------------------
@@ -1103,19 +775,6 @@ float Seq::gain() const
       return synti->gain();
       }
 
-//---------------------------------------------------------
-//   putEvent
-//---------------------------------------------------------
-
-void Seq::putEvent(const Event& event)
-      {
-      if (!cs)
-            return;
-      int channel = event.channel();
-      int syntiIdx= cs->midiMapping(channel)->articulation->synti;
-      synti->play(event, syntiIdx);
-      }
-
 //---------------------------------------------------------
 //   synthNameToIndex
 //---------------------------------------------------------
@@ -1141,6 +800,23 @@ QString Seq::synthIndexToName(int idx) const
 
 void Seq::heartBeat()
       {
+      //
+      // transport changes of the audio thread; a stop and
+      // a start since the last beat are taken in the order
+      // they happened
+      //
+      bool started = transportStarted.fetchAndStoreAcquire(0);
+      bool stopped = transportStopped.fetchAndStoreAcquire(0);
+      if (started && stopped && state == TRANSPORT_PLAY) {
+            seqMessage('0');
+            stopped = false;
+            }
+      if (started)
+            seqMessage('1');
+      if (stopped)
+            seqMessage('0');
+      _metronome = mscore->metronome();
+
       SynthControl* sc = mscore->getSynthControl();
       if (sc && driver) {
             if (++peakTimer[0] >= peakHold)
@@ -1148,6 +824,7 @@ void Seq::heartBeat()
             if (++peakTimer[1] >= peakHold)
                   meterPeakValue[1] *= .7f;
             sc->setMeter(meterValue[0], meterValue[1], meterPeakValue[0], meterPeakValue[1]);
+            sc->updateAudioStats(&_audioStats);
             }
       processToGuiMessages();
       if (state != TRANSPORT_PLAY)
@@ -22,10 +22,8 @@
 #define __SEQ_H__
 
 #include "libmscore/sequencer.h"
-#include "libmscore/event.h"
-#include "driver.h"
-#include "libmscore/fifo.h"
 #include "libmscore/tempo.h"
+#include "seqplayer.h"
 
 class Note;
 class QTimer;
@@ -38,88 +36,22 @@ struct Channel;
 class ScoreView;
 class MasterSynth;
 
-//---------------------------------------------------------
-//   SeqMsg
-//    message format for gui -> sequencer messages
-//---------------------------------------------------------
-
-enum { SEQ_NO_MESSAGE, SEQ_TEMPO_CHANGE, SEQ_PLAY, SEQ_SEEK,
-       SEQ_MIDI_INPUT_EVENT
-      };
-
-struct SeqMsg {
-      int id;
-      union {
-            int intVal;
-            qreal realVal;
-            } data;
-      Event event;
-      };
-
-//---------------------------------------------------------
-//   SeqMsgFifo
-//---------------------------------------------------------
-
-static const int SEQ_MSG_FIFO_SIZE = 512;
-
-class SeqMsgFifo : public FifoBase {
-      SeqMsg messages[SEQ_MSG_FIFO_SIZE];
-
-   public:
-      SeqMsgFifo();
-      virtual ~SeqMsgFifo()     {}
-      void enqueue(const SeqMsg&);        // put object on fifo
-      SeqMsg dequeue();                   // remove object from fifo
-      };
-
 //---------------------------------------------------------
 //   Seq
 //    sequencer
 //---------------------------------------------------------
 
-class Seq : public QObject, public Sequencer {
+class Seq : public QObject, public SeqPlayer, public Sequencer {
       Q_OBJECT
 
-      Score* cs;
       ScoreView* cv;
-      bool running;                       // true if sequencer is available
-      int state;                          // TRANSPORT_STOP, TRANSPORT_PLAY, TRANSPORT_STARTING=3
-
-      bool playlistChanged;
-
-      SeqMsgFifo toSeq;
-      SeqMsgFifo fromSeq;
-      Driver* driver;
-
-      double meterValue[2];
-      double meterPeakValue[2];
-      int peakTimer[2];
-
-      EventMap events;                    // playlist
-
-      int playTime;                       // current play position in samples
-      int endTick;
-
-      EventMap::const_iterator playPos;   // moved in real time thread
-      EventMap::const_iterator guiPos;    // moved in gui thread
       QList<const Note*> markedNotes;     // notes marked as sounding
 
-      uint tackRest;     // metronome state
-      uint tickRest;
-      qreal metronomeVolume;
-
       QTimer* heartBeatTimer;
       QTimer* noteTimer;
 
       void collectMeasureEvents(Measure*, int staffIdx);
 
-      void stopTransport();
-      void startTransport();
-      void setPos(int);
-      void playEvent(const Event&);
-      void guiToSeq(const SeqMsg& msg);
-      void metronome(unsigned n, float* l, float* r);
-
    private slots:
       void seqMessage(int msg);
       void heartBeat();
@@ -137,17 +69,11 @@ class Seq : public QObject, public Sequencer {
    signals:
       void started();
       void stopped();
-      int toGui(int);
       void gainChanged(float);
 
    public:
-      // this are also the jack audio transport states:
-      enum { TRANSPORT_STOP=0, TRANSPORT_PLAY=1, TRANSPORT_STARTING=3,
-           TRANSPORT_NET_STARTING=4 };
-
       Seq();
       ~Seq();
-      bool canStart();
       void rewindStart();
       void seekEnd();
       void nextMeasure();
@@ -155,18 +81,14 @@ class Seq : public QObject, public Sequencer {
       void prevMeasure();
       void prevChord();
 
-      void collectEvents();
+      virtual void collectEvents();
       void guiStop();
       void stopWait();
 
+      using SeqPlayer::init;
       bool init();
       void exit();
-      bool isRunning() const    { return running; }
-      bool isPlaying() const    { return state == TRANSPORT_PLAY; }
-      bool isStopped() const    { return state == TRANSPORT_STOP; }
 
-      void processMessages();
-      void process(unsigned, float*, float*);
       QList<QString> inputPorts();
       int getEndTick() const    { return endTick;  }
       bool isRealtime() const   { return true;     }
@@ -175,28 +97,24 @@ class Seq : public QObject, public Sequencer {
       void setController(int, int, int);
       virtual void sendEvent(const Event&);
       void setScoreView(ScoreView*);
-      Score* score() const   { return cs; }
       ScoreView* viewer() const { return cv; }
-      void initInstruments();
 
       QList<MidiPatch*> getPatchInfo() const;
-      Driver* getDriver()  { return driver; }
       int getCurTick();
 
       float gain() const;
 
       int synthNameToIndex(const QString&) const;
       QString synthIndexToName(int) const;
-      void putEvent(const Event&);
       void startNoteTimer(int duration);
       void startNote(const Channel&, int, int, double nt);
-      void eventToGui(Event);
       void processToGuiMessages();
       void stopNoteTimer();
+      void updateThruChannel();
+      virtual bool midiThru() const { return _midiInput.midiThru(); }
       };
 
 extern Seq* seq;
-extern MasterSynth* synti;
 
 extern void initSequencer();
 extern bool initMidi();
@@ -0,0 +1,590 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "config.h"
+#include "seqplayer.h"
+#include "msynth/synti.h"
+#include "libmscore/score.h"
+#include "libmscore/note.h"
+#include "libmscore/staff.h"
+#include "libmscore/part.h"
+#include "libmscore/instrument.h"
+#include "libmscore/repeatlist.h"
+#include "libmscore/tempo.h"
+#include "rtaudit.h"
+#include "click.h"
+
+MasterSynth* synti;
+
+//---------------------------------------------------------
+//   SeqPlayer
+//---------------------------------------------------------
+
+SeqPlayer::SeqPlayer()
+      {
+      running         = false;
+      playlistChanged = false;
+      cs              = 0;
+      endTick         = 0;
+      state           = TRANSPORT_STOP;
+      driver          = 0;
+      playPos         = events.constBegin();
+      guiPos          = playPos;
+
+      playTime        = 0;
+      locateFrame     = -1;
+      locateCycles    = 0;
+      tackRest        = 0;
+      tickRest        = 0;
+      metronomeVolume = 0.3;
+      _metronome      = false;
+      atEnd           = false;
+
+      meterValue[0]     = 0.0;
+      meterValue[1]     = 0.0;
+      meterPeakValue[0] = 0.0;
+      meterPeakValue[1] = 0.0;
+      peakTimer[0]      = 0;
+      peakTimer[1]      = 0;
+      }
+
+//---------------------------------------------------------
+//   init
+//    start the sequencer with the initialized driver d,
+//    which is owned by the sequencer
+//---------------------------------------------------------
+
+bool SeqPlayer::init(Driver* d)
+      {
+      driver = d;
+      MScore::sampleRate = driver->sampleRate();
+      synti->init(MScore::sampleRate);
+      // leave some cores for the gui and the audio driver
+      synti->setRenderThreads(qBound(1, QThread::idealThreadCount() / 2, 4));
+
+      if (!driver->start()) {
+            qDebug("Cannot start I/O\n");
+            return false;
+            }
+      driver->updateOutputPorts(cs);
+      running = true;
+      return true;
+      }
+
+//---------------------------------------------------------
+//   canStart
+//    return true if sequencer can be started
+//---------------------------------------------------------
+
+bool SeqPlayer::canStart()
+      {
+      if (!driver)
+            return false;
+      if (events.empty() || cs->playlistDirty() || playlistChanged)
+            collectEvents();
+      return (!events.empty() && endTick != 0);
+      }
+
+//---------------------------------------------------------
+//   start
+//    play from the play position of the score;
+//    called from the gui thread
+//---------------------------------------------------------
+
+void SeqPlayer::start()
+      {
+      if (events.empty() || cs->playlistDirty() || playlistChanged)
+            collectEvents();
+      SeqMsg msg;
+      msg.id          = SEQ_SEEK;
+      msg.data.intVal = cs->repeatList()->tick2utick(cs->playPos());
+      guiToSeq(msg);
+      atEnd = false;
+      driver->startTransport();
+      }
+
+//---------------------------------------------------------
+//   stopTransport
+//    JACK has stopped
+//    executed in realtime environment
+//---------------------------------------------------------
+
+void SeqPlayer::stopTransport()
+      {
+      state = TRANSPORT_STOP;
+      transportStopped.fetchAndStoreRelease(1);
+      if (cs == 0)
+            return;
+      synti->allNotesOff(-1);
+      // send sustain off
+      chaseEvent.setType(ME_CONTROLLER);
+      chaseEvent.setChannel(0);
+      chaseEvent.setController(CTRL_SUSTAIN);
+      chaseEvent.setValue(0);
+      putEvent(chaseEvent);
+      }
+
+//---------------------------------------------------------
+//   startTransport
+//    JACK has started
+//    executed in realtime environment
+//---------------------------------------------------------
+
+void SeqPlayer::startTransport()
+      {
+      transportStarted.fetchAndStoreRelease(1);
+      state = TRANSPORT_PLAY;
+      }
+
+//---------------------------------------------------------
+//   playEvent
+//    send one event to the synthesizer
+//---------------------------------------------------------
+
+void SeqPlayer::playEvent(const Event& event)
+      {
+      int type = event.type();
+      if (type == ME_NOTEON) {
+            bool mute;
+            const Note* note = event.note();
+
+            if (note) {
+                  Instrument* instr = note->staff()->part()->instr();
+                  const Channel& a = instr->channel(note->subchannel());
+                  mute = a.mute || a.soloMute;
+                  }
+            else
+                  mute = false;
+
+            if (!mute)
+                  putEvent(event);
+            }
+      else if (type == ME_CONTROLLER)
+            putEvent(event);
+      }
+
+//---------------------------------------------------------
+//   processMessages
+//---------------------------------------------------------
+
+void SeqPlayer::processMessages()
+      {
+      for (;;) {
+            if (toSeq.isEmpty())
+                  break;
+            SeqMsg msg = toSeq.dequeue();
+            switch(msg.id) {
+                  case SEQ_TEMPO_CHANGE:
+                        {
+                        if (playTime != 0) {
+                              int tick = cs->utime2utick(qreal(playTime) / qreal(MScore::sampleRate));
+                              cs->tempomap()->setRelTempo(msg.data.realVal);
+                              cs->repeatList()->update();
+                              playTime = cs->utick2utime(tick) * MScore::sampleRate;
+                              locateTransport();
+                              }
+                        else
+                              cs->tempomap()->setRelTempo(msg.data.realVal);
+                        }
+                        break;
+                  case SEQ_PLAY:
+                        putEvent(msg.event);
+                        break;
+                  case SEQ_SEEK:
+                        setPos(msg.data.intVal);
+                        locateTransport();
+                        break;
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   metronome
+//---------------------------------------------------------
+
+void SeqPlayer::metronome(unsigned n, float* l, float* r)
+      {
+      if (!_metronome) {
+            tickRest = 0;
+            tackRest = 0;
+            return;
+            }
+      if (tickRest) {
+            int idx = tickLength - tickRest;
+            int nn = n < tickRest ? n : tickRest;
+            for (int i = 0; i < nn; ++i) {
+                  l[i] += tick[idx] * metronomeVolume;
+                  r[i] += tick[idx] * metronomeVolume;
+                  ++idx;
+                  }
+            tickRest -= nn;
+            }
+      if (tackRest) {
+            int idx = tackLength - tackRest;
+            int nn = n < tackRest ? n : tackRest;
+            for (int i = 0; i < nn; ++i) {
+                  l[i] += tack[idx] * metronomeVolume;
+                  r[i] += tack[idx] * metronomeVolume;
+                  ++idx;
+                  }
+            tackRest -= nn;
+            }
+      }
+
+//---------------------------------------------------------
+//   process
+//---------------------------------------------------------
+
+void SeqPlayer::process(unsigned n, float* lbuffer, float* rbuffer)
+      {
+      RtAuditScope audit;
+      unsigned frames = n;
+      int driverState = driver->getState();
+
+      if (driverState != state) {
+            if (state == TRANSPORT_STOP && driverState == TRANSPORT_PLAY)
+                  startTransport();
+            else if (state == TRANSPORT_PLAY && driverState == TRANSPORT_STOP)
+                  stopTransport();
+            else if (state != driverState)
+                  qDebug("Seq: state transition %d -> %d ?\n",
+                     state, driverState);
+            }
+      //
+      // a transport shared with other applications is the
+      // master of the play position: follow it if it was
+      // moved, hold while our own relocation is pending
+      //
+      int frame = driver->transportFrame();
+      if (frame >= 0 && cs) {
+            if (locateFrame >= 0 && (frame == locateFrame || ++locateCycles >= LOCATE_CYCLES))
+                  locateFrame = -1;
+            if (locateFrame < 0 && frame != playTime) {
+                  setPos(cs->utime2utick(qreal(frame) / qreal(MScore::sampleRate)));
+                  playTime = frame;
+                  }
+            }
+
+      float* l = lbuffer;
+      float* r = rbuffer;
+      float peak[2] = { 0.0f, 0.0f };     // metered by the synthesizer
+      memset(l, 0, sizeof(float) * n);
+      memset(r, 0, sizeof(float) * n);
+      processMessages();
+      processThru();
+
+      if (state == TRANSPORT_PLAY && locateFrame < 0) {
+            //
+            // play events for one segment
+            //
+            unsigned framePos = 0;
+            int endTime = playTime + frames;
+            for (; playPos != events.constEnd(); ++playPos) {
+                  int f = cs->utick2utime(playPos.key()) * MScore::sampleRate;
+                  if (f >= endTime)
+                        break;
+                  int n = f - playTime;
+                  if (n < 0) {
+                        qDebug("%d:  %d - %d\n", playPos.key(), f, playTime);
+				n = 0;
+                        }
+                  if (n) {
+                        metronome(n, l, r);
+                        synti->process(n, l, r, peak);
+                        l += n;
+                        r += n;
+                        playTime  += n;
+                        frames    -= n;
+                        framePos  += n;
+                        }
+                  const Event& event = playPos.value();
+                  playEvent(event);
+                  if (event.type() == ME_TICK1)
+                        tickRest = tickLength;
+                  else if (event.type() == ME_TICK2)
+                        tackRest = tackLength;
+                  }
+            if (frames) {
+                  metronome(frames, l, r);
+                  synti->process(frames, l, r, peak);
+                  playTime += frames;
+                  }
+            if (playPos == events.constEnd()) {
+                  // the gui rewinds
+                  atEnd = true;
+                  driver->stopTransport();
+                  }
+            }
+      else {
+            synti->process(frames, l, r, peak);
+            }
+      float lv = peak[0];
+      float rv = peak[1];
+      meterValue[0] = lv;
+      meterValue[1] = rv;
+      _audioStats.voices(synti->voiceCount());
+      int dropped = synti->takeDroppedEvents();
+      if (dropped)
+            _audioStats.dropped(dropped);
+      if (meterPeakValue[0] < lv) {
+            meterPeakValue[0] = lv;
+            peakTimer[0] = 0;
+            }
+      if (meterPeakValue[1] < rv) {
+            meterPeakValue[1] = rv;
+            peakTimer[1] = 0;
+            }
+      }
+
+//---------------------------------------------------------
+//   initInstruments
+//---------------------------------------------------------
+
+void SeqPlayer::initInstruments()
+      {
+      SeqMsg msg;
+      msg.id = SEQ_PLAY;
+      foreach(const MidiMapping& mm, *cs->midiMapping()) {
+            Channel* channel = mm.articulation;
+            foreach(Event e, channel->init) {
+                  if (e.type() == ME_INVALID)
+                        continue;
+                  e.setChannel(channel->channel);
+                  msg.event = e;
+                  guiToSeq(msg);
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   setScore
+//    play score s; called from the gui thread
+//---------------------------------------------------------
+
+void SeqPlayer::setScore(Score* s)
+      {
+      cs = s;
+      playlistChanged = true;
+      synti->reset();
+      if (cs) {
+            synti->setState(cs->syntiState());
+            initInstruments();
+            }
+      if (driver)
+            driver->updateOutputPorts(cs);
+      tackRest = 0;
+      tickRest = 0;
+      }
+
+//---------------------------------------------------------
+//   collectEvents
+//---------------------------------------------------------
+
+void SeqPlayer::collectEvents()
+      {
+      events.clear();
+
+      cs->toEList(&events);
+      endTick = 0;
+      if (!events.empty()) {
+            EventMap::const_iterator e = events.constEnd();
+            --e;
+            endTick = e.key();
+            }
+      snapshots.build(events, cs);
+      driver->updateOutputPorts(cs);
+      playlistChanged = false;
+      cs->setPlaylistDirty(false);
+      }
+
+//---------------------------------------------------------
+//   setPos
+//    seek
+//    realtime environment
+//---------------------------------------------------------
+
+void SeqPlayer::setPos(int utick)
+      {
+      synti->allNotesOff(-1);
+
+      playTime  = cs->utick2utime(utick) * MScore::sampleRate;
+      playPos   = events.lowerBound(utick);
+      guiPos    = playPos;
+      chase(utick);
+      }
+
+//---------------------------------------------------------
+//   locateTransport
+//    move a shared transport to playTime; playback holds
+//    until the driver reports the new position
+//---------------------------------------------------------
+
+void SeqPlayer::locateTransport()
+      {
+      if (driver->transportFrame() < 0)
+            return;
+      driver->seekTransport(playTime);
+      locateFrame  = playTime;
+      locateCycles = 0;
+      }
+
+//---------------------------------------------------------
+//   chase
+//    set the controllers, programs and pitch bends
+//    changed by the playlist to their state at utick
+//    realtime environment
+//---------------------------------------------------------
+
+void SeqPlayer::chase(int utick)
+      {
+      if (cs == 0)
+            return;
+      const QVector<ChannelState>& state = snapshots.chase(events, utick);
+      // the playlist may not be rebuilt yet for a new score
+      int n = qMin(state.size(), cs->midiMapping()->size());
+      chaseEvent.setType(ME_CONTROLLER);
+      for (int channel = 0; channel < n; ++channel) {
+            const ChannelState& s = state[channel];
+            chaseEvent.setChannel(channel);
+            // bank select before program change
+            for (int ctrl = 0; ctrl < 128; ++ctrl) {
+                  if (s.ctrl[ctrl] != -1) {
+                        chaseEvent.setController(ctrl);
+                        chaseEvent.setValue(s.ctrl[ctrl]);
+                        putEvent(chaseEvent);
+                        }
+                  }
+            if (s.program != -1) {
+                  chaseEvent.setController(CTRL_PROGRAM);
+                  chaseEvent.setValue(s.program);
+                  putEvent(chaseEvent);
+                  }
+            if (s.chasePitch) {
+                  chaseEvent.setController(CTRL_PITCH);
+                  chaseEvent.setValue(s.pitchBend);
+                  putEvent(chaseEvent);
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   guiToSeq
+//---------------------------------------------------------
+
+void SeqPlayer::guiToSeq(const SeqMsg& msg)
+      {
+      if (!driver || !running)
+            return;
+      toSeq.enqueue(msg);
+      }
+
+//---------------------------------------------------------
+//   eventToGui
+//    called from the jack audio thread, the only writer
+//    of fromSeq; the midi input thread has its own fifo
+//---------------------------------------------------------
+
+void SeqPlayer::eventToGui(Event e)
+      {
+      SeqMsg msg;
+      msg.event = e;
+      msg.id    = SEQ_MIDI_INPUT_EVENT;
+      fromSeq.enqueue(msg);
+      }
+
+//---------------------------------------------------------
+//   processThru
+//    audio thread: play the notes from the midi input
+//    thread on the channel of the selected part
+//---------------------------------------------------------
+
+void SeqPlayer::processThru()
+      {
+      MidiThruEvent te;
+      while (_midiInput.thru(&te)) {
+            if (!cs)
+                  continue;
+            thruEvent.setType(te.type);
+            thruEvent.setChannel(te.channel);
+            thruEvent.setDataA(te.dataA);
+            thruEvent.setDataB(te.dataB);
+            putEvent(thruEvent);
+            }
+      }
+
+//---------------------------------------------------------
+//   SeqMsgFifo
+//---------------------------------------------------------
+
+SeqMsgFifo::SeqMsgFifo()
+      {
+      maxCount = SEQ_MSG_FIFO_SIZE;
+      clear();
+      }
+
+//---------------------------------------------------------
+//   enqueue
+//---------------------------------------------------------
+
+void SeqMsgFifo::enqueue(const SeqMsg& msg)
+      {
+      int i = 0;
+      int n = 50;
+
+      QMutex mutex;
+      QWaitCondition qwc;
+      mutex.lock();
+      for (; i < n; ++i) {
+            if (!isFull())
+                  break;
+            qwc.wait(&mutex,100);
+            }
+      if (i == n) {
+            qDebug("===SeqMsgFifo: overflow\n");
+            return;
+            }
+      messages[widx] = msg;
+      push();
+      }
+
+//---------------------------------------------------------
+//   dequeue
+//---------------------------------------------------------
+
+SeqMsg SeqMsgFifo::dequeue()
+      {
+      SeqMsg msg = messages[ridx];
+      pop();
+      return msg;
+      }
+
+//---------------------------------------------------------
+//   putEvent
+//---------------------------------------------------------
+
+void SeqPlayer::putEvent(const Event& event)
+      {
+      if (!cs)
+            return;
+      int channel = event.channel();
+      int syntiIdx= cs->midiMapping(channel)->articulation->synti;
+      synti->play(event, syntiIdx);
+      }
+
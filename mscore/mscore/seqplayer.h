@@ -0,0 +1,162 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __SEQPLAYER_H__
+#define __SEQPLAYER_H__
+
+#include "libmscore/event.h"
+#include "libmscore/fifo.h"
+#include "driver.h"
+#include "midiinput.h"
+#include "audiostats.h"
+#include "seqsnapshot.h"
+
+class Score;
+class MasterSynth;
+
+//---------------------------------------------------------
+//   SeqMsg
+//    message format for gui -> sequencer messages
+//---------------------------------------------------------
+
+enum { SEQ_NO_MESSAGE, SEQ_TEMPO_CHANGE, SEQ_PLAY, SEQ_SEEK,
+       SEQ_MIDI_INPUT_EVENT
+      };
+
+struct SeqMsg {
+      int id;
+      union {
+            int intVal;
+            qreal realVal;
+            } data;
+      Event event;
+      };
+
+//---------------------------------------------------------
+//   SeqMsgFifo
+//---------------------------------------------------------
+
+static const int SEQ_MSG_FIFO_SIZE = 512;
+
+class SeqMsgFifo : public FifoBase {
+      SeqMsg messages[SEQ_MSG_FIFO_SIZE];
+
+   public:
+      SeqMsgFifo();
+      virtual ~SeqMsgFifo()     {}
+      void enqueue(const SeqMsg&);        // put object on fifo
+      SeqMsg dequeue();                   // remove object from fifo
+      };
+
+//---------------------------------------------------------
+//   SeqPlayer
+//    the part of the sequencer which runs without a gui:
+//    plays the playlist of a score into the synthesizer
+//    from the audio thread. The audio thread does not
+//    call into the gui, it leaves flags which Seq takes
+//    on its heart beat.
+//---------------------------------------------------------
+
+class SeqPlayer {
+   protected:
+      Score* cs;
+      bool running;                       // true if sequencer is available
+      int state;                          // TRANSPORT_STOP, TRANSPORT_PLAY, TRANSPORT_STARTING=3
+
+      bool playlistChanged;
+
+      SeqMsgFifo toSeq;
+      SeqMsgFifo fromSeq;
+      Driver* driver;
+
+      MidiInput _midiInput;               // events from the midi input thread
+      Event thruEvent;                    // reused by the audio thread
+
+      double meterValue[2];
+      double meterPeakValue[2];
+      int peakTimer[2];
+      AudioStats _audioStats;             // written by the audio thread
+
+      EventMap events;                    // playlist
+      SeqSnapshots snapshots;             // channel states of the playlist
+      Event chaseEvent;                   // reused by the audio thread
+
+      int playTime;                       // current play position in samples
+      int endTick;
+
+      static const int LOCATE_CYCLES = 8; // wait for a relocation of the transport
+      int locateFrame;                    // own relocation not yet reported, -1: none
+      int locateCycles;
+
+      EventMap::const_iterator playPos;   // moved in real time thread
+      EventMap::const_iterator guiPos;    // moved in gui thread
+
+      uint tackRest;     // metronome state
+      uint tickRest;
+      qreal metronomeVolume;
+      volatile bool _metronome;           // set by the gui
+
+      QAtomicInt transportStarted;        // set by the audio thread, taken by the gui
+      QAtomicInt transportStopped;
+      volatile bool atEnd;                // the transport stopped at the end of the score
+
+      void stopTransport();
+      void startTransport();
+      void setPos(int);
+      void locateTransport();
+      void chase(int utick);
+      void playEvent(const Event&);
+      void guiToSeq(const SeqMsg& msg);
+      void metronome(unsigned n, float* l, float* r);
+      void processThru();
+      void initInstruments();
+
+   public:
+      // this are also the jack audio transport states:
+      enum { TRANSPORT_STOP=0, TRANSPORT_PLAY=1, TRANSPORT_STARTING=3,
+           TRANSPORT_NET_STARTING=4 };
+
+      SeqPlayer();
+      virtual ~SeqPlayer() {}
+
+      bool init(Driver*);
+      void setScore(Score*);
+      virtual void collectEvents();
+      virtual bool canStart();
+      virtual void start();
+
+      bool isRunning() const    { return running; }
+      bool isPlaying() const    { return state == TRANSPORT_PLAY; }
+      bool isStopped() const    { return state == TRANSPORT_STOP; }
+
+      void processMessages();
+      void process(unsigned, float*, float*);
+      void putEvent(const Event&);
+      void eventToGui(Event);
+      Score* score() const      { return cs; }
+      Driver* getDriver()       { return driver; }
+      AudioStats* audioStats()  { return &_audioStats; }
+      MidiInput* midiInput()    { return &_midiInput; }
+      };
+
+extern MasterSynth* synti;
+
+#endif
+
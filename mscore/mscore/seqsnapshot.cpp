@@ -0,0 +1,181 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "seqsnapshot.h"
+#include "libmscore/event.h"
+#include "libmscore/score.h"
+#include "libmscore/instrument.h"
+
+//---------------------------------------------------------
+//   chased
+//    data entry, (n)rpn selection and channel mode
+//    messages depend on the order of the events and are
+//    not chased
+//---------------------------------------------------------
+
+static bool chased(int ctrl)
+      {
+      if (ctrl == CTRL_PROGRAM || ctrl == CTRL_PITCH)
+            return true;
+      if (ctrl < 0 || ctrl >= 120)
+            return false;
+      return ctrl != CTRL_HDATA && ctrl != CTRL_LDATA && (ctrl < 0x60 || ctrl > CTRL_HRPN);
+      }
+
+//---------------------------------------------------------
+//   defaultValue
+//    of a controller after a midi reset
+//---------------------------------------------------------
+
+static int defaultValue(int ctrl)
+      {
+      switch(ctrl) {
+            case CTRL_VOLUME:     return 100;
+            case CTRL_PANPOT:     return 64;
+            case CTRL_EXPRESSION: return 127;
+            default:              return 0;
+            }
+      }
+
+//---------------------------------------------------------
+//   set
+//    apply a controller event if it is chased
+//---------------------------------------------------------
+
+void ChannelState::set(const Event& e)
+      {
+      int c = e.controller();
+      if (c == CTRL_PROGRAM) {
+            if (program != -1)
+                  program = e.value();
+            }
+      else if (c == CTRL_PITCH) {
+            if (chasePitch)
+                  pitchBend = e.value();
+            }
+      else if (c >= 0 && c < 128 && ctrl[c] != -1)
+            ctrl[c] = e.value();
+      }
+
+//---------------------------------------------------------
+//   clear
+//---------------------------------------------------------
+
+void SeqSnapshots::clear()
+      {
+      channels = 0;
+      ticks.clear();
+      states.clear();
+      current.clear();
+      }
+
+//---------------------------------------------------------
+//   build
+//    Only the controllers changed by the playlist are
+//    chased; they start with the value of the instrument
+//    init list or the midi default. Everything else, as
+//    the mixer settings, is left alone by a seek.
+//---------------------------------------------------------
+
+void SeqSnapshots::build(const EventMap& events, Score* score)
+      {
+      clear();
+      channels = score->midiMapping()->size();
+      if (channels == 0)
+            return;
+
+      QVector<ChannelState> state(channels);
+      for (int i = 0; i < channels; ++i) {
+            ChannelState& s = state[i];
+            memset(s.ctrl, -1, sizeof(s.ctrl));
+            s.program    = -1;
+            s.pitchBend  = 0;
+            s.chasePitch = false;
+            }
+      QList<int> measures;                // start of every measure in the playlist
+      for (EventMap::const_iterator i = events.constBegin(); i != events.constEnd(); ++i) {
+            const Event& e = i.value();
+            if (e.type() == ME_TICK1)
+                  measures.append(i.key());
+            if (e.type() != ME_CONTROLLER || e.channel() >= channels || !chased(e.controller()))
+                  continue;
+            ChannelState& s = state[e.channel()];
+            int ctrl = e.controller();
+            if (ctrl == CTRL_PROGRAM)
+                  s.program = 0;
+            else if (ctrl == CTRL_PITCH)
+                  s.chasePitch = true;
+            else
+                  s.ctrl[ctrl] = defaultValue(ctrl);
+            }
+      foreach(const MidiMapping& mm, *score->midiMapping()) {
+            const Channel* a = mm.articulation;
+            if (a->channel >= channels)
+                  continue;
+            foreach(const Event& e, a->init) {
+                  if (e.type() == ME_CONTROLLER)
+                        state[a->channel].set(e);
+                  }
+            }
+
+      ticks.append(-1);
+      states += state;
+
+      int m = MEASURES;
+      for (EventMap::const_iterator i = events.constBegin(); i != events.constEnd(); ++i) {
+            for (; m < measures.size() && i.key() >= measures[m]; m += MEASURES) {
+                  ticks.append(measures[m]);
+                  states += state;
+                  }
+            const Event& e = i.value();
+            if (e.type() == ME_CONTROLLER && e.channel() < channels)
+                  state[e.channel()].set(e);
+            }
+      current = state;
+      }
+
+//---------------------------------------------------------
+//   chase
+//    the state of all channels before the events at
+//    utick: binary search for the last snapshot, then
+//    play the controller events up to utick, which are
+//    at most MEASURES measures
+//---------------------------------------------------------
+
+const QVector<ChannelState>& SeqSnapshots::chase(const EventMap& events, int utick)
+      {
+      if (channels == 0)
+            return current;
+      int idx = qUpperBound(ticks.constBegin(), ticks.constEnd(), utick) - ticks.constBegin() - 1;
+      ChannelState* s = current.data();
+      memcpy(s, states.constData() + idx * channels, channels * sizeof(ChannelState));
+
+      if (ticks[idx] == utick)
+            return current;
+      EventMap::const_iterator i   = events.lowerBound(ticks[idx]);
+      EventMap::const_iterator end = events.lowerBound(utick);
+      for (; i != end; ++i) {
+            const Event& e = i.value();
+            if (e.type() == ME_CONTROLLER && e.channel() < channels)
+                  s[e.channel()].set(e);
+            }
+      return current;
+      }
+
@@ -0,0 +1,72 @@
+//=============================================================================
+//  MuseScore
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __SEQSNAPSHOT_H__
+#define __SEQSNAPSHOT_H__
+
+class Score;
+class Event;
+class EventMap;
+
+//---------------------------------------------------------
+//   ChannelState
+//    the controllers of a midi channel which are changed
+//    by the playlist; -1: not chased
+//---------------------------------------------------------
+
+struct ChannelState {
+      signed char ctrl[128];
+      int program;
+      int pitchBend;
+      bool chasePitch;
+
+      void set(const Event&);
+      };
+
+//---------------------------------------------------------
+//   SeqSnapshots
+//    The state of all channels before the events at the
+//    start of every MEASURES measures of the playlist.
+//    A seek starts from the last snapshot before the
+//    position and chases only the controller events
+//    after it.
+//    build() is called in the gui thread together with
+//    the playlist, chase() in the audio thread; chase()
+//    does not allocate.
+//---------------------------------------------------------
+
+class SeqSnapshots {
+      int channels;
+      QVector<int> ticks;                 // utick of every snapshot, ticks[0] == -1
+      QVector<ChannelState> states;       // channels states per snapshot
+      QVector<ChannelState> current;      // result of chase()
+
+   public:
+      static const int MEASURES = 4;      // measures between two snapshots
+
+      SeqSnapshots() : channels(0) {}
+      void build(const EventMap&, Score*);
+      void clear();
+      const QVector<ChannelState>& chase(const EventMap&, int utick);
+      int size() const                    { return ticks.size(); }
+      };
+
+#endif
+
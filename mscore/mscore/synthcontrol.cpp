@@ -117,6 +117,11 @@ SynthControl::SynthControl(QWidget* parent)
       connect(soundFontDelete, SIGNAL(clicked()),                SLOT(sfDeleteClicked()));
       connect(soundFontAdd,    SIGNAL(clicked()),                SLOT(sfAddClicked()));
       connect(soundFonts,      SIGNAL(currentRowChanged(int)),   SLOT(currentSoundFontChanged(int)));
+      connect(resetStats,      SIGNAL(clicked()),                SLOT(resetStatsClicked()));
+      connect(saveStats,       SIGNAL(clicked()),                SLOT(saveStatsClicked()));
+      QFont font("Courier");
+      font.setStyleHint(QFont::TypeWriter);
+      statHistogram->setFont(font);
 
       updateSyntiValues();
       }
@@ -337,6 +342,59 @@ void SynthControl::setMeter(float l, float r, float left_peak, float right_peak)
       gain->setMeterVal(1, r, right_peak);
       }
 
+//---------------------------------------------------------
+//   updateAudioStats
+//    called from Seq::heartBeat()
+//---------------------------------------------------------
+
+void SynthControl::updateAudioStats(AudioStats* stats)
+      {
+      if (!audioTab->isVisible())
+            return;
+      AudioStatsData d;
+      stats->get(&d);
+      statCycles->setText(QString::number(d.cycles));
+      statLoad->setText(tr("%1% now, %2% avg, %3% max")
+         .arg(d.load / 10.0, 0, 'f', 1)
+         .arg(d.averageLoad() / 10.0, 0, 'f', 1)
+         .arg(d.maxLoad / 10.0, 0, 'f', 1));
+      statMisses->setText(QString::number(d.misses));
+      statXruns->setText(QString::number(d.xruns));
+      statDropped->setText(QString::number(d.dropped));
+      statVoices->setText(tr("%1 now, %2 max").arg(d.voices).arg(d.maxVoices));
+      QString s = d.report();
+      if (s != statHistogram->toPlainText())
+            statHistogram->setPlainText(s);
+      }
+
+//---------------------------------------------------------
+//   resetStatsClicked
+//---------------------------------------------------------
+
+void SynthControl::resetStatsClicked()
+      {
+      seq->audioStats()->reset();
+      updateAudioStats(seq->audioStats());
+      }
+
+//---------------------------------------------------------
+//   saveStatsClicked
+//---------------------------------------------------------
+
+void SynthControl::saveStatsClicked()
+      {
+      QString fn = QFileDialog::getSaveFileName(this,
+         tr("MuseScore: Save Audio Statistics"),
+         QDir::homePath() + "/audiostats.txt",
+         tr("Text Files (*.txt);;" "All Files (*)"));
+      if (fn.isEmpty())
+            return;
+      if (!seq->audioStats()->dump(fn)) {
+            QMessageBox::warning(this, tr("MuseScore: Save Audio Statistics"),
+               tr("Writing %1 failed").arg(fn));
+            }
+      }
+
 //---------------------------------------------------------
 //   stop
 //---------------------------------------------------------
@@ -29,6 +29,7 @@ namespace Awl {
       };
 
 class Score;
+class AudioStats;
 
 //---------------------------------------------------------
 //   SynthControl
@@ -59,6 +60,8 @@ class SynthControl : public QWidget, Ui::SynthControl {
       void currentSoundFontChanged(int row);
       void chorusNumberChanged(int val);
       void chorusTypeChanged(int val);
+      void resetStatsClicked();
+      void saveStatsClicked();
 
    signals:
       void closed();
@@ -72,6 +75,7 @@ class SynthControl : public QWidget, Ui::SynthControl {
       SynthControl(QWidget* parent);
       void updatePreferences();
       void setMeter(float, float, float, float);
+      void updateAudioStats(AudioStats*);
       void stop();
       void setScore(Score*);
       };
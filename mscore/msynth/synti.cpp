@@ -89,14 +89,58 @@ void MasterSynth::init(int sampleRate)
       _gain = preferences.masterGain;
       }
 
+//---------------------------------------------------------
+//   meter
+//    raise peak to the peak of the buffers
+//---------------------------------------------------------
+
+static void meter(unsigned n, const float* l, const float* r, float* peak)
+      {
+      float lv = peak[0];
+      float rv = peak[1];
+      for (unsigned i = 0; i < n; ++i) {
+            lv = qMax(lv, fabsf(l[i]));
+            rv = qMax(rv, fabsf(r[i]));
+            }
+      peak[0] = lv;
+      peak[1] = rv;
+      }
+
+//---------------------------------------------------------
+//   processMetered
+//    synthesizers which mix into the output in a final
+//    loop meter there instead
+//---------------------------------------------------------
+
+void Synth::processMetered(unsigned n, float* l, float* r, float gain, float* peak)
+      {
+      process(n, l, r, gain);
+      meter(n, l, r, peak);
+      }
+
 //---------------------------------------------------------
 //   process
+//    the last active synthesizer meters the output if
+//    peak is given
 //---------------------------------------------------------
 
-void MasterSynth::process(unsigned n, float* l, float* r)
+void MasterSynth::process(unsigned n, float* l, float* r, float* peak)
       {
+      Synth* last = 0;
+      if (peak) {
+            foreach(Synth* s, syntis) {
+                  if (s->active())
+                        last = s;
+                  }
+            if (last == 0) {
+                  meter(n, l, r, peak);
+                  return;
+                  }
+            }
       foreach(Synth* s, syntis) {
-            if (s->active())
+            if (s == last)
+                  s->processMetered(n, l, r, _gain, peak);
+            else if (s->active())
                   s->process(n, l, r, _gain);
             }
       }
@@ -229,6 +273,63 @@ void MasterSynth::allNotesOff(int channel)
             synti->allNotesOff(channel);
       }
 
+//---------------------------------------------------------
+//   voiceCount
+//---------------------------------------------------------
+
+int MasterSynth::voiceCount() const
+      {
+      int n = 0;
+      foreach(const Synth* s, syntis) {
+            if (s->active())
+                  n += s->voiceCount();
+            }
+      return n;
+      }
+
+//---------------------------------------------------------
+//   takeDroppedEvents
+//---------------------------------------------------------
+
+int MasterSynth::takeDroppedEvents()
+      {
+      int n = 0;
+      foreach(Synth* s, syntis)
+            n += s->takeDroppedEvents();
+      return n;
+      }
+
+//---------------------------------------------------------
+//   setRenderThreads
+//---------------------------------------------------------
+
+void MasterSynth::setRenderThreads(int n)
+      {
+      foreach(Synth* synti, syntis)
+            synti->setRenderThreads(n);
+      }
+
+//---------------------------------------------------------
+//   setOffline
+//---------------------------------------------------------
+
+void MasterSynth::setOffline(bool val)
+      {
+      foreach(Synth* synti, syntis)
+            synti->setOffline(val);
+      }
+
+//---------------------------------------------------------
+//   setDirectOutputs
+//    called from the audio thread
+//---------------------------------------------------------
+
+void MasterSynth::setDirectOutputs(float** out, int channels)
+      {
+      foreach(Synth* synti, syntis)
+            synti->setDirectOutputs(out, channels);
+      }
+
 //---------------------------------------------------------
 //   synth
 //---------------------------------------------------------
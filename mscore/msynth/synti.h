@@ -53,6 +53,9 @@ class Synth {
       virtual QStringList soundFonts() const = 0;
 
       virtual void process(unsigned, float*, float*, float) = 0;
+      // as process(), raises peak[0] and peak[1] to the peak
+      // of the left and right output after mixing
+      virtual void processMetered(unsigned, float*, float*, float, float* peak);
       virtual void play(const Event&) = 0;
 
       virtual const QList<MidiPatch*>& getPatchInfo() const = 0;
@@ -71,6 +74,27 @@ class Synth {
 
       virtual void allSoundsOff(int /*channel*/) {}
       virtual void allNotesOff(int /*channel*/) {}
+
+      // number of sounding voices, called from the audio thread
+      virtual int voiceCount() const { return 0; }
+
+      // number of events lost because a queue was full since
+      // the last call, called from the audio thread
+      virtual int takeDroppedEvents() { return 0; }
+
+      // number of threads used for rendering; 1 renders
+      // on the calling thread only
+      virtual void setRenderThreads(int) {}
+
+      // offline rendering: nothing is skipped to meet a
+      // deadline, e.g. samples are loaded synchronously
+      virtual void setOffline(bool) {}
+
+      // direct outputs: the dry signal of channel c is mixed
+      // into the stereo buffers out[c*2], out[c*2+1] instead
+      // of the output, if they are not 0. Set by the audio
+      // thread before every cycle; out == 0: no direct outputs
+      virtual void setDirectOutputs(float** /*out*/, int /*channels*/) {}
       };
 
 //---------------------------------------------------------
@@ -85,8 +109,9 @@ class MasterSynth {
       MasterSynth();
       ~MasterSynth();
       void init(int sampleRate);
+      void addSynth(Synth* s) { syntis.append(s); }   // takes ownership
 
-      void process(unsigned, float*, float*);
+      void process(unsigned, float*, float*, float* peak = 0);
       void play(const Event&, int);
 
       double gain() const     { return _gain; }
@@ -112,6 +137,11 @@ class MasterSynth {
       void reset();
       void allSoundsOff(int channel);
       void allNotesOff(int channel);
+      int voiceCount() const;
+      int takeDroppedEvents();
+      void setRenderThreads(int);
+      void setOffline(bool);
+      void setDirectOutputs(float**, int);
       };
 
 #endif
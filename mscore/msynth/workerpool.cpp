@@ -0,0 +1,147 @@
+//=============================================================================
+//  MusE Score
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2002-2012 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#include "workerpool.h"
+
+#ifndef Q_OS_WIN
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//---------------------------------------------------------
+//   cpuRelax
+//---------------------------------------------------------
+
+static inline void cpuRelax()
+      {
+#if defined(__i386__) || defined(__x86_64__)
+      __asm__ __volatile__("pause");
+#endif
+      }
+
+//---------------------------------------------------------
+//   PoolWorker
+//---------------------------------------------------------
+
+PoolWorker::PoolWorker(WorkerPool* p, int idx)
+      {
+      pool        = p;
+      index       = idx;
+      state       = IDLE;
+      schedSerial = 0;
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void PoolWorker::run()
+      {
+      QElapsedTimer idle;
+      idle.start();
+      while (!pool->quitFlag) {
+#ifndef Q_OS_WIN
+            int serial = pool->schedSerial.fetchAndAddAcquire(0);
+            if (serial != schedSerial) {
+                  schedSerial = serial;
+                  struct sched_param p;
+                  p.sched_priority = pool->schedPriority;
+                  if (pthread_setschedparam(pthread_self(), pool->schedPolicy, &p))
+                        qDebug("PoolWorker: cannot take the scheduling of the audio thread");
+                  }
+#endif
+            if (state.testAndSetAcquire(READY, TAKEN)) {
+                  pool->job(index);
+                  state.fetchAndStoreRelease(DONE);
+                  idle.start();
+                  }
+            else if (idle.elapsed() < WorkerPool::SPIN_MS)
+                  cpuRelax();
+            else
+                  usleep(WorkerPool::SLEEP_US);
+            }
+      }
+
+//---------------------------------------------------------
+//   WorkerPool
+//    threads is the total number of threads including
+//    the calling thread
+//---------------------------------------------------------
+
+WorkerPool::WorkerPool(int threads)
+      {
+      quitFlag      = false;
+      schedKnown    = false;
+      schedPolicy   = 0;
+      schedPriority = 0;
+      for (int i = 1; i < threads; ++i) {
+            PoolWorker* w = new PoolWorker(this, i);
+            workers.append(w);
+            w->start(QThread::TimeCriticalPriority);
+            }
+      }
+
+WorkerPool::~WorkerPool()
+      {
+      quitFlag = true;
+      foreach(PoolWorker* w, workers) {
+            w->wait();
+            delete w;
+            }
+      }
+
+//---------------------------------------------------------
+//   run
+//    run all shares of the current job; returns when all
+//    are done. Called from the audio thread, the only
+//    waiting is for shares a worker is running.
+//---------------------------------------------------------
+
+void WorkerPool::run()
+      {
+#ifndef Q_OS_WIN
+      if (!schedKnown) {
+            // plain system calls, pthread_getschedparam() locks
+            struct sched_param p;
+            schedPolicy   = sched_getscheduler(0);
+            schedPriority = sched_getparam(0, &p) == 0 ? p.sched_priority : 0;
+            schedKnown    = true;
+            schedSerial.fetchAndAddRelease(1);
+            }
+#endif
+      int n = workers.size();
+      for (int i = 0; i < n; ++i)
+            workers[i]->state.fetchAndStoreRelease(PoolWorker::READY);
+      job(0);
+      for (int i = 0; i < n; ++i) {
+            PoolWorker* w = workers[i];
+            if (w->state.testAndSetAcquire(PoolWorker::READY, PoolWorker::TAKEN)) {
+                  job(w->index);
+                  w->state.fetchAndStoreRelease(PoolWorker::DONE);
+                  }
+            }
+      for (int i = 0; i < n; ++i) {
+            PoolWorker* w = workers[i];
+            while (w->state.fetchAndAddAcquire(0) != PoolWorker::DONE)
+                  cpuRelax();
+            w->state.fetchAndStoreRelaxed(PoolWorker::IDLE);
+            }
+      }
+
@@ -0,0 +1,82 @@
+//=============================================================================
+//  MusE Score
+//  Linux Music Score Editor
+//  $Id:$
+//
+//  Copyright (C) 2002-2012 Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//=============================================================================
+
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+class WorkerPool;
+
+//---------------------------------------------------------
+//   PoolWorker
+//---------------------------------------------------------
+
+class PoolWorker : public QThread {
+      enum { IDLE, READY, TAKEN, DONE };
+
+      WorkerPool* pool;
+      int index;                    // share of the job, 0 is the caller's
+      QAtomicInt state;
+      int schedSerial;              // of the scheduling applied last
+
+      virtual void run();
+
+   public:
+      PoolWorker(WorkerPool*, int index);
+      friend class WorkerPool;
+      };
+
+//---------------------------------------------------------
+//   WorkerPool
+//    Runs job() once per thread on the worker threads and
+//    the calling (audio) thread. The caller takes no lock
+//    and makes no system call: a job is handed over with
+//    atomic flags. After a job a worker spins for SPIN_MS
+//    and then polls every SLEEP_US; the caller runs the
+//    shares its workers have not taken by the time its
+//    own share is done. The workers take the scheduling
+//    policy and priority of the caller.
+//---------------------------------------------------------
+
+class WorkerPool {
+      static const int SPIN_MS  = 5;
+      static const int SLEEP_US = 500;
+
+      QList<PoolWorker*> workers;
+      volatile bool quitFlag;
+
+      // scheduling of the caller, published by run()
+      bool schedKnown;
+      int schedPolicy;
+      int schedPriority;
+      QAtomicInt schedSerial;
+
+   protected:
+      virtual void job(int idx) = 0;      // run share idx of the current job
+
+   public:
+      WorkerPool(int threads);
+      virtual ~WorkerPool();
+      int threads() const           { return workers.size() + 1; }
+      void run();
+      friend class PoolWorker;
+      };
+
+#endif
+
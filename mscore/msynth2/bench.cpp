@@ -0,0 +1,195 @@
+//=============================================================================
+//  MuseSynth
+//  Music Software Synthesizer
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENSE.GPL
+//=============================================================================
+
+//---------------------------------------------------------
+//    msbench: compare loading whole samples against
+//    streaming them from disk on a synthetic instrument
+//
+//    msbench [-s seconds] [-p preload_ms] [-v voices] [-f] dir
+//---------------------------------------------------------
+
+#include "msynth.h"
+#include "event.h"
+#include "instrument.h"
+#include "stream.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <sndfile.h>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QElapsedTimer>
+
+static const int SAMPLERATE = 44100;
+static const int BLOCK      = 256;
+static const int OCTAVES    = 7;
+
+//---------------------------------------------------------
+//   writeSample
+//    a decaying stereo tone of the given length
+//---------------------------------------------------------
+
+static bool writeSample(const QString& path, int key, int seconds)
+      {
+      SF_INFO info;
+      info.samplerate = SAMPLERATE;
+      info.channels   = 2;
+      info.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+      SNDFILE* sf = sf_open(path.toLocal8Bit().data(), SFM_WRITE, &info);
+      if (sf == 0) {
+            fprintf(stderr, "cannot create <%s>: %s\n", qPrintable(path), sf_strerror(0));
+            return false;
+            }
+      double freq = 440.0 * pow(2.0, (key - 69) / 12.0);
+      float buffer[BLOCK * 2];
+      int frames = seconds * SAMPLERATE;
+      for (int i = 0; i < frames; i += BLOCK) {
+            for (int k = 0; k < BLOCK; ++k) {
+                  double t = double(i + k) / SAMPLERATE;
+                  float v  = sin(2.0 * M_PI * freq * t) * exp(-t * 0.2) * 0.5;
+                  buffer[k * 2]     = v;
+                  buffer[k * 2 + 1] = v * 0.8;
+                  }
+            sf_writef_float(sf, buffer, qMin(BLOCK, frames - i));
+            }
+      sf_close(sf);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   writeInstrument
+//    one sample per octave
+//---------------------------------------------------------
+
+static QString writeInstrument(const QString& dir, int seconds)
+      {
+      QDir().mkpath(dir);
+      QString path = dir + "/bench.msfz";
+      QFile f(path);
+      if (!f.open(QIODevice::WriteOnly))
+            return QString();
+      QString s = QString("<?xml version=\"1.0\" encoding=\"utf8\"?>\n"
+         "<MuseSynth version=\"1.0\">\n"
+         "  <Instrument>\n"
+         "    <name>Bench</name>\n"
+         "    <patch>0</patch>\n"
+         "    <path>%1</path>\n"
+         "    <Group>\n"
+         "      <velo>0,127</velo>\n").arg(dir);
+      for (int octave = 1; octave <= OCTAVES; ++octave) {
+            QString name = QString("bench-c%1.wav").arg(octave);
+            QString file = dir + "/" + name;
+            if (!QFile::exists(file) && !writeSample(file, 12 * (octave + 1), seconds))
+                  return QString();
+            s += QString("      <Region>\n"
+               "        <sample>%1</sample>\n"
+               "        <pitch>c%2,c%2,b%2</pitch>\n"
+               "        </Region>\n").arg(name).arg(octave);
+            }
+      s += "      </Group>\n    </Instrument>\n  </MuseSynth>\n";
+      f.write(s.toUtf8());
+      return path;
+      }
+
+//---------------------------------------------------------
+//   run
+//    load the instrument and play voices notes for
+//    seconds; with paced set the blocks are rendered
+//    in real time
+//---------------------------------------------------------
+
+static void run(const QString& path, int preload, int voices, int seconds, bool paced)
+      {
+      qint64 bytes = Sample::residentBytes();
+      MSynth* synth = new MSynth;
+      synth->setSamplerate(SAMPLERATE);
+      synth->setPreloadTime(preload);
+
+      QElapsedTimer timer;
+      timer.start();
+      if (!synth->loadInstrument(path.toLocal8Bit().data())) {
+            fprintf(stderr, "cannot load instrument\n");
+            delete synth;
+            return;
+            }
+      qint64 loadTime = timer.elapsed();
+      bytes = Sample::residentBytes() - bytes;
+
+      float l[BLOCK], r[BLOCK];
+      int blocks      = seconds * SAMPLERATE / BLOCK;
+      int noteBlocks  = qMax(1, blocks / voices / 2);
+      qint64 maxBlock = 0;
+      qint64 busy     = 0;
+      int notes       = 0;
+      timer.start();
+      for (int i = 0; i < blocks; ++i) {
+            if ((i % noteBlocks) == 0 && notes < voices) {
+                  synth->play(Event(ME_NOTEON, 0, 24 + (notes * 7) % 84, 100));
+                  ++notes;
+                  }
+            qint64 t0 = timer.nsecsElapsed();
+            synth->process(BLOCK, l, r, 1);
+            qint64 t = timer.nsecsElapsed() - t0;
+            busy    += t;
+            maxBlock = qMax(maxBlock, t);
+            if (paced) {
+                  qint64 deadline = qint64(i + 1) * BLOCK * 1000000000LL / SAMPLERATE;
+                  qint64 now = timer.nsecsElapsed();
+                  if (now < deadline)
+                        usleep((deadline - now) / 1000);
+                  }
+            }
+      printf("preload %5d ms: load %6lld ms, resident %8lld kB, "
+         "render %6.2f x realtime, max block %6lld us, underruns %d\n",
+         preload, loadTime, bytes / 1024,
+         double(blocks) * BLOCK / SAMPLERATE * 1e9 / qMax(busy, qint64(1)),
+         maxBlock / 1000, synth->streamer()->underruns());
+      delete synth;
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      int seconds = 30;
+      int preload = 500;
+      int voices  = 64;
+      bool paced  = true;
+      int c;
+      while ((c = getopt(argc, argv, "s:p:v:f")) != EOF) {
+            switch (c) {
+                  case 's': seconds = atoi(optarg); break;
+                  case 'p': preload = atoi(optarg); break;
+                  case 'v': voices  = atoi(optarg); break;
+                  case 'f': paced   = false; break;
+                  default:
+                        fprintf(stderr, "usage: msbench [-s seconds] [-p preload_ms] [-v voices] [-f] dir\n");
+                        return 1;
+                  }
+            }
+      if (optind != argc - 1) {
+            fprintf(stderr, "usage: msbench [-s seconds] [-p preload_ms] [-v voices] [-f] dir\n");
+            return 1;
+            }
+      QString path = writeInstrument(QDir(argv[optind]).absolutePath(), seconds);
+      if (path.isEmpty()) {
+            fprintf(stderr, "cannot write instrument\n");
+            return 1;
+            }
+      run(path, 0, voices, seconds, paced);
+      run(path, preload, voices, seconds, paced);
+      return 0;
+      }
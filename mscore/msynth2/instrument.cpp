@@ -58,24 +58,31 @@ static char parsePitch(const QString& s)
 //   Sample
 //---------------------------------------------------------
 
+qint64 Sample::_residentBytes = 0;
+
 Sample::Sample()
       {
       _data     = 0;
       _frames   = 0;
       _channels = 0;
+      _resident = 0;
       }
 
 Sample::~Sample()
       {
-      delete _data;
+      if (_data)
+            _residentBytes -= (_resident + 3) * _channels * sizeof(float);
+      delete[] _data;
       }
 
 //---------------------------------------------------------
 //   read
-//    return true on success
+//    keep only the first preloadTime ms of a stereo sample
+//    in memory if the file can be streamed, 0 loads the
+//    whole sample; return true on success
 //---------------------------------------------------------
 
-bool Sample::read(const QString& s)
+bool Sample::read(const QString& s, int preloadTime)
       {
 //      printf("Sample::read: %s\n", qPrintable(s));
       SF_INFO info;
@@ -85,18 +92,34 @@ bool Sample::read(const QString& s)
             printf("open <%s> failed\n", s.toLocal8Bit().data());
             return false;
             }
+      _path     = s;
       _channels = info.channels;
       _frames   = info.frames;
-      _data     = new float[(_frames + 3) * _channels];
-      if (_frames != sf_readf_float(sf, _data + _channels, _frames)) {
+      _resident = _frames;
+      if (preloadTime > 0 && _channels == 2 && info.seekable) {
+            // the ring buffers of the streamer are stereo and
+            // the streamer seeks; anything else is loaded whole
+            int n = int(qint64(preloadTime) * info.samplerate / 1000);
+            if (n + 3 < _frames)
+                  _resident = n;
+            }
+      _data     = new float[(_resident + 3) * _channels];
+      _residentBytes += (_resident + 3) * _channels * sizeof(float);
+      if (_resident != sf_readf_float(sf, _data + _channels, _resident)) {
             printf("Sample read failed: %s\n", sf_strerror(sf));
             sf_close(sf);
             return false;
             }
       for (int i = 0; i < _channels; ++i) {
             _data[i] = _data[i + _channels];
-            _data[(_frames-2) * _channels + i] = _data[(_frames-3) * _channels + i];
-            _data[(_frames-1) * _channels + i] = _data[(_frames-3) * _channels + i];
+            if (streamed()) {
+                  _data[(_resident+1) * _channels + i] = 0.0;
+                  _data[(_resident+2) * _channels + i] = 0.0;
+                  }
+            else {
+                  _data[(_frames-2) * _channels + i] = _data[(_frames-3) * _channels + i];
+                  _data[(_frames-1) * _channels + i] = _data[(_frames-3) * _channels + i];
+                  }
             }
       sf_close(sf);
       return true;
@@ -221,7 +244,7 @@ bool Instrument::read(QDomElement e)
                                     QString tag(eee.tagName());
                                     if (tag == "sample") {
                                           sample = new Sample;
-                                          if (!sample->read(path + "/" + eee.text())) {
+                                          if (!sample->read(path + "/" + eee.text(), _msynth->preloadTime())) {
                                                 delete sample;
                                                 sample = 0;
                                                 }
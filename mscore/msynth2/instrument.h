@@ -22,20 +22,32 @@ class MSynth;
 
 //---------------------------------------------------------
 //   Sample
+//    With a preload time set (MSynth::setPreloadTime()),
+//    only the start of a stereo sample is kept in memory; voices stream the rest
+//    from disk (see Streamer).
 //---------------------------------------------------------
 
 class Sample {
       float* _data;
       int _frames;
       int _channels;
+      int _resident;          // frames in _data
+      QString _path;
+
+      static qint64 _residentBytes;
 
    public:
       Sample();
       ~Sample();
-      bool read(const QString&);
-      int frames() const   { return _frames;           }
-      int channels() const { return _channels;         }
-      float* data() const  { return _data + _channels; }
+      bool read(const QString&, int preloadTime = 0);
+      int frames() const     { return _frames;           }
+      int channels() const   { return _channels;         }
+      float* data() const    { return _data + _channels; }
+      int resident() const   { return _resident;         }
+      bool streamed() const  { return _resident < _frames; }
+      const QString& path() const { return _path;        }
+
+      static qint64 residentBytes()      { return _residentBytes; }
       };
 
 //---------------------------------------------------------
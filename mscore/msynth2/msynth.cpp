@@ -16,6 +16,7 @@
 #include "voice.h"
 #include "channel.h"
 #include "instrument.h"
+#include "stream.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -37,6 +38,9 @@ MSynth::MSynth()
       reverb      = new Effect;   // dummy
       chorus      = new Effect;   // dummy
       silentBlocks = 0;
+      _preloadTime = 0;
+      _streamer   = new Streamer;
+      _streamer->start(QThread::HighPriority);
       }
 
 //---------------------------------------------------------
@@ -45,6 +49,8 @@ MSynth::MSynth()
 
 MSynth::~MSynth()
       {
+      _streamer->stop();
+      delete _streamer;
       delete reverb;
       delete chorus;
       }
@@ -106,6 +112,7 @@ void MSynth::noteOn(Channel* channel, int key, int velocity, float tuning)
 void MSynth::stopVoice(Voice* v)
       {
       _activeVoices.removeOne(v);
+      v->releaseStream();
       freeVoices.append(v);
       }
 
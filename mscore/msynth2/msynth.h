@@ -23,6 +23,7 @@ class Voice;
 class MSynth;
 class Channel;
 class Instrument;
+class Streamer;
 
 //---------------------------------------------------------
 //   Effect
@@ -53,6 +54,8 @@ class MSynth {
       QList<Voice*> _activeVoices;
       Effect* reverb;
       Effect* chorus;
+      Streamer* _streamer;
+      int _preloadTime;             // ms, 0: load whole samples
 
       void programChange(int channel, int program);
       void noteOn(Channel*, int key, int velocity, float tuning);
@@ -63,6 +66,9 @@ class MSynth {
       ~MSynth();
       static int samplerate()     { return _samplerate; }
       void setSamplerate(int val) { _samplerate = val; }
+      void setPreloadTime(int ms)  { _preloadTime = ms;   }
+      int preloadTime() const      { return _preloadTime; }
+      Streamer* streamer() const  { return _streamer; }
 
       void process(int frames, float* l, float* r, int stride);
       void play(const Event& event);
@@ -0,0 +1,209 @@
+//=============================================================================
+//  MuseSynth
+//  Music Software Synthesizer
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENSE.GPL
+//=============================================================================
+
+#include "stream.h"
+#include "instrument.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sndfile.h>
+
+//---------------------------------------------------------
+//   Stream
+//---------------------------------------------------------
+
+Stream::Stream()
+      {
+      _sample = 0;
+      _start  = 0;
+      _ring   = new float[RING_FRAMES * 2];
+      }
+
+Stream::~Stream()
+      {
+      delete[] _ring;
+      }
+
+//---------------------------------------------------------
+//   acquire
+//    called from the audio thread; the stream is handed
+//    to the streamer by setting it ACTIVE
+//---------------------------------------------------------
+
+bool Stream::acquire(Sample* s, int start)
+      {
+      if (!_state.testAndSetAcquire(FREE, STARTING))
+            return false;
+      _sample = s;
+      _start  = start;
+      _filled.fetchAndStoreRelaxed(start);
+      _readPos.fetchAndStoreRelaxed(start);
+      _state.fetchAndStoreRelease(ACTIVE);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   frame
+//    return the (stereo) frame f; the caller checks
+//    f against filled()
+//---------------------------------------------------------
+
+const float* Stream::frame(int f) const
+      {
+      return _ring + ((f - _start) & RING_MASK) * 2;
+      }
+
+//---------------------------------------------------------
+//   Streamer
+//---------------------------------------------------------
+
+Streamer::Streamer()
+      {
+      quitFlag = false;
+      }
+
+Streamer::~Streamer()
+      {
+      stop();
+      closeFiles(0);
+      }
+
+//---------------------------------------------------------
+//   stop
+//---------------------------------------------------------
+
+void Streamer::stop()
+      {
+      if (!isRunning())
+            return;
+      quitFlag = true;
+      wait();
+      }
+
+//---------------------------------------------------------
+//   acquire
+//    get a free stream for sample s starting at frame
+//    start, 0 if all streams are in use
+//---------------------------------------------------------
+
+Stream* Streamer::acquire(Sample* s, int start)
+      {
+      for (int i = 0; i < MAX_STREAMS; ++i) {
+            if (streams[i].acquire(s, start))
+                  return &streams[i];
+            }
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   closeFiles
+//    close the least recently used files, keep keep files
+//---------------------------------------------------------
+
+void Streamer::closeFiles(int keep)
+      {
+      while (files.size() > keep)
+            sf_close(files.takeLast().sf);
+      }
+
+//---------------------------------------------------------
+//   file
+//    the open sound file of sample s; files are keyed by
+//    path as samples of unloaded instruments are freed
+//---------------------------------------------------------
+
+SNDFILE* Streamer::file(Sample* s)
+      {
+      for (int i = 0; i < files.size(); ++i) {
+            if (files[i].path == s->path()) {
+                  files.move(i, 0);
+                  return files[0].sf;
+                  }
+            }
+      closeFiles(MAX_OPEN_FILES - 1);
+      SF_INFO info;
+      memset(&info, 0, sizeof(info));
+      QByteArray path = s->path().toLocal8Bit();
+      SNDFILE* sf = sf_open(path.data(), SFM_READ, &info);
+      if (sf == 0 && !files.isEmpty()) {
+            // maybe out of file descriptors
+            closeFiles(0);
+            sf = sf_open(path.data(), SFM_READ, &info);
+            }
+      if (sf == 0) {
+            printf("Streamer: open <%s> failed\n", path.data());
+            return 0;
+            }
+      OpenFile of;
+      of.path = s->path();
+      of.sf   = sf;
+      files.prepend(of);
+      return sf;
+      }
+
+//---------------------------------------------------------
+//   fill
+//    read the frames between filled and the end of the
+//    free part of the ring; returns true if anything was
+//    read. If the file cannot be opened the stream fails
+//    and the voice ends with the resident part.
+//---------------------------------------------------------
+
+bool Streamer::fill(Stream* st)
+      {
+      Sample* s  = st->_sample;
+      int filled = st->filled();
+      int end    = qMin(st->_readPos.fetchAndAddAcquire(0) + Stream::RING_FRAMES - 4,
+                        s->frames() + 3);
+      if (filled >= end)
+            return false;
+      SNDFILE* sf = file(s);
+      if (sf == 0) {
+            st->_state.testAndSetRelease(Stream::ACTIVE, Stream::FAILED);
+            return false;
+            }
+      sf_seek(sf, filled, SEEK_SET);
+      while (filled < end) {
+            int n = qMin(end - filled, Stream::RING_FRAMES - ((filled - st->_start) & Stream::RING_MASK));
+            float* dst = st->_ring + ((filled - st->_start) & Stream::RING_MASK) * 2;
+            int r = filled < s->frames() ? sf_readf_float(sf, dst, n) : 0;
+            if (r < n)        // past the end: silence for the interpolation
+                  memset(dst + r * 2, 0, (n - r) * 2 * sizeof(float));
+            filled += n;
+            st->_filled.fetchAndStoreRelease(filled);
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void Streamer::run()
+      {
+      while (!quitFlag) {
+            bool busy = false;
+            for (int i = 0; i < MAX_STREAMS; ++i) {
+                  Stream* st = &streams[i];
+                  int state  = st->_state.fetchAndAddAcquire(0);
+                  if (state == Stream::ACTIVE)
+                        busy |= fill(st);
+                  else if (state == Stream::RELEASED) {
+                        st->_sample = 0;
+                        st->_state.fetchAndStoreRelease(Stream::FREE);
+                        }
+                  }
+            if (!busy)
+                  msleep(2);
+            }
+      }
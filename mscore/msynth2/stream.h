@@ -0,0 +1,95 @@
+//=============================================================================
+//  MuseSynth
+//  Music Software Synthesizer
+//  $Id:$
+//
+//  Copyright (C) 2011 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENSE.GPL
+//=============================================================================
+
+#ifndef __MSTREAM_H__
+#define __MSTREAM_H__
+
+#include <QtCore/QThread>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+class Sample;
+struct SNDFILE_tag;
+
+//---------------------------------------------------------
+//   Stream
+//    Ring buffer for the part of a sample which is not
+//    resident. The voice reads, the Streamer writes.
+//    Frame f of the sample is at ring frame
+//    (f - start) & RING_MASK.
+//---------------------------------------------------------
+
+class Stream {
+   public:
+      enum { FREE, STARTING, ACTIVE, FAILED, RELEASED };
+      static const int RING_FRAMES = 32768;
+      static const int RING_MASK   = RING_FRAMES - 1;
+
+   private:
+      QAtomicInt _state;
+      Sample* _sample;
+      int _start;             // first frame in the ring
+      QAtomicInt _filled;     // frames before this one are in the ring
+      QAtomicInt _readPos;    // the voice does not need frames before this one
+      float* _ring;
+
+   public:
+      Stream();
+      ~Stream();
+      bool acquire(Sample*, int start);
+      void release()                { _state.fetchAndStoreRelease(RELEASED); }
+      int filled()                  { return _filled.fetchAndAddAcquire(0); }
+      bool failed()                 { return _state.fetchAndAddAcquire(0) == FAILED; }
+      void setReadPos(int f)        { _readPos.fetchAndStoreRelease(f); }
+      const float* frame(int f) const;
+      friend class Streamer;
+      };
+
+//---------------------------------------------------------
+//   Streamer
+//    prefetch thread: keeps the ring buffers of all
+//    active streams filled from disk. Sample files are
+//    opened on demand; at most MAX_OPEN_FILES stay open,
+//    the least recently used one is closed first.
+//---------------------------------------------------------
+
+class Streamer : public QThread {
+      static const int MAX_STREAMS    = 128;
+      static const int MAX_OPEN_FILES = 32;
+
+      struct OpenFile {
+            QString path;
+            SNDFILE_tag* sf;
+            };
+
+      Stream streams[MAX_STREAMS];
+      QList<OpenFile> files;        // most recently used first, streamer thread only
+      volatile bool quitFlag;
+      QAtomicInt _underruns;
+
+      virtual void run();
+      bool fill(Stream*);
+      SNDFILE_tag* file(Sample*);
+      void closeFiles(int keep);
+
+   public:
+      Streamer();
+      ~Streamer();
+      void stop();
+      Stream* acquire(Sample*, int start);
+      void underrun()               { _underruns.fetchAndAddRelaxed(1); }
+      int underruns()               { return _underruns.fetchAndAddAcquire(0); }
+      };
+
+#endif
@@ -17,8 +17,10 @@
 #include "instrument.h"
 #include "channel.h"
 #include "msynth.h"
+#include "stream.h"
 
 float Voice::interpCoeff[INTERP_MAX][4];
+static const float silence[2] = { 0.0, 0.0 };
 
 //---------------------------------------------------------
 //   set
@@ -64,6 +66,20 @@ void Voice::init()
 
 Voice::Voice()
       {
+      stream = 0;
+      }
+
+//---------------------------------------------------------
+//   releaseStream
+//    called when the voice is freed
+//---------------------------------------------------------
+
+void Voice::releaseStream()
+      {
+      if (stream) {
+            stream->release();
+            stream = 0;
+            }
       }
 
 //---------------------------------------------------------
@@ -100,7 +116,13 @@ void Voice::start(Channel* c, int key, int v, float t)
       zone          =  i->zone(_key, _velocity);
       sample        = zone->sample();
       data          = sample->data();
-      eidx          = sample->frames();
+      eidx          = sample->resident();
+      if (sample->streamed()) {
+            // without a free stream only the resident part plays
+            stream = _channel->msynth()->streamer()->acquire(sample, sample->resident());
+            if (stream)
+                  eidx = sample->frames();
+            }
       stopEnv.val   = 1.0;
       double pi     = MSynth::ct2hz(key * 100.0)/MSynth::ct2hz(zone->keyBase() * 100.0);
       phaseIncr.set(pi);
@@ -114,6 +136,10 @@ void Voice::start(Channel* c, int key, int v, float t)
 
 void Voice::process(int frames, float* lb, float* rb, int stride)
       {
+      int resident = sample->resident();
+      int filled   = stream ? stream->filled() : 0;
+      Stream* st   = stream;      // stopVoice() releases the stream
+
       while (frames) {
             int idx = phase.index();
             if (idx >= eidx) {
@@ -122,16 +148,38 @@ void Voice::process(int frames, float* lb, float* rb, int stride)
                   break;
                   }
             float* coeffs = interpCoeff[phase.fract()];
+            const float* f[4];
+            if (!stream || idx + 2 < resident) {
+                  for (int k = 0; k < 4; ++k)
+                        f[k] = data + (idx - 1 + k) * 2;
+                  }
+            else if (idx + 2 < filled) {
+                  for (int k = 0; k < 4; ++k) {
+                        int i = idx - 1 + k;
+                        f[k]  = i < resident ? data + i * 2 : stream->frame(i);
+                        }
+                  }
+            else if (stream->failed()) {
+                  // the file cannot be read: end with the resident part
+                  eidx = idx;
+                  continue;
+                  }
+            else {
+                  // the streamer fell behind: play silence
+                  _channel->msynth()->streamer()->underrun();
+                  for (int k = 0; k < 4; ++k)
+                        f[k] = silence;
+                  }
 
-            *lb   += ( coeffs[0] * data[(idx-1)*2]
-                     + coeffs[1] * data[(idx+0)*2]
-                     + coeffs[2] * data[(idx+1)*2]
-                     + coeffs[3] * data[(idx+2)*2])
+            *lb   += ( coeffs[0] * f[0][0]
+                     + coeffs[1] * f[1][0]
+                     + coeffs[2] * f[2][0]
+                     + coeffs[3] * f[3][0])
                      * stopEnv.val * amp;
-            *rb   += ( coeffs[0] * data[(idx-1)*2+1]
-                     + coeffs[1] * data[(idx+0)*2+1]
-                     + coeffs[2] * data[(idx+1)*2+1]
-                     + coeffs[3] * data[(idx+2)*2+1])
+            *rb   += ( coeffs[0] * f[0][1]
+                     + coeffs[1] * f[1][1]
+                     + coeffs[2] * f[2][1]
+                     + coeffs[3] * f[3][1])
                      * stopEnv.val * amp;
 
             phase += phaseIncr;
@@ -148,5 +196,7 @@ void Voice::process(int frames, float* lb, float* rb, int stride)
                         }
                   }
             }
+      if (st && st == stream)
+            st->setReadPos(phase.index() - 1);
       }
 
@@ -20,6 +20,7 @@
 class Channel;
 class Zone;
 class Sample;
+class Stream;
 
 static const int INTERP_MAX = 256;
 
@@ -87,6 +88,7 @@ class Voice {
 
       float* data;
       int eidx;
+      Stream* stream;         // rest of a streamed sample, or 0
       Envelope stopEnv;
 
       static float interpCoeff[INTERP_MAX][4];
@@ -97,6 +99,7 @@ class Voice {
 
       void process(int frames, float* l, float* r, int stride);
       void stop();
+      void releaseStream();
       void sustained();
       bool statePlaying() const   { return _state == VOICE_PLAYING;   }
       bool stateSustained() const { return _state == VOICE_SUSTAINED; }
@@ -35,6 +35,13 @@ void Omr::write(Xml&) const {}
 extern bool testNote();
 extern bool testMidi();
 extern bool testHairpin();
+extern bool testFluid();
+extern bool testMidiIn();
+extern bool testAlsa();
+extern bool testRtAudit();
+extern bool testSeqChase();
+extern bool testSynth();
+extern bool testLoad();
 
 Preferences preferences;
 
@@ -69,6 +76,34 @@ int main(int argc, char* argv[])
             printf("test midi failed\n");
             ++bugs;
             }
+      if (!testFluid()) {
+            printf("test fluid failed\n");
+            ++bugs;
+            }
+      if (!testMidiIn()) {
+            printf("test midi input failed\n");
+            ++bugs;
+            }
+      if (!testAlsa()) {
+            printf("test alsa pcm failed\n");
+            ++bugs;
+            }
+      if (!testRtAudit()) {
+            printf("test realtime audit failed\n");
+            ++bugs;
+            }
+      if (!testSeqChase()) {
+            printf("test seek chase failed\n");
+            ++bugs;
+            }
+      if (!testSynth()) {
+            printf("test synthesizer failed\n");
+            ++bugs;
+            }
+      if (!testLoad()) {
+            printf("test load failed\n");
+            ++bugs;
+            }
       if (bugs)
             printf("==%d tests failed==\n", bugs);
       else
@@ -0,0 +1,278 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "mscore/pcmconvert.h"
+#include "mtest.h"
+
+#ifdef USE_ALSA
+#include "mscore/alsadriver.h"
+#endif
+
+static const int FRAMES     = 1027;         // not a multiple of the simd width
+static const int SAMPLERATE = 48000;
+static const int PERIOD     = 1024;
+
+static const char* formatName[] = { "s16", "s24_3", "s32" };
+
+//---------------------------------------------------------
+//   sweep
+//    a sweep which also exceeds +-1.0
+//---------------------------------------------------------
+
+static void sweep(float* l, float* r, int n, int offset)
+      {
+      for (int i = 0; i < n; ++i) {
+            double t = double(offset + i) / SAMPLERATE;
+            l[i] = sin(2.0 * M_PI * (100.0 + 2000.0 * t) * t) * 1.2;
+            r[i] = cos(2.0 * M_PI * 330.0 * t) * 0.3;
+            }
+      }
+
+//---------------------------------------------------------
+//   compareConvert
+//    the simd kernels against the scalar ones
+//---------------------------------------------------------
+
+static bool compareConvert(PcmConverter::Format format, PcmConverter::Dither dither)
+      {
+      float l[FRAMES], r[FRAMES];
+      sweep(l, r, FRAMES, 0);
+      int size = PcmConverter(format).sampleSize();
+      QByteArray out[2][3];
+      for (int simd = 0; simd < 2; ++simd) {
+            PcmConverter::setSimd(simd);
+            PcmConverter c(format, dither);
+            out[simd][0].fill(0, FRAMES * 2 * size);
+            out[simd][1].fill(0, FRAMES * size);
+            out[simd][2].fill(0, FRAMES * 2 * size);
+            c.interleave(l, r, out[simd][0].data(), FRAMES);
+            c.convert(0, l, out[simd][1].data(), size, FRAMES);
+            c.convert(1, r, out[simd][2].data() + size, size * 2, FRAMES);
+            }
+      PcmConverter::setSimd(true);
+      if (out[0][0] != out[1][0] || out[0][1] != out[1][1] || out[0][2] != out[1][2]) {
+            printf("   %s dither %d: simd and scalar output differ\n", formatName[format], dither);
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   convertOne
+//---------------------------------------------------------
+
+static int convertOne(PcmConverter* c, float v)
+      {
+      char buffer[4] = { 0, 0, 0, 0 };
+      c->convert(0, &v, buffer, c->sampleSize(), 1);
+      switch (c->format()) {
+            case PcmConverter::S16_LE:
+                  return *(short*)buffer;
+            case PcmConverter::S24_3LE:
+                  return (*(int*)buffer << 8) >> 8;
+            case PcmConverter::S32_LE:
+                  return *(int*)buffer;
+            }
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   benchConvert
+//---------------------------------------------------------
+
+static void benchConvert(PcmConverter::Format format, PcmConverter::Dither dither)
+      {
+      static const int BLOCKS = 2000;
+      float l[PERIOD], r[PERIOD];
+      sweep(l, r, PERIOD, 0);
+      char buffer[PERIOD * 2 * 4];
+      qint64 ns[2];
+      for (int simd = 0; simd < 2; ++simd) {
+            PcmConverter::setSimd(simd);
+            PcmConverter c(format, dither);
+            QElapsedTimer t;
+            t.start();
+            for (int i = 0; i < BLOCKS; ++i)
+                  c.interleave(l, r, buffer, PERIOD);
+            ns[simd] = t.nsecsElapsed();
+            }
+      PcmConverter::setSimd(true);
+      printf("  -%-5s dither %d: scalar %.2f ns, simd %.2f ns per frame\n", formatName[format],
+         dither, double(ns[0]) / (BLOCKS * PERIOD), double(ns[1]) / (BLOCKS * PERIOD));
+      }
+
+#ifdef USE_ALSA
+
+//---------------------------------------------------------
+//   benchPcm
+//    write ms milliseconds of audio to the alsa null
+//    device which consumes the data without a clock
+//---------------------------------------------------------
+
+static bool benchPcm(bool mmap, int ms)
+      {
+      bool passed = true;
+      AlsaDriver alsa("null", SAMPLERATE, PERIOD, 3);
+      alsa.setMmap(mmap);
+      TEST(alsa.init());
+      if (!passed)
+            return false;
+      float l[PERIOD], r[PERIOD];
+      sweep(l, r, PERIOD, 0);
+      int blocks = ms * SAMPLERATE / (1000 * PERIOD);
+      alsa.pcmStart();
+      QElapsedTimer t;
+      t.start();
+      for (int i = 0; i < blocks; ++i)
+            alsa.write(PERIOD, l, r);
+      qint64 ns = t.nsecsElapsed();
+      alsa.pcmStop();
+      printf("  -null %s %s: %.1f x realtime, %.2f ns per frame\n",
+         snd_pcm_format_name(alsa.format()), alsa.mmapped() ? "mmap" : "rw",
+         double(blocks) * PERIOD / SAMPLERATE * 1e9 / qMax(ns, qint64(1)),
+         double(ns) / (blocks * PERIOD));
+      TEST(alsa.mmapped() == mmap);
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   comparePcmFile
+//    write through the file plugin and compare the file
+//    with the converter output
+//---------------------------------------------------------
+
+static bool comparePcmFile(bool mmap)
+      {
+      static const int BLOCKS = 64;
+      bool passed = true;
+      QString path = QDir::tempPath() + "/mtest-alsa.raw";
+      QFile::remove(path);
+
+      AlsaDriver* alsa = new AlsaDriver(QString("file:FILE=%1,FORMAT=raw").arg(path),
+         SAMPLERATE, PERIOD, 3);
+      alsa->setMmap(mmap);
+      TEST(alsa->init());
+      if (!passed) {
+            delete alsa;
+            return false;
+            }
+      PcmConverter::Format format;
+      switch (alsa->format()) {
+            case SND_PCM_FORMAT_S24_3LE: format = PcmConverter::S24_3LE; break;
+            case SND_PCM_FORMAT_S32_LE:  format = PcmConverter::S32_LE;  break;
+            default:                     format = PcmConverter::S16_LE;  break;
+            }
+      bool mmapped = alsa->mmapped();
+      PcmConverter ref(format);
+      int frame = ref.sampleSize() * 2;
+      QByteArray expected(BLOCKS * PERIOD * frame, 0);
+      float l[PERIOD], r[PERIOD];
+
+      alsa->pcmStart();
+      for (int i = 0; i < BLOCKS; ++i) {
+            sweep(l, r, PERIOD, i * PERIOD);
+            alsa->write(PERIOD, l, r);
+            ref.interleave(l, r, expected.data() + i * PERIOD * frame, PERIOD);
+            }
+      alsa->pcmStop();
+      delete alsa;
+
+      QFile f(path);
+      TEST(f.open(QIODevice::ReadOnly));
+      QByteArray data = f.readAll();
+      f.close();
+      QFile::remove(path);
+
+      // the mmap interface starts with a buffer of silence;
+      // the last buffer may not have been flushed to the file
+      int skip = mmapped ? 3 * PERIOD * frame : 0;
+      int n    = qMin(data.size() - skip, expected.size());
+      TEST(n >= (BLOCKS / 2) * PERIOD * frame);
+      if (n > 0 && memcmp(data.constData() + skip, expected.constData(), n) != 0) {
+            printf("   file %s: pcm data differs\n", mmapped ? "mmap" : "rw");
+            passed = false;
+            }
+      return passed;
+      }
+
+#endif
+
+//---------------------------------------------------------
+//   testAlsa
+//    float to pcm conversion and the alsa driver against
+//    the null and file plugins, no sound card needed
+//---------------------------------------------------------
+
+bool testAlsa()
+      {
+      printf("====test alsa pcm\n");
+      bool passed = true;
+
+      static const PcmConverter::Format formats[] = {
+            PcmConverter::S16_LE, PcmConverter::S24_3LE, PcmConverter::S32_LE
+            };
+      static const PcmConverter::Dither dithers[] = {
+            PcmConverter::DITHER_NONE, PcmConverter::DITHER_RECTANGULAR, PcmConverter::DITHER_TRIANGULAR
+            };
+
+      printf("  -conversion kernels\n");
+      for (int f = 0; f < 3; ++f) {
+            for (int d = 0; d < 3; ++d)
+                  TEST(compareConvert(formats[f], dithers[d]));
+            }
+
+      PcmConverter c16(PcmConverter::S16_LE);
+      TEST(convertOne(&c16, 1.0f) == 32767);
+      TEST(convertOne(&c16, 2.0f) == 32767);
+      TEST(convertOne(&c16, -1.5f) == -32767);
+      TEST(convertOne(&c16, 0.5f) == 16384);
+      PcmConverter c24(PcmConverter::S24_3LE);
+      TEST(convertOne(&c24, 1.0f) == 8388607);
+      TEST(convertOne(&c24, -1.0f) == -8388607);
+      PcmConverter c32(PcmConverter::S32_LE);
+      TEST(convertOne(&c32, -1.0f) == -8388607 * 256);
+
+      // dither of silence stays within one lsb
+      PcmConverter tpdf(PcmConverter::S16_LE, PcmConverter::DITHER_TRIANGULAR);
+      int nonzero = 0;
+      for (int i = 0; i < 1000; ++i) {
+            int v = convertOne(&tpdf, 0.0f);
+            TEST(v >= -1 && v <= 1);
+            if (v)
+                  ++nonzero;
+            }
+      TEST(nonzero > 0);
+
+      for (int f = 0; f < 3; ++f) {
+            benchConvert(formats[f], PcmConverter::DITHER_NONE);
+            benchConvert(formats[f], PcmConverter::DITHER_TRIANGULAR);
+            }
+
+#ifdef USE_ALSA
+      snd_pcm_t* pcm;
+      if (snd_pcm_open(&pcm, "null", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
+            printf("  -no alsa null device, skipped\n");
+            return passed;
+            }
+      snd_pcm_close(pcm);
+      printf("  -alsa driver\n");
+      TEST(comparePcmFile(true));
+      TEST(comparePcmFile(false));
+      // half a second of audio each, the unit suite is no benchmark
+      TEST(benchPcm(true, 500));
+      TEST(benchPcm(false, 500));
+#endif
+      return passed;
+      }
+
@@ -0,0 +1,685 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "fluid/fluid.h"
+#include "fluid/voice.h"
+#include "fluid/rev.h"
+#include "fluid/chorus.h"
+#include "fluid/voiceheap.h"
+#include "mtest.h"
+
+using namespace FluidS;
+
+static const unsigned DATA_SIZE = 20000;
+static const unsigned BUF_SIZE  = 301;      // not a multiple of the simd width
+
+//---------------------------------------------------------
+//   compareKernel
+//    run a kernel against the scalar reference and
+//    check that output, phase and amplitude match
+//---------------------------------------------------------
+
+static bool compareKernel(const char* name, Voice::InterpKernel ref, Voice::InterpKernel kernel,
+   const short* data, double incr)
+      {
+      float b1[BUF_SIZE], b2[BUF_SIZE];
+      Phase p1, p2, pi;
+      p1.setFloat(10.3);
+      p2 = p1;
+      pi.setFloat(incr);
+      float a1 = 0.3f;
+      float a2 = 0.3f;
+
+      ref(b1, BUF_SIZE, data, &p1, pi.data, &a1, 1e-4f);
+      kernel(b2, BUF_SIZE, data, &p2, pi.data, &a2, 1e-4f);
+
+      for (unsigned i = 0; i < BUF_SIZE; ++i) {
+            if (fabs(b1[i] - b2[i]) > 1e-6 * fabs(b1[i])) {
+                  printf("   %s incr %f: sample %d: %f != %f\n", name, incr, i, b1[i], b2[i]);
+                  return false;
+                  }
+            }
+      if (p1.data != p2.data || fabs(a1 - a2) > 1e-6) {
+            printf("   %s incr %f: phase/amp mismatch\n", name, incr);
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   compareMix
+//    run a mix kernel against the scalar reference
+//---------------------------------------------------------
+
+static bool compareMix(const char* name, Voice::MixKernel kernel)
+      {
+      float buf[BUF_SIZE];
+      float out1[4][BUF_SIZE], out2[4][BUF_SIZE];
+      static const float gain[4] = { 0.7f, 0.3f, 0.2f, 0.05f };
+
+      for (unsigned i = 0; i < BUF_SIZE; ++i) {
+            buf[i] = float(rand() % 2000 - 1000) / 1000.0f;
+            for (int k = 0; k < 4; ++k)
+                  out1[k][i] = out2[k][i] = float(i) * 0.001f;
+            }
+      Voice::mix_scalar(buf, BUF_SIZE, out1[0], out1[1], out1[2], out1[3], gain);
+      kernel(buf, BUF_SIZE, out2[0], out2[1], out2[2], out2[3], gain);
+
+      for (int k = 0; k < 4; ++k) {
+            for (unsigned i = 0; i < BUF_SIZE; ++i) {
+                  if (out1[k][i] != out2[k][i]) {
+                        printf("   %s: buffer %d sample %d: %f != %f\n", name, k, i, out1[k][i], out2[k][i]);
+                        return false;
+                        }
+                  }
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   benchEffects
+//    measure filter and mix (Voice::effects()) in
+//    ns per voice per block
+//---------------------------------------------------------
+
+static void benchEffects()
+      {
+      static const int VOICES = 64;
+      static const int BLOCKS = 4000;
+      static const int BLOCK  = 64;
+
+      float buf[BLOCK];
+      float out[4][BLOCK];
+      memset(out, 0, sizeof(out));
+
+      Voice* voice[VOICES];
+      for (int i = 0; i < VOICES; ++i) {
+            Voice* v = new Voice(0);
+            v->a1       = -1.8f;
+            v->a2       = 0.81f;
+            v->b02      = 0.0025f;
+            v->b1       = 0.005f;
+            v->hist1    = 0.0f;
+            v->hist2    = 0.0f;
+            v->filter_coeff_incr_count = 0;
+            v->pan      = float(i * 10 - 300);
+            v->amp_left = 0.5f;
+            v->amp_right  = 0.4f;
+            v->amp_reverb = 0.2f;
+            v->amp_chorus = 0.1f;
+            v->dsp_buf  = buf;
+            voice[i]    = v;
+            }
+
+      QElapsedTimer t;
+      t.start();
+      for (int b = 0; b < BLOCKS; ++b) {
+            for (int i = 0; i < VOICES; ++i) {
+                  for (int k = 0; k < BLOCK; ++k)
+                        buf[k] = (k & 8) ? 0.5f : -0.5f;
+                  voice[i]->effects(BLOCK, out[0], out[1], out[2], out[3]);
+                  }
+            }
+      qint64 ms = t.elapsed();
+      printf("  -effects: %.1f ns per voice per block (%d samples)\n",
+         double(ms) * 1e6 / (double(VOICES) * BLOCKS), BLOCK);
+
+      for (int i = 0; i < VOICES; ++i)
+            delete voice[i];
+      }
+
+//---------------------------------------------------------
+//   RefReverb
+//    the per sample Freeverb as used before the comb bank
+//    was processed block wise; default preset only
+//---------------------------------------------------------
+
+struct RefReverb {
+      struct Delay {
+            float buf[2000];
+            int size, idx;
+            float store;
+            void init(int n) { size = n; idx = 0; store = 0.0f; for (int i = 0; i < n; ++i) buf[i] = 1e-8; }
+            float comb(float input, float fb, float d1, float d2) {
+                  float tmp = buf[idx];
+                  store     = (tmp * d2) + (store * d1);
+                  buf[idx]  = input + (store * fb);
+                  if (++idx >= size)
+                        idx = 0;
+                  return tmp;
+                  }
+            float allpass(float input) {
+                  float bufout = buf[idx];
+                  float output = bufout - input;
+                  buf[idx] = input + (bufout * 0.5f);
+                  if (++idx >= size)
+                        idx = 0;
+                  return output;
+                  }
+            };
+      Delay combL[8], combR[8], allpassL[4], allpassR[4];
+      float roomsize, damp1, damp2, wet1, wet2, gain;
+
+      RefReverb() {
+            static const int ct[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+            static const int at[] = { 556, 441, 341, 225 };
+            for (int i = 0; i < 8; ++i) {
+                  combL[i].init(ct[i]);
+                  combR[i].init(ct[i] + 23);
+                  }
+            for (int i = 0; i < 4; ++i) {
+                  allpassL[i].init(at[i]);
+                  allpassR[i].init(at[i] + 23);
+                  }
+            roomsize   = (0.5f * scaleroom) + offsetroom;
+            damp1      = 0.5f * scaledamp;
+            damp2      = 1 - damp1;
+            float wet  = 0.2f * scalewet;
+            wet1       = wet * (1.0f * .5 + 0.5f);
+            wet2       = wet * ((1.0 - 1.0f) * .5);
+            gain       = 0.30f;
+            }
+      void process(int n, const float* in, float* l, float* r) {
+            for (int k = 0; k < n; k++) {
+                  float outL = 0.0;
+                  float outR = 0.0;
+                  float input = (in[k] * 2.0 + 1e-8) * gain;
+                  for (int i = 0; i < 8; i++) {
+                        outL += combL[i].comb(input, roomsize, damp1, damp2);
+                        outR += combR[i].comb(input, roomsize, damp1, damp2);
+                        }
+                  for (int i = 0; i < 4; i++) {
+                        outL = allpassL[i].allpass(outL);
+                        outR = allpassR[i].allpass(outR);
+                        }
+                  outL -= 1e-8;
+                  outR -= 1e-8;
+                  l[k] += outL * wet1 + outR * wet2;
+                  r[k] += outR * wet1 + outL * wet2;
+                  }
+            }
+      };
+
+//---------------------------------------------------------
+//   compareReverb
+//    run the reverb against the reference for a couple of
+//    seconds with changing block sizes
+//---------------------------------------------------------
+
+static bool compareReverb(const char* name, CombKernel kernel)
+      {
+      CombKernel saved = Reverb::combs;
+      Reverb::combs    = kernel;
+      Reverb* rev      = new Reverb;
+      RefReverb* ref   = new RefReverb;
+      bool ok          = true;
+
+      static const int blocks[] = { 64, 1, 333, 7, 1024, 128, 4096 };
+      float in[4096], l1[4096], r1[4096], l2[4096], r2[4096];
+
+      for (int b = 0; b < 40 && ok; ++b) {
+            int n = blocks[b % (sizeof(blocks)/sizeof(*blocks))];
+            for (int i = 0; i < n; ++i) {
+                  in[i] = (b < 20) ? float(rand() % 2000 - 1000) / 1000.0f : 0.0f;
+                  l1[i] = l2[i] = r1[i] = r2[i] = 0.0f;
+                  }
+            ref->process(n, in, l1, r1);
+            rev->process(n, in, l2, r2);
+            for (int i = 0; i < n; ++i) {
+                  if (fabs(l1[i] - l2[i]) > 1e-6 || fabs(r1[i] - r2[i]) > 1e-6) {
+                        printf("   %s: block %d sample %d: %f %f != %f %f\n",
+                           name, b, i, l1[i], r1[i], l2[i], r2[i]);
+                        ok = false;
+                        break;
+                        }
+                  }
+            }
+      delete rev;
+      delete ref;
+      Reverb::combs = saved;
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   RefChorus
+//    the per sample chorus with integer lfo tables as used
+//    before the chorus was processed block wise; default
+//    speed, depth and level
+//---------------------------------------------------------
+
+struct RefChorus {
+      static const int SAMPLES = 2048;    // delay line, power of two
+
+      float sinc[INTERPOLATION_SAMPLES][INTERPOLATION_SUBSAMPLES];
+      float buf[SAMPLES];
+      int* lfo;
+      long phase[MAX_CHORUS];
+      long period;
+      int counter;
+      int blocks;
+      float level;
+
+      RefChorus(float sr, int type, int nblocks) {
+            for (int i = 0; i < INTERPOLATION_SAMPLES; i++) {
+                  for (int ii = 0; ii < INTERPOLATION_SUBSAMPLES; ii++) {
+                        double x = (double) i - (double) INTERPOLATION_SAMPLES / 2.
+                           + (double) ii / (double) INTERPOLATION_SUBSAMPLES;
+                        if (fabs(x) < 0.000001)
+                              sinc[i][ii] = 1.0f;
+                        else {
+                              sinc[i][ii] = (float)sin(x * M_PI) / (M_PI * x);
+                              sinc[i][ii] *= (float)0.5 * (1.0 + cos(2.0 * M_PI * x / (float)INTERPOLATION_SAMPLES));
+                              }
+                        }
+                  }
+            memset(buf, 0, sizeof(buf));
+            period    = lrint(sr / FLUID_CHORUS_DEFAULT_SPEED);
+            int depth = (int)(FLUID_CHORUS_DEFAULT_DEPTH / 1000.0 * sr);
+            lfo       = new int[period];
+            if (type == FLUID_CHORUS_MOD_SINE) {
+                  for (int i = 0; i < period; i++) {
+                        double val = sin((double) i / (double) period * 2.0 * M_PI);
+                        lfo[i] = (int) ((1.0 + val) * (double) depth / 2.0 * (double) INTERPOLATION_SUBSAMPLES);
+                        lfo[i] -= 3 * SAMPLES * INTERPOLATION_SUBSAMPLES;
+                        }
+                  }
+            else {
+                  for (int i = 0, ii = period - 1; i <= ii; ++i, --ii) {
+                        double val = i * 2.0 / period * (double) depth * (double) INTERPOLATION_SUBSAMPLES;
+                        lfo[i] = lfo[ii] = (int) (val + 0.5) - 3 * SAMPLES * INTERPOLATION_SUBSAMPLES;
+                        }
+                  }
+            blocks = nblocks;
+            for (int i = 0; i < blocks; i++)
+                  phase[i] = (int) ((double) period * (double) i / (double) blocks);
+            counter = 0;
+            level   = FLUID_CHORUS_DEFAULT_LEVEL;
+            }
+      ~RefChorus() { delete[] lfo; }
+      void process(int n, const float* in, float* l, float* r) {
+            for (int k = 0; k < n; k++) {
+                  float out = 0.0f;
+                  buf[counter] = in[k];
+                  for (int i = 0; i < blocks; i++) {
+                        int pos = INTERPOLATION_SUBSAMPLES * counter - lfo[phase[i]];
+                        int idx = pos / INTERPOLATION_SUBSAMPLES;
+                        pos &= INTERPOLATION_SUBSAMPLES_ANDMASK;
+                        for (int ii = 0; ii < INTERPOLATION_SAMPLES; ii++)
+                              out += buf[idx-- & (SAMPLES - 1)] * sinc[ii][pos];
+                        phase[i] = (phase[i] + 1) % period;
+                        }
+                  out *= level;
+                  l[k] += out;
+                  r[k] += out;
+                  counter = (counter + 1) % SAMPLES;
+                  }
+            }
+      };
+
+//---------------------------------------------------------
+//   compareChorus
+//    run a chorus kernel against the reference for both
+//    modulation types with changing block sizes. The lfo
+//    of the reference is quantized by its tables, the
+//    output must match within 1% of its peak.
+//---------------------------------------------------------
+
+static bool compareChorus(const char* name, ChorusKernel kernel)
+      {
+      static const int BLOCKS = 5;        // not a multiple of the simd width
+      ChorusKernel saved = Chorus::kernel;
+      Chorus::kernel     = kernel;
+      bool ok            = true;
+
+      static const int blocks[] = { 64, 1, 333, 7, 1024, 128 };
+      float in[1024], l1[1024], r1[1024], l2[1024], r2[1024];
+
+      for (int type = FLUID_CHORUS_MOD_SINE; type <= FLUID_CHORUS_MOD_TRIANGLE && ok; ++type) {
+            RefChorus* ref = new RefChorus(44100.0f, type, BLOCKS);
+            Chorus* c      = new Chorus(44100.0f);
+            c->setParameter(CHORUS_TYPE, type);
+            c->setParameter(CHORUS_BLOCKS, BLOCKS / 100.0);
+            double peak  = 0.0;
+            double error = 0.0;
+            for (int b = 0; b < 200 && ok; ++b) {
+                  int n = blocks[b % (sizeof(blocks)/sizeof(*blocks))];
+                  for (int i = 0; i < n; ++i) {
+                        in[i] = float(rand() % 2000 - 1000) / 1000.0f;
+                        l1[i] = l2[i] = r1[i] = r2[i] = 0.0f;
+                        }
+                  ref->process(n, in, l1, r1);
+                  c->process(n, in, l2, r2);
+                  for (int i = 0; i < n; ++i) {
+                        if (r2[i] != l2[i]) {
+                              printf("   %s type %d: block %d sample %d: left %f != right %f\n",
+                                 name, type, b, i, l2[i], r2[i]);
+                              ok = false;
+                              break;
+                              }
+                        peak  = qMax(peak, fabs(double(l1[i])));
+                        error = qMax(error, fabs(double(l1[i]) - l2[i]));
+                        }
+                  }
+            printf("  -%s %s: max error %.2f%% of peak\n", name,
+               type == FLUID_CHORUS_MOD_SINE ? "sine" : "triangle", error * 100.0 / peak);
+            if (error > 0.01 * peak)
+                  ok = false;
+            delete ref;
+            delete c;
+            }
+      Chorus::kernel = saved;
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   benchSendEffects
+//    cpu time of reverb and chorus with the selected
+//    kernels in percent of one core at 44.1 kHz; printed
+//    only, the time depends on the machine
+//---------------------------------------------------------
+
+static void benchSendEffects()
+      {
+      static const int SECONDS = 10;
+      static const int BLOCK   = 64;
+      static const int BLOCKS  = SECONDS * 44100 / BLOCK;
+
+      Reverb::config();
+      Chorus::config();
+      Reverb* rev = new Reverb;
+      Chorus* cho = new Chorus(44100.0f);
+      float rin[16][BLOCK], cin[16][BLOCK], l[BLOCK], r[BLOCK];
+      for (int k = 0; k < 16; ++k) {
+            for (int i = 0; i < BLOCK; ++i) {
+                  rin[k][i] = float(rand() % 2000 - 1000) / 4000.0f;
+                  cin[k][i] = rin[k][i] * 0.5f;
+                  }
+            }
+
+      QElapsedTimer t;
+      t.start();
+      for (int b = 0; b < BLOCKS; ++b) {
+            memset(l, 0, sizeof(l));
+            memset(r, 0, sizeof(r));
+            rev->process(BLOCK, rin[b & 15], l, r);
+            cho->process(BLOCK, cin[b & 15], l, r);
+            }
+      double load = double(t.nsecsElapsed()) * 1e-9 * 100.0 / SECONDS;
+      printf("  -send effects: %.2f%% of one core (budget %.0f%%)\n", load, 5.0);
+
+      delete rev;
+      delete cho;
+      }
+
+//---------------------------------------------------------
+//   randomVoiceState
+//---------------------------------------------------------
+
+static void randomVoiceState(Voice* v, unsigned id)
+      {
+      static const unsigned char status[] = {
+            FLUID_VOICE_ON, FLUID_VOICE_ON, FLUID_VOICE_SUSTAINED
+            };
+      v->id             = id;
+      v->status         = status[rand() % 3];
+      v->chan           = (rand() % 4) == 0 ? NO_CHANNEL : rand() % 16;
+      v->volenv_section = rand() % FLUID_VOICE_ENVFINISHED;
+      v->volenv_val     = float(rand()) / RAND_MAX;
+      }
+
+//---------------------------------------------------------
+//   linearKill
+//    the voice the former linear search would kill
+//---------------------------------------------------------
+
+static Voice* linearKill(Voice** voice, int n)
+      {
+      Voice* best = 0;
+      double bestPrio = 1e30;
+      for (int i = 0; i < n; ++i) {
+            double prio = VoiceHeap::priority(voice[i]);
+            if (prio < bestPrio) {
+                  best     = voice[i];
+                  bestPrio = prio;
+                  }
+            }
+      return best;
+      }
+
+//---------------------------------------------------------
+//   compareVoiceHeap
+//    steal, restart and change voices; the top of the
+//    heap must always be the voice a linear search finds
+//---------------------------------------------------------
+
+static bool compareVoiceHeap(int n)
+      {
+      Voice** voice = new Voice*[n];
+      VoiceHeap heap(n);
+      unsigned id = 0;
+      for (int i = 0; i < n; ++i) {
+            voice[i] = new Voice(0);
+            randomVoiceState(voice[i], id++);
+            heap.insert(voice[i]);
+            }
+      bool ok = true;
+      for (int k = 0; k < 5000 && ok; ++k) {
+            if (heap.top() != linearKill(voice, n)) {
+                  printf("   voice heap %d: wrong voice at step %d\n", n, k);
+                  ok = false;
+                  }
+            if (k & 1) {
+                  // a note off or envelope transition
+                  Voice* v = voice[rand() % n];
+                  v->chan = NO_CHANNEL;
+                  v->volenv_section = FLUID_VOICE_ENVRELEASE;
+                  v->volenv_val *= 0.5f;
+                  heap.update(v);
+                  }
+            else {
+                  // steal and start a new note
+                  Voice* v = heap.top();
+                  heap.remove(v);
+                  randomVoiceState(v, id++);
+                  heap.insert(v);
+                  }
+            }
+      ok = ok && heap.size() == n;
+      for (int i = 0; i < n; ++i)
+            delete voice[i];
+      delete[] voice;
+      return ok;
+      }
+
+//---------------------------------------------------------
+//   benchVoiceSteal
+//    note on at full polyphony: find the voice to kill
+//    and start a new one in its place
+//---------------------------------------------------------
+
+static void benchVoiceSteal(int n)
+      {
+      static const int NOTES = 200000;
+
+      Voice** voice = new Voice*[n];
+      VoiceHeap heap(n);
+      unsigned id = 0;
+      srand(2);
+      for (int i = 0; i < n; ++i) {
+            voice[i] = new Voice(0);
+            randomVoiceState(voice[i], id++);
+            heap.insert(voice[i]);
+            }
+
+      QElapsedTimer t;
+      t.start();
+      for (int k = 0; k < NOTES; ++k) {
+            Voice* v = linearKill(voice, n);
+            v->id = id++;
+            }
+      qint64 linear = t.nsecsElapsed();
+
+      t.start();
+      for (int k = 0; k < NOTES; ++k) {
+            Voice* v = heap.top();
+            heap.remove(v);
+            v->id = id++;
+            heap.insert(v);
+            }
+      qint64 heaped = t.nsecsElapsed();
+
+      printf("  -voice steal %d voices: linear %.1f ns, heap %.1f ns per note\n",
+         n, double(linear) / NOTES, double(heaped) / NOTES);
+
+      for (int i = 0; i < n; ++i)
+            delete voice[i];
+      delete[] voice;
+      }
+
+//---------------------------------------------------------
+//   testCmdFifo
+//    a full fifo still takes the messages which use the
+//    reserve, in order
+//---------------------------------------------------------
+
+static bool testCmdFifo()
+      {
+      static const int RESERVE = 128;
+      bool passed = true;
+      FluidCmdFifo* fifo = new FluidCmdFifo;
+      FluidCmd cmd;
+      memset(&cmd, 0, sizeof(cmd));
+      int n = 0;
+      for (cmd.a = 0; fifo->put(cmd, RESERVE); ++cmd.a)
+            ++n;
+      TEST(n == FluidCmdFifo::FIFO_SIZE - RESERVE);
+      for (; fifo->put(cmd); ++cmd.a)
+            ++n;
+      TEST(n == FluidCmdFifo::FIFO_SIZE);
+      TEST(!fifo->put(cmd));
+
+      int errors = 0;
+      for (int i = 0; i < n; ++i) {
+            if (!fifo->get(&cmd) || cmd.a != i)
+                  ++errors;
+            }
+      TEST(errors == 0);
+      TEST(!fifo->get(&cmd));
+      TEST(fifo->put(cmd, RESERVE));
+      delete fifo;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   testFluid
+//    interpolation kernels of the fluid synthesizer
+//---------------------------------------------------------
+
+bool testFluid()
+      {
+      printf("====test fluid\n");
+
+      bool passed = true;
+      Voice::dsp_float_config();
+
+      short* data = new short[DATA_SIZE];
+      srand(1);
+      for (unsigned i = 0; i < DATA_SIZE; ++i)
+            data[i] = (rand() % 65536) - 32768;
+
+      static const double incr[] = { 1.0, 0.5, 1.37, 2.9, 0.0131, 3.999 };
+
+      printf("  -interpolation kernels\n");
+      for (unsigned i = 0; i < sizeof(incr)/sizeof(*incr); ++i) {
+            TEST(compareKernel("interp4", Voice::interp4_scalar, Voice::interp4, data, incr[i]));
+            TEST(compareKernel("interp7", Voice::interp7_scalar, Voice::interp7, data, incr[i]));
+#ifdef FLUID_SIMD
+            TEST(compareKernel("interp4_sse2", Voice::interp4_scalar, Voice::interp4_sse2, data, incr[i]));
+            TEST(compareKernel("interp7_sse2", Voice::interp7_scalar, Voice::interp7_sse2, data, incr[i]));
+            if (__builtin_cpu_supports("avx2")) {
+                  TEST(compareKernel("interp4_avx2", Voice::interp4_scalar, Voice::interp4_avx2, data, incr[i]));
+                  TEST(compareKernel("interp7_avx2", Voice::interp7_scalar, Voice::interp7_avx2, data, incr[i]));
+                  }
+#endif
+            }
+
+      printf("  -interpolation count\n");
+      Phase p;
+      p.setFloat(10.0);
+      TEST(Voice::interp_count(p, qint64(1) << 32, 12, 100) == 3);
+      TEST(Voice::interp_count(p, qint64(1) << 31, 12, 100) == 6);
+      TEST(Voice::interp_count(p, qint64(1) << 31, 12, 4) == 4);
+      TEST(Voice::interp_count(p, qint64(1) << 32, 9, 100) == 0);
+
+      printf("  -mix kernels\n");
+      TEST(compareMix("mix", Voice::mix));
+#ifdef FLUID_SIMD
+      TEST(compareMix("mix_sse2", Voice::mix_sse2));
+      if (__builtin_cpu_supports("avx2"))
+            TEST(compareMix("mix_avx2", Voice::mix_avx2));
+#endif
+
+      printf("  -filter coefficient ramp\n");
+      Voice v(0);
+      float buf[BUF_SIZE];
+      for (unsigned i = 0; i < BUF_SIZE; ++i)
+            buf[i] = 0.0f;
+      float out[4][BUF_SIZE];
+      memset(out, 0, sizeof(out));
+      v.dsp_buf  = buf;
+      v.a1       = 0.0f;
+      v.a2       = 0.0f;
+      v.b02      = 0.0f;
+      v.b1       = 0.0f;
+      v.a1_incr  = -1.0f / 64;
+      v.a2_incr  = 0.5f / 64;
+      v.b02_incr = 0.25f / 64;
+      v.b1_incr  = 0.5f / 64;
+      v.hist1    = v.hist2 = 0.0f;
+      v.filter_coeff_incr_count = 64;
+      v.pan = v.amp_left = v.amp_right = v.amp_reverb = v.amp_chorus = 0.0f;
+      v.effects(BUF_SIZE, out[0], out[1], out[2], out[3]);
+      TEST(v.filter_coeff_incr_count == 0);
+      TEST(fabs(v.a1 + 1.0f) < 1e-6 && fabs(v.a2 - 0.5f) < 1e-6);
+      TEST(fabs(v.b02 - 0.25f) < 1e-6 && fabs(v.b1 - 0.5f) < 1e-6);
+
+      benchEffects();
+
+      printf("  -reverb\n");
+      TEST(compareReverb("combs_scalar", combs_scalar));
+#ifdef FLUID_SIMD
+      TEST(compareReverb("combs_sse2", combs_sse2));
+#endif
+
+      printf("  -chorus\n");
+      TEST(compareChorus("chorus_scalar", chorus_scalar));
+#ifdef FLUID_SIMD
+      TEST(compareChorus("chorus_sse2", chorus_sse2));
+#endif
+      benchSendEffects();
+
+      printf("  -command fifo\n");
+      TEST(testCmdFifo());
+
+      printf("  -voice stealing\n");
+      srand(3);
+      TEST(compareVoiceHeap(256));
+      TEST(compareVoiceHeap(512));
+      benchVoiceSteal(256);
+      benchVoiceSteal(512);
+
+      delete[] data;
+      return passed;
+      }
+
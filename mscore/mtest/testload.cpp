@@ -0,0 +1,173 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "libmscore/mscore.h"
+#include "libmscore/score.h"
+#include "mtest.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+extern MScore* mscore;
+
+static const int RUNS = 3;          // load time is the best of RUNS loads
+
+//---------------------------------------------------------
+//   procStatus
+//    value of a memory field of /proc/self/status in kB
+//---------------------------------------------------------
+
+static long procStatus(const char* field)
+      {
+#ifdef Q_OS_LINUX
+      QFile f("/proc/self/status");
+      if (!f.open(QIODevice::ReadOnly))
+            return 0;
+      QByteArray key(field);
+      for (;;) {
+            QByteArray line = f.readLine();
+            if (line.isEmpty())
+                  break;
+            if (line.startsWith(key))
+                  return line.mid(key.size()).trimmed().split(' ').at(0).toLong();
+            }
+#else
+      Q_UNUSED(field);
+#endif
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   resetPeak
+//    return freed memory to the system and set the peak
+//    resident size to the current one
+//---------------------------------------------------------
+
+static void resetPeak()
+      {
+#ifdef __GLIBC__
+      malloc_trim(0);
+#endif
+#ifdef Q_OS_LINUX
+      QFile f("/proc/self/clear_refs");
+      if (f.open(QIODevice::WriteOnly))
+            f.write("5");
+#endif
+      }
+
+//---------------------------------------------------------
+//   load
+//    load path with the stream or the dom reader; ns is
+//    the load time, kb the growth of the peak resident
+//    size while loading
+//---------------------------------------------------------
+
+static Score* load(const QString& path, bool stream, qint64* ns, long* kb)
+      {
+      MScore::streamLoad = stream;
+      resetPeak();
+      long rss = procStatus("VmRSS:");
+      QElapsedTimer clock;
+      clock.start();
+      Score* score = new Score(mscore->baseStyle());
+      score->setName(path);
+      bool loaded = path.endsWith(".mscz") ? score->loadCompressedMsc(path) : score->loadMsc(path);
+      *ns = clock.nsecsElapsed();
+      *kb = procStatus("VmHWM:") - rss;
+      MScore::streamLoad = true;
+      if (!loaded) {
+            delete score;
+            return 0;
+            }
+      return score;
+      }
+
+//---------------------------------------------------------
+//   save
+//---------------------------------------------------------
+
+static QByteArray save(Score* score)
+      {
+      score->doLayout();
+      QBuffer buffer;
+      buffer.open(QIODevice::WriteOnly);
+      score->saveFile(&buffer, false);
+      return buffer.data();
+      }
+
+//---------------------------------------------------------
+//   loadScore
+//    both readers must read the same score
+//---------------------------------------------------------
+
+static bool loadScore(const QString& path, qint64* time, long* mem)
+      {
+      bool passed = true;
+      qint64 ns[2];
+      long kb[2];
+      QByteArray data[2];
+      for (int i = 0; i < 2; ++i) {
+            bool stream = i == 1;
+            Score* score = load(path, stream, &ns[i], &kb[i]);
+            TEST(score != 0);
+            if (score == 0)
+                  return false;
+            data[i] = save(score);
+            delete score;
+            for (int k = 1; k < RUNS; ++k) {
+                  qint64 t;
+                  long m;
+                  delete load(path, stream, &t, &m);
+                  ns[i] = qMin(ns[i], t);
+                  }
+            time[i] += ns[i];
+            mem[i]  += kb[i];
+            }
+      printf("  -%-28s dom %8.1f ms %7ld kB   stream %8.1f ms %7ld kB\n",
+         qPrintable(QFileInfo(path).fileName()), ns[0] * 1e-6, kb[0], ns[1] * 1e-6, kb[1]);
+      TEST(data[0] == data[1]);
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   testLoad
+//    compare the stream reader with the dom reader and
+//    report load time and peak memory of both; the
+//    files in mtest/load cover elements the demos do
+//    not have
+//---------------------------------------------------------
+
+bool testLoad()
+      {
+      printf("====test load\n");
+      bool passed = true;
+
+      QStringList files;
+      QDir demos("../../mscore/demos");
+      foreach(const QString& file, demos.entryList(QStringList() << "*.mscx" << "*.mscz", QDir::Files, QDir::Name))
+            files.append(demos.filePath(file));
+      QDir load("../../mscore/mtest/load");
+      foreach(const QString& file, load.entryList(QStringList() << "*.mscx" << "*.mscz", QDir::Files, QDir::Name))
+            files.append(load.filePath(file));
+      TEST(!files.isEmpty());
+      qint64 time[2] = { 0, 0 };
+      long mem[2]    = { 0, 0 };
+      foreach(const QString& file, files)
+            TEST(loadScore(file, time, mem));
+      printf("  -%-28s dom %8.1f ms %7ld kB   stream %8.1f ms %7ld kB\n",
+         "total", time[0] * 1e-6, mem[0], time[1] * 1e-6, mem[1]);
+      return passed;
+      }
+
@@ -0,0 +1,252 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "mscore/mididriver.h"
+#include "mscore/midiinput.h"
+#include "libmscore/event.h"
+#include "mtest.h"
+
+#ifdef USE_ALSA
+
+#include <alsa/asoundlib.h>
+#include "mscore/alsamidi.h"
+
+static const int SAMPLERATE = 48000;
+static const int BLOCK      = 64;         // audio block of the simulated audio thread
+static const int NOTES      = 100;
+static const int CHANNEL    = 5;          // channel of the "selected part"
+static const int MARKER     = 127;        // note off which ends a filter check
+
+//---------------------------------------------------------
+//   throughClient
+//    the client number of the "Midi Through" client of
+//    snd-seq-dummy, -1 if not loaded
+//---------------------------------------------------------
+
+static int throughClient(snd_seq_t* seq)
+      {
+      snd_seq_client_info_t* cinfo;
+      snd_seq_client_info_alloca(&cinfo);
+      snd_seq_client_info_set_client(cinfo, -1);
+      while (snd_seq_query_next_client(seq, cinfo) >= 0) {
+            if (strncmp(snd_seq_client_info_get_name(cinfo), "Midi Through", 12) == 0)
+                  return snd_seq_client_info_get_client(cinfo);
+            }
+      return -1;
+      }
+
+//---------------------------------------------------------
+//   sendNote
+//    a note on, or a note off if velo is 0
+//---------------------------------------------------------
+
+static void sendNote(snd_seq_t* out, int port, int pitch, int velo)
+      {
+      snd_seq_event_t ev;
+      snd_seq_ev_clear(&ev);
+      snd_seq_ev_set_source(&ev, port);
+      snd_seq_ev_set_subs(&ev);
+      snd_seq_ev_set_direct(&ev);
+      if (velo)
+            snd_seq_ev_set_noteon(&ev, 0, pitch, velo);
+      else
+            snd_seq_ev_set_noteoff(&ev, 0, pitch, 0);
+      snd_seq_event_output_direct(out, &ev);
+      }
+
+//---------------------------------------------------------
+//   thruUntilMarker
+//    take the played notes until the marker note off
+//    arrives; note offs always pass, so all notes sent
+//    before the marker have been read then
+//---------------------------------------------------------
+
+static QList<MidiThruEvent> thruUntilMarker(MidiInput* input)
+      {
+      QList<MidiThruEvent> notes;
+      QElapsedTimer clock;
+      clock.start();
+      while (clock.elapsed() < 1000) {
+            MidiThruEvent te;
+            if (!input->thru(&te)) {
+                  usleep(100);
+                  continue;
+                  }
+            if (te.dataA == MARKER)
+                  break;
+            notes.append(te);
+            }
+      return notes;
+      }
+
+//---------------------------------------------------------
+//   guiEvents
+//---------------------------------------------------------
+
+static int guiEvents(MidiInput* input)
+      {
+      int n = 0;
+      MidiThruEvent e;
+      while (input->guiEvent(&e))
+            ++n;
+      return n;
+      }
+
+//---------------------------------------------------------
+//   filtered
+//    send a note on and off of pitch and the marker;
+//    true if only the note off was played
+//---------------------------------------------------------
+
+static bool filtered(MidiInput* input, snd_seq_t* out, int port, int pitch)
+      {
+      sendNote(out, port, pitch, 100);
+      sendNote(out, port, pitch, 0);
+      sendNote(out, port, MARKER, 0);
+      QList<MidiThruEvent> notes = thruUntilMarker(input);
+      return notes.size() == 1 && notes[0].dataA == pitch && notes[0].dataB == 0
+         && notes[0].channel == CHANNEL;
+      }
+
+//---------------------------------------------------------
+//   testMidiIn
+//    Send notes through snd-seq-dummy to an AlsaMidiDriver
+//    and take them from its MidiInput in a simulated audio
+//    loop. All notes must arrive in the order sent. The
+//    input-to-sound latency, the time from sending to the
+//    end of the block which plays the note, is printed
+//    only: it depends on the load of the machine. Then
+//    check that the note ons the gui would not take
+//    are not played.
+//---------------------------------------------------------
+
+bool testMidiIn()
+      {
+      printf("====test midi input\n");
+
+      snd_seq_t* out;
+      if (snd_seq_open(&out, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
+            printf("  -no alsa sequencer, skipped\n");
+            return true;
+            }
+      int through = throughClient(out);
+      if (through < 0) {
+            printf("  -snd-seq-dummy not loaded, skipped\n");
+            snd_seq_close(out);
+            return true;
+            }
+
+      bool passed = true;
+      MidiInput input;
+      unsigned remote[4] = { 0, 0, 0, 0 };
+      input.setThru(CHANNEL, true, remote);
+
+      // the driver connects to all midi sources, the
+      // "Midi Through" port among them
+      AlsaMidiDriver driver(0, &input);
+      if (!driver.init()) {
+            printf("  -cannot open the alsa sequencer, skipped\n");
+            snd_seq_close(out);
+            return true;
+            }
+      int outPort = snd_seq_create_simple_port(out, "mtest out",
+         SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, SND_SEQ_PORT_TYPE_APPLICATION);
+      TEST(outPort >= 0);
+      if (outPort < 0 || snd_seq_connect_to(out, outPort, through, 0) < 0) {
+            printf("  -cannot connect to snd-seq-dummy\n");
+            snd_seq_close(out);
+            return false;
+            }
+
+      const qint64 period = qint64(BLOCK) * 1000000000LL / SAMPLERATE;
+      qint64 sendTime[128];
+      qint64 maxLatency = 0;
+      qint64 sumLatency = 0;
+      qint64 maxInput   = 0;
+      int received      = 0;
+      int sent          = 0;
+      int gui           = 0;
+      bool channel      = true;
+      bool inOrder      = true;
+      qint64 t          = MidiInputThread::time();
+
+      for (int block = 0; received < NOTES && block < NOTES * 20; ++block) {
+            // send a note every 7 blocks
+            if (sent < NOTES && (block % 7) == 0) {
+                  int pitch = sent % MARKER;
+                  sendTime[pitch] = MidiInputThread::time();
+                  sendNote(out, outPort, pitch, 100);
+                  ++sent;
+                  }
+            t += period;
+            qint64 now;
+            while ((now = MidiInputThread::time()) < t)
+                  usleep(100);
+
+            // audio thread: start of the next block, like Seq::processThru()
+            MidiThruEvent te;
+            while (input.thru(&te)) {
+                  qint64 latency = now + period - sendTime[te.dataA];
+                  maxInput    = qMax(maxInput, te.time - sendTime[te.dataA]);
+                  maxLatency  = qMax(maxLatency, latency);
+                  sumLatency += latency;
+                  channel     = channel && te.channel == CHANNEL;
+                  inOrder     = inOrder && te.dataA == received % MARKER && te.dataB == 100;
+                  ++received;
+                  }
+            gui += guiEvents(&input);
+            }
+      gui += guiEvents(&input);
+
+      printf("  -%d/%d notes, input %.2f ms max, input to sound %.2f ms avg %.2f ms max (block %.2f ms)\n",
+         received, sent, maxInput / 1e6, received ? sumLatency / 1e6 / received : 0.0,
+         maxLatency / 1e6, period / 1e6);
+      TEST(received == sent);
+      TEST(gui == sent);
+      TEST(channel);
+      TEST(inOrder);
+
+      printf("  -filters\n");
+      // a note mapped to a midi remote action
+      remote[60 >> 5] |= 1u << (60 & 31);
+      input.setThru(CHANNEL, true, remote);
+      TEST(filtered(&input, out, outPort, 60));
+      TEST(guiEvents(&input) == 3);
+      remote[60 >> 5] = 0;
+
+      // the gui does not take notes (modal dialog, no score
+      // view, learning a remote action)
+      input.setThru(CHANNEL, false, remote);
+      TEST(filtered(&input, out, outPort, 61));
+      TEST(guiEvents(&input) == 3);
+
+      // midi input disabled
+      input.setThru(CHANNEL, true, remote);
+      input.setEnabled(false);
+      TEST(filtered(&input, out, outPort, 62));
+      TEST(guiEvents(&input) == 0);
+
+      snd_seq_close(out);
+      return passed;
+      }
+
+#else
+
+bool testMidiIn()
+      {
+      return true;
+      }
+
+#endif
+
@@ -0,0 +1,184 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "mscore/rtaudit.h"
+#include "mscore/seqplayer.h"
+#include "mscore/renderdriver.h"
+#include "mscore/preferences.h"
+#include "msynth/synti.h"
+#include "libmscore/mscore.h"
+#include "libmscore/score.h"
+#include "mtest.h"
+#include "testutils.h"
+
+#ifdef RT_AUDIT
+
+extern MScore* mscore;
+
+//---------------------------------------------------------
+//   auditScore
+//    play the score through the sequencer into the
+//    render driver; SeqPlayer::process() runs inside an
+//    audit scope on the render thread
+//---------------------------------------------------------
+
+static bool auditScore(SeqPlayer* player, RenderDriver* driver, const QString& sf, const QString& path)
+      {
+      bool passed = true;
+      Score* score = new Score(mscore->baseStyle());
+      score->setName(path);
+      bool loaded = path.endsWith(".mscz") ? score->loadCompressedMsc(path) : score->loadMsc(path);
+      TEST(loaded);
+      if (!loaded) {
+            delete score;
+            return false;
+            }
+      score->rebuildMidiMapping();
+      score->updateNotes();
+      score->doLayout();
+      score->syntiState().append(SyntiParameter("soundfont", sf));
+
+      player->setScore(score);
+      RtAudit::reset();
+      TEST(driver->render(0));
+      int violations = RtAudit::violations();
+      printf("  -%-24s %6d blocks, %.1f x realtime, %d violations\n",
+         qPrintable(QFileInfo(path).fileName()), driver->blocks(),
+         driver->realtimeFactor(), violations);
+      TEST(violations == 0);
+
+      player->setScore(0);
+      delete score;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   auditedRelease
+//---------------------------------------------------------
+
+static void auditedRelease(QSemaphore* sem)
+      {
+      RtAuditScope audit;
+      sem->release();
+      }
+
+//---------------------------------------------------------
+//   auditedLock
+//---------------------------------------------------------
+
+static void auditedLock(QMutex* mutex)
+      {
+      RtAuditScope audit;
+      mutex->lock();
+      }
+
+//---------------------------------------------------------
+//   auditQtLocks
+//    a QSemaphore release and a QMutex lock inside an
+//    audit scope are reported, outside they are not
+//---------------------------------------------------------
+
+static bool auditQtLocks()
+      {
+      bool passed = true;
+      QSemaphore sem;
+      QMutex mutex;
+
+      RtAudit::reset();
+      sem.release();
+      sem.acquire();
+      mutex.lock();
+      mutex.unlock();
+      int outside = RtAudit::violations();
+
+      RtAudit::reset();
+      auditedRelease(&sem);
+      int release = RtAudit::violations();
+
+      RtAudit::reset();
+      auditedLock(&mutex);
+      mutex.unlock();
+      int lock = RtAudit::violations();
+      RtAudit::reset();
+
+      printf("  -qt locks: outside %d, QSemaphore::release %d, QMutex::lock %d violations\n",
+         outside, release, lock);
+      TEST(outside == 0);
+      TEST(release > 0);
+      TEST(lock > 0);
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   testRtAudit
+//    play the demo scores through the sequencer and the
+//    render driver with the realtime audit enabled; any
+//    allocation, lock or blocking call in the audio
+//    thread fails the test. First check that Qt locks
+//    are seen by the audit.
+//---------------------------------------------------------
+
+bool testRtAudit()
+      {
+      printf("====test realtime audit\n");
+      bool passed = true;
+
+      TEST(auditQtLocks());
+
+      QString sf = testSoundFont();
+      if (sf.isEmpty()) {
+            printf("  -no soundfont, scores skipped\n");
+            return passed;
+            }
+      // the test preferences enable no audio, MasterSynth would
+      // not create a synthesizer
+      Preferences saved = preferences;
+      preferences.useAlsaAudio = true;
+      preferences.tuning       = 440.0;
+      preferences.masterGain   = 1.0;
+
+      synti = new MasterSynth();
+      SeqPlayer* player    = new SeqPlayer();
+      RenderDriver* driver = new RenderDriver(player, MScore::sampleRate);
+      TEST(player->init(driver));
+      // audit the realtime mode of a device driver: samples
+      // are loaded by the loader thread, not by the audio
+      // thread
+      synti->setOffline(false);
+
+      QDir dir("../../mscore/demos");
+      QStringList files = dir.entryList(QStringList() << "*.mscx" << "*.mscz", QDir::Files, QDir::Name);
+      TEST(!files.isEmpty());
+      foreach(const QString& file, files)
+            TEST(auditScore(player, driver, sf, dir.filePath(file)));
+
+      delete driver;
+      delete player;
+      delete synti;
+      synti = 0;
+      preferences = saved;
+      return passed;
+      }
+
+#else
+
+bool testRtAudit()
+      {
+      printf("====test realtime audit\n");
+      printf("  -not built with RT_AUDIT, skipped\n");
+      return true;
+      }
+
+#endif
+
@@ -0,0 +1,201 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "mscore/seqplayer.h"
+#include "msynth/synti.h"
+#include "libmscore/mscore.h"
+#include "libmscore/score.h"
+#include "libmscore/instrument.h"
+#include "libmscore/event.h"
+#include "mcursor.h"
+#include "mtest.h"
+
+//---------------------------------------------------------
+//   ChaseSynth
+//    records the controller events played by the
+//    sequencer as "channel:controller=value"
+//---------------------------------------------------------
+
+class ChaseSynth : public Synth {
+      QList<MidiPatch*> patches;
+
+   public:
+      QStringList played;
+
+      virtual void init(int) {}
+      virtual const char* name() const                      { return "Chase"; }
+      virtual bool loadSoundFonts(const QStringList&)       { return true; }
+      virtual QStringList soundFonts() const                { return QStringList(); }
+      virtual void process(unsigned, float*, float*, float) {}
+      virtual const QList<MidiPatch*>& getPatchInfo() const { return patches; }
+      virtual SyntiState state() const                      { return SyntiState(); }
+      virtual void play(const Event& e) {
+            if (e.type() != ME_CONTROLLER)
+                  return;
+            QString ctrl;
+            if (e.controller() == CTRL_PROGRAM)
+                  ctrl = "program";
+            else if (e.controller() == CTRL_PITCH)
+                  ctrl = "pitch";
+            else
+                  ctrl = QString::number(e.controller());
+            played.append(QString("%1:%2=%3").arg(e.channel()).arg(ctrl).arg(e.value()));
+            }
+      };
+
+//---------------------------------------------------------
+//   ChasePlayer
+//    plays a synthetic playlist instead of the one of
+//    the score
+//---------------------------------------------------------
+
+class ChasePlayer : public SeqPlayer {
+   public:
+      void setPlaylist(const EventMap& el) {
+            events = el;
+            snapshots.build(events, cs);
+            }
+      void seek(int utick) { chase(utick); }
+      };
+
+//---------------------------------------------------------
+//   addController
+//---------------------------------------------------------
+
+static void addController(EventMap* events, int tick, int channel, int ctrl, int value)
+      {
+      Event e(ME_CONTROLLER);
+      e.setChannel(channel);
+      e.setController(ctrl);
+      e.setValue(value);
+      events->insertMulti(tick, e);
+      }
+
+//---------------------------------------------------------
+//   addNote
+//---------------------------------------------------------
+
+static void addNote(EventMap* events, int tick, int len, int channel, int pitch)
+      {
+      Event e(ME_NOTEON);
+      e.setChannel(channel);
+      e.setDataA(pitch);
+      e.setDataB(80);
+      events->insertMulti(tick, e);
+      e.setDataB(0);
+      events->insertMulti(tick + len, e);
+      }
+
+//---------------------------------------------------------
+//   chaseAt
+//    seek to utick and compare the events sent to the
+//    synthesizer with the expected ones
+//---------------------------------------------------------
+
+static bool chaseAt(ChasePlayer* player, ChaseSynth* synth, int utick, const QStringList& expected)
+      {
+      bool passed = true;
+      synth->played.clear();
+      player->seek(utick);
+      printf("  -seek %5d: %s\n", utick, qPrintable(synth->played.join(" ")));
+      if (synth->played != expected)
+            printf("   expected:  %s\n", qPrintable(expected.join(" ")));
+      TEST(synth->played == expected);
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   testSeqChase
+//    A seek chases the controllers, programs and pitch
+//    bends changed by the playlist before the seek
+//    position, starting from the instrument init list.
+//    Controllers the playlist does not change, data
+//    entry and the events at the seek position are not
+//    chased. The seeks cover the first snapshot, a seek
+//    between two snapshots and a seek to a snapshot.
+//---------------------------------------------------------
+
+bool testSeqChase()
+      {
+      printf("====test seek chase\n");
+      bool passed = true;
+
+      MCursor c;
+      c.createScore("chase");
+      c.addPart("Violin");                      // three channels
+      Score* score = c.score();
+      score->rebuildMidiMapping();
+      TEST(score->midiMapping()->size() >= 2);
+      if (score->midiMapping()->size() < 2) {
+            delete score;
+            return false;
+            }
+      for (int i = 0; i < score->midiMapping()->size(); ++i) {
+            Channel* a = score->midiMapping(i)->articulation;
+            a->program = 3;
+            a->bank    = 0;
+            a->volume  = 90;
+            a->pan     = 30;
+            a->updateInitList();
+            }
+
+      const int M = MScore::division * 4;      // ticks per measure
+      EventMap events;
+      for (int m = 0; m < 10; ++m)
+            events.insertMulti(m * M, Event(ME_TICK1));
+      addController(&events, 0,           0, CTRL_PROGRAM, 10);
+      addNote(&events,       0, M,        0, 60);
+      addController(&events, M/2,         0, CTRL_SUSTAIN, 127);
+      addController(&events, 5*M + M/4,   0, CTRL_VOLUME,  80);
+      addController(&events, 5*M + M/4,   0, CTRL_PROGRAM, 20);
+      addController(&events, 5*M + M/2,   0, CTRL_PITCH,   9000);
+      addController(&events, 6*M,         0, CTRL_SUSTAIN, 0);
+      addController(&events, 7*M + M/8,   0, CTRL_VOLUME,  30);
+      addController(&events, M,           1, CTRL_PITCH,   4000);
+      addController(&events, 2*M,         1, CTRL_HDATA,   5);
+      addController(&events, 7*M,         1, CTRL_PANPOT,  20);
+      addNote(&events,       7*M, M,      1, 67);
+
+      MasterSynth* saved = synti;
+      synti = new MasterSynth();
+      ChaseSynth* synth = new ChaseSynth();
+      synti->addSynth(synth);
+      ChasePlayer player;
+      player.setScore(score);
+      player.setPlaylist(events);
+
+      // before the events at tick 0: init list and defaults
+      TEST(chaseAt(&player, synth, 0, QStringList()
+         << "0:7=90" << "0:64=0" << "0:program=3" << "0:pitch=0"
+         << "1:10=30" << "1:pitch=0"));
+      // between the snapshots of measure 4 and 8
+      TEST(chaseAt(&player, synth, 5*M + 3*M/4, QStringList()
+         << "0:7=80" << "0:64=127" << "0:program=20" << "0:pitch=9000"
+         << "1:10=30" << "1:pitch=4000"));
+      // the pan change at the seek position is not chased
+      TEST(chaseAt(&player, synth, 7*M, QStringList()
+         << "0:7=80" << "0:64=0" << "0:program=20" << "0:pitch=9000"
+         << "1:10=30" << "1:pitch=4000"));
+      // at the snapshot of measure 8
+      TEST(chaseAt(&player, synth, 8*M, QStringList()
+         << "0:7=30" << "0:64=0" << "0:program=20" << "0:pitch=9000"
+         << "1:10=20" << "1:pitch=4000"));
+
+      player.setScore(0);
+      delete synti;
+      synti = saved;
+      delete score;
+      return passed;
+      }
+
@@ -0,0 +1,717 @@
+//=============================================================================
+//  MuseScore
+//  Music Composition & Notation
+//  $Id:$
+//
+//  Copyright (C) 2012 Werner Schweer
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License version 2
+//  as published by the Free Software Foundation and appearing in
+//  the file LICENCE.GPL
+//=============================================================================
+
+#include "config.h"
+#include "fluid/fluid.h"
+#include "libmscore/mscore.h"
+#include "libmscore/score.h"
+#include "libmscore/instrument.h"
+#include "libmscore/event.h"
+#include "msynth/sparm.h"
+#include "msynth/synti.h"
+#include "mscore/seqplayer.h"
+#include "mscore/renderdriver.h"
+#include "mscore/preferences.h"
+#include "mtest.h"
+#include "testutils.h"
+
+extern bool importMidi(Score*, const QString&);
+extern MScore* mscore;
+
+static const unsigned BLOCK = 256;
+static const int SECONDS    = 20;         // played of every file
+static const int FFT_SIZE   = 4096;
+static const int BANDS      = 20;
+static const double MIN_DB  = -100.0;
+static const double BAND_TOLERANCE  = 1.0;      // dB
+static const double LEVEL_TOLERANCE = 1.5;      // dB
+
+//---------------------------------------------------------
+//   Spectrum
+//    the long term power spectrum of the rendered output
+//    in BANDS log spaced bands from 60 Hz to 16 kHz and
+//    the level of every second, both in dB
+//---------------------------------------------------------
+
+class Spectrum {
+      float window[FFT_SIZE];
+      float re[FFT_SIZE], im[FFT_SIZE];
+      int bandOf[FFT_SIZE / 2];
+      double power[BANDS];
+      int fill;
+      int frames;
+      double levelSum;
+      int sampleRate;
+
+      void fft();
+      void analyze();
+
+   public:
+      QVector<float> bands;
+      QVector<float> levels;
+
+      Spectrum(int sampleRate);
+      void add(const float* l, const float* r, int n);
+      void finish();
+      };
+
+//---------------------------------------------------------
+//   Spectrum
+//---------------------------------------------------------
+
+Spectrum::Spectrum(int sr)
+      {
+      sampleRate = sr;
+      for (int i = 0; i < FFT_SIZE; ++i)
+            window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / FFT_SIZE);
+      for (int i = 0; i < FFT_SIZE / 2; ++i) {
+            double f = double(i) * sr / FFT_SIZE;
+            if (f < 60.0 || f >= 16000.0)
+                  bandOf[i] = -1;
+            else
+                  bandOf[i] = int(log(f / 60.0) / log(16000.0 / 60.0) * BANDS);
+            }
+      memset(power, 0, sizeof(power));
+      fill     = 0;
+      frames   = 0;
+      levelSum = 0.0;
+      }
+
+//---------------------------------------------------------
+//   fft
+//    in place radix 2
+//---------------------------------------------------------
+
+void Spectrum::fft()
+      {
+      for (int i = 1, j = 0; i < FFT_SIZE; ++i) {
+            int bit = FFT_SIZE >> 1;
+            for (; j & bit; bit >>= 1)
+                  j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                  qSwap(re[i], re[j]);
+                  qSwap(im[i], im[j]);
+                  }
+            }
+      for (int len = 2; len <= FFT_SIZE; len <<= 1) {
+            double a = -2.0 * M_PI / len;
+            for (int i = 0; i < FFT_SIZE; i += len) {
+                  for (int k = 0; k < len / 2; ++k) {
+                        float wr = cos(a * k);
+                        float wi = sin(a * k);
+                        float* r1 = &re[i + k];
+                        float* i1 = &im[i + k];
+                        float* r2 = &re[i + k + len / 2];
+                        float* i2 = &im[i + k + len / 2];
+                        float tr  = *r2 * wr - *i2 * wi;
+                        float ti  = *r2 * wi + *i2 * wr;
+                        *r2 = *r1 - tr;
+                        *i2 = *i1 - ti;
+                        *r1 += tr;
+                        *i1 += ti;
+                        }
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   analyze
+//---------------------------------------------------------
+
+void Spectrum::analyze()
+      {
+      for (int i = 0; i < FFT_SIZE; ++i) {
+            re[i] *= window[i];
+            im[i] = 0.0f;
+            }
+      fft();
+      for (int i = 0; i < FFT_SIZE / 2; ++i) {
+            if (bandOf[i] >= 0)
+                  power[bandOf[i]] += re[i] * re[i] + im[i] * im[i];
+            }
+      fill = 0;
+      }
+
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+void Spectrum::add(const float* l, const float* r, int n)
+      {
+      for (int i = 0; i < n; ++i) {
+            float v = (l[i] + r[i]) * 0.5f;
+            re[fill++] = v;
+            levelSum += v * v;
+            if (++frames == sampleRate) {
+                  levels.append(qMax(MIN_DB, 10.0 * log10(levelSum / sampleRate)));
+                  frames   = 0;
+                  levelSum = 0.0;
+                  }
+            if (fill == FFT_SIZE)
+                  analyze();
+            }
+      }
+
+//---------------------------------------------------------
+//   finish
+//    bands relative to the loudest band
+//---------------------------------------------------------
+
+void Spectrum::finish()
+      {
+      double max = 0.0;
+      for (int i = 0; i < BANDS; ++i)
+            max = qMax(max, power[i]);
+      for (int i = 0; i < BANDS; ++i) {
+            double db = (max > 0.0 && power[i] > 0.0) ? 10.0 * log10(power[i] / max) : MIN_DB;
+            bands.append(qMax(MIN_DB, db));
+            }
+      }
+
+//---------------------------------------------------------
+//   Rendering
+//---------------------------------------------------------
+
+struct Rendering {
+      qint64 frames;
+      qint64 voiceFrames;           // sum of sounding voices over all frames
+      qint64 nsec;                  // spent in SeqPlayer::process()
+      int peakVoices;
+      QByteArray hash;              // md5 of the output samples
+      Spectrum* spectrum;
+      };
+
+//---------------------------------------------------------
+//   AnalysisSink
+//    hash and spectrum of the exported frames
+//---------------------------------------------------------
+
+class AnalysisSink : public AudioEncoder {
+      QCryptographicHash md5;
+      Spectrum* spectrum;
+
+   public:
+      AnalysisSink(Spectrum* s) : md5(QCryptographicHash::Md5), spectrum(s) {}
+      QByteArray hash() const { return md5.result().toHex(); }
+      virtual bool write(const float* frames, int n) {
+            md5.addData((const char*)frames, n * 2 * sizeof(float));
+            float l[BLOCK], r[BLOCK];
+            while (n) {
+                  int m = qMin(n, int(BLOCK));
+                  for (int i = 0; i < m; ++i) {
+                        l[i] = *frames++;
+                        r[i] = *frames++;
+                        }
+                  spectrum->add(l, r, m);
+                  n -= m;
+                  }
+            return true;
+            }
+      virtual bool close() { return true; }
+      };
+
+//---------------------------------------------------------
+//   ExcerptPlayer
+//    plays the first SECONDS of the score
+//---------------------------------------------------------
+
+class ExcerptPlayer : public SeqPlayer {
+   public:
+      virtual void collectEvents() {
+            SeqPlayer::collectEvents();
+            EventMap::iterator i = events.lowerBound(cs->utime2utick(SECONDS));
+            while (i != events.end())
+                  i = events.erase(i);
+            endTick = events.isEmpty() ? 0 : (events.constEnd() - 1).key();
+            snapshots.build(events, cs);
+            }
+      };
+
+//---------------------------------------------------------
+//   loadFile
+//    a score or a midi file
+//---------------------------------------------------------
+
+static Score* loadFile(const QString& path)
+      {
+      Score* score = new Score(mscore->baseStyle());
+      score->setName(QFileInfo(path).completeBaseName());
+      bool loaded;
+      if (path.endsWith(".mid"))
+            loaded = importMidi(score, path);
+      else if (path.endsWith(".mscz"))
+            loaded = score->loadCompressedMsc(path);
+      else
+            loaded = score->loadMsc(path);
+      if (!loaded) {
+            delete score;
+            return 0;
+            }
+      score->rebuildMidiMapping();
+      score->updateNotes();
+      score->doLayout();
+      return score;
+      }
+
+//---------------------------------------------------------
+//   render
+//    play the first SECONDS of the score with a fresh
+//    sequencer and synthesizer through the render
+//    driver, as the offline export does; the synthesizer
+//    uses only the soundfont sf. The voice frames are
+//    taken from the voice histogram of the audio stats
+//    and are exact to half a bin.
+//---------------------------------------------------------
+
+static bool render(const QString& sf, Score* score, int threads, Rendering* rd)
+      {
+      bool passed = true;
+      score->syntiState().clear();
+      score->syntiState().append(SyntiParameter("soundfont", sf));
+
+      // the test preferences enable no audio, MasterSynth would
+      // not create a synthesizer
+      Preferences saved = preferences;
+      preferences.useAlsaAudio = true;
+      preferences.tuning       = 440.0;
+      preferences.masterGain   = 1.0;
+
+      MasterSynth* savedSynti = synti;
+      synti = new MasterSynth();
+      ExcerptPlayer* player = new ExcerptPlayer();
+      RenderDriver* driver  = new RenderDriver(player, MScore::sampleRate, BLOCK);
+      TEST(player->init(driver));
+      synti->setRenderThreads(threads);
+      player->setScore(score);
+      player->audioStats()->reset();
+
+      rd->spectrum = new Spectrum(MScore::sampleRate);
+      AnalysisSink sink(rd->spectrum);
+      TEST(driver->render(&sink));
+      rd->spectrum->finish();
+      rd->hash        = sink.hash();
+      rd->frames      = driver->frames();
+      rd->nsec        = driver->renderNsec();
+      AudioStatsData stats;
+      player->audioStats()->get(&stats);
+      rd->peakVoices  = stats.maxVoices;
+      rd->voiceFrames = 0;
+      for (int i = 0; i < AudioStatsData::VOICE_BINS; ++i) {
+            int voices = i * AudioStatsData::VOICE_STEP + AudioStatsData::VOICE_STEP / 2;
+            rd->voiceFrames += qint64(stats.voiceHist[i]) * voices * BLOCK;
+            }
+
+      player->setScore(0);
+      delete driver;
+      delete player;
+      delete synti;
+      synti       = savedSynti;
+      preferences = saved;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   maxDeviation
+//---------------------------------------------------------
+
+static double maxDeviation(const QVector<float>& a, const QVector<float>& b)
+      {
+      if (a.size() != b.size())
+            return 1e10;
+      double d = 0.0;
+      for (int i = 0; i < a.size(); ++i)
+            d = qMax(d, fabs(a[i] - b[i]));
+      return d;
+      }
+
+//---------------------------------------------------------
+//   readValues
+//---------------------------------------------------------
+
+static QVector<float> readValues(const QString& s)
+      {
+      QVector<float> v;
+      foreach(const QString& val, s.split(' ', QString::SkipEmptyParts))
+            v.append(val.toFloat());
+      return v;
+      }
+
+//---------------------------------------------------------
+//   writeValues
+//---------------------------------------------------------
+
+static QString writeValues(const QVector<float>& v)
+      {
+      QString s;
+      foreach(float val, v)
+            s += QString(" %1").arg(val, 0, 'f', 2);
+      return s;
+      }
+
+//---------------------------------------------------------
+//   compareReference
+//    The reference of a file is only written if
+//    MTEST_SYNTH_UPDATE is set. References are only
+//    valid for the soundfont they were rendered with, so
+//    none are committed: without a reference or with one
+//    of another soundfont the file is skipped and
+//    *skipped is set.
+//    An identical hash passes; otherwise the spectrum
+//    and the levels must be within the tolerances.
+//---------------------------------------------------------
+
+static bool compareReference(const QString& path, const QString& sfId, const Rendering& rd, bool* skipped)
+      {
+      bool passed = true;
+      QFile f(path);
+      *skipped = false;
+      if (!qgetenv("MTEST_SYNTH_UPDATE").isEmpty()) {
+            QDir().mkpath(QFileInfo(path).path());
+            TEST(f.open(QIODevice::WriteOnly | QIODevice::Text));
+            if (!passed)
+                  return false;
+            QTextStream os(&f);
+            os << "soundfont " << sfId << "\n";
+            os << "hash " << rd.hash << "\n";
+            os << "bands" << writeValues(rd.spectrum->bands) << "\n";
+            os << "levels" << writeValues(rd.spectrum->levels) << "\n";
+            printf("      reference written\n");
+            return true;
+            }
+      if (!f.exists()) {
+            printf("      no reference %s, skipped; set MTEST_SYNTH_UPDATE to write it\n",
+               qPrintable(path));
+            *skipped = true;
+            return true;
+            }
+      TEST(f.open(QIODevice::ReadOnly | QIODevice::Text));
+      if (!passed)
+            return false;
+      QString soundFont, hash;
+      QVector<float> bands, levels;
+      QTextStream is(&f);
+      while (!is.atEnd()) {
+            QString line = is.readLine();
+            QString key  = line.section(' ', 0, 0);
+            QString val  = line.section(' ', 1);
+            if (key == "soundfont")
+                  soundFont = val;
+            else if (key == "hash")
+                  hash = val;
+            else if (key == "bands")
+                  bands = readValues(val);
+            else if (key == "levels")
+                  levels = readValues(val);
+            }
+      if (soundFont != sfId) {
+            printf("      reference rendered with <%s>, skipped\n", qPrintable(soundFont));
+            *skipped = true;
+            return true;
+            }
+      if (hash == rd.hash)
+            return true;
+      double db = maxDeviation(bands, rd.spectrum->bands);
+      double dl = maxDeviation(levels, rd.spectrum->levels);
+      printf("      output differs from reference: spectrum %.2f dB, level %.2f dB\n", db, dl);
+      TEST(db <= BAND_TOLERANCE);
+      TEST(dl <= LEVEL_TOLERANCE);
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   Totals
+//---------------------------------------------------------
+
+struct Totals {
+      qint64 frames;
+      qint64 voiceFrames;
+      qint64 nsec;
+      int peakVoices;
+      int compared;
+      int skipped;
+      };
+
+//---------------------------------------------------------
+//   synthFile
+//    render a file with a fresh synthesizer, print the
+//    throughput and compare against the reference
+//---------------------------------------------------------
+
+static bool synthFile(const QString& sf, const QString& sfId, const QString& path, Totals* totals)
+      {
+      bool passed = true;
+      Score* score = loadFile(path);
+      TEST(score);
+      if (!score)
+            return false;
+
+      Rendering rd;
+      TEST(render(sf, score, 1, &rd));
+      double sec = qMax(rd.nsec, qint64(1)) * 1e-9;
+      printf("  -%-24s %5.1f s, %7.0f voices/s, %6.1f ns/sample, peak %3d voices\n",
+         qPrintable(QFileInfo(path).fileName()), double(rd.frames) / MScore::sampleRate,
+         double(rd.voiceFrames) / MScore::sampleRate / sec,
+         double(rd.nsec) / qMax(rd.frames, qint64(1)), rd.peakVoices);
+
+      QString ref = QString("../../mscore/mtest/synth/%1.ref").arg(QFileInfo(path).fileName());
+      bool skipped;
+      TEST(compareReference(ref, sfId, rd, &skipped));
+      if (skipped)
+            ++totals->skipped;
+      else
+            ++totals->compared;
+
+      totals->frames      += rd.frames;
+      totals->voiceFrames += rd.voiceFrames;
+      totals->nsec        += rd.nsec;
+      totals->peakVoices   = qMax(totals->peakVoices, rd.peakVoices);
+
+      delete rd.spectrum;
+      delete score;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   renderThreads
+//    with several render threads the output must not
+//    depend on the timing of the threads: two renderings
+//    must be bit identical
+//---------------------------------------------------------
+
+static bool renderThreads(const QString& sf, const QString& path, int threads)
+      {
+      bool passed = true;
+      Score* score = loadFile(path);
+      TEST(score);
+      if (!score)
+            return false;
+      QByteArray hash[2];
+      for (int i = 0; i < 2; ++i) {
+            Rendering rd;
+            TEST(render(sf, score, threads, &rd));
+            hash[i] = rd.hash;
+            delete rd.spectrum;
+            }
+      printf("  -%-24s %d render threads %s\n", qPrintable(QFileInfo(path).fileName()), threads,
+         hash[0] == hash[1] ? "reproducible" : "differ");
+      TEST(hash[0] == hash[1]);
+      delete score;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   deferredNote
+//    a note played right after a program change must
+//    start once the loader thread has made the samples
+//    resident; it must not be lost
+//---------------------------------------------------------
+
+static bool deferredNote(const QString& sf)
+      {
+      bool passed = true;
+      FluidS::Fluid* synth = new FluidS::Fluid();
+      synth->init(MScore::sampleRate);
+      TEST(synth->loadSoundFonts(QStringList(sf)));
+
+      Event e(ME_CONTROLLER);
+      e.setChannel(0);
+      e.setDataA(CTRL_PROGRAM);
+      e.setDataB(19);               // church organ, sustained
+      synth->play(e);
+      Event n(ME_NOTEON);
+      n.setChannel(0);
+      n.setDataA(60);
+      n.setDataB(100);
+      synth->play(n);
+
+      float lbuffer[BLOCK], rbuffer[BLOCK];
+      QElapsedTimer t;
+      t.start();
+      int blocks = 0;
+      while (synth->voiceCount() == 0 && t.elapsed() < 5000) {
+            memset(lbuffer, 0, sizeof(lbuffer));
+            memset(rbuffer, 0, sizeof(rbuffer));
+            synth->process(BLOCK, lbuffer, rbuffer, 1.0);
+            ++blocks;
+            }
+      printf("  -note after program change started after %d blocks\n", blocks);
+      TEST(synth->voiceCount() > 0);
+      TEST(synth->takeDroppedEvents() == 0);
+      delete synth;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   MemorySink
+//    keeps the exported frames
+//---------------------------------------------------------
+
+class MemorySink : public AudioEncoder {
+   public:
+      QVector<float> data;          // interleaved stereo
+      virtual bool write(const float* frames, int n) {
+            for (int i = 0; i < n * 2; ++i)
+                  data.append(frames[i]);
+            return true;
+            }
+      virtual bool close() { return true; }
+      };
+
+//---------------------------------------------------------
+//   writeOnsetMidi
+//    a type 0 midi file at 120 bpm with two notes
+//    starting at 1.0 s and 2.5 s, the last note off is
+//    at 3.0 s
+//---------------------------------------------------------
+
+static bool writeOnsetMidi(const QString& path)
+      {
+      static const unsigned char track[] = {
+            0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20,       // 500000 us per quarter
+            0x00, 0xc0, 0x00,
+            0x87, 0x40, 0x90, 0x3c, 0x64,                   // 960 ticks
+            0x83, 0x60, 0x80, 0x3c, 0x00,                   // 480 ticks
+            0x87, 0x40, 0x90, 0x40, 0x64,
+            0x83, 0x60, 0x80, 0x40, 0x00,
+            0x00, 0xff, 0x2f, 0x00
+            };
+      static const unsigned char header[] = {
+            'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0x01, 0xe0,     // 480 ticks per quarter
+            'M', 'T', 'r', 'k', 0, 0, 0, sizeof(track)
+            };
+      QFile f(path);
+      if (!f.open(QIODevice::WriteOnly))
+            return false;
+      f.write((const char*)header, sizeof(header));
+      f.write((const char*)track, sizeof(track));
+      return true;
+      }
+
+//---------------------------------------------------------
+//   onset
+//    the first frame in [from, to) louder than four times
+//    the loudest of the 50 ms before from; -1 if none
+//---------------------------------------------------------
+
+static int onset(const QVector<float>& data, int from, int to, int sampleRate)
+      {
+      float floor = 0.0;
+      for (int i = qMax(0, from - sampleRate / 20) * 2; i < from * 2 && i < data.size(); ++i)
+            floor = qMax(floor, qAbs(data[i]));
+      for (int f = from; f < to && f * 2 + 1 < data.size(); ++f) {
+            if (qAbs(data[f * 2]) > floor * 4 + 1e-3 || qAbs(data[f * 2 + 1]) > floor * 4 + 1e-3)
+                  return f;
+            }
+      return -1;
+      }
+
+//---------------------------------------------------------
+//   exportRate
+//    export at a sample rate other than MScore::sampleRate;
+//    the notes must start at their time in the export
+//    rate and the length must match
+//---------------------------------------------------------
+
+static bool exportRate(const QString& sf)
+      {
+      bool passed = true;
+      QString path = QDir::tempPath() + "/mtest-onsets.mid";
+      TEST(writeOnsetMidi(path));
+      Score* score = loadFile(path);
+      QFile::remove(path);
+      TEST(score);
+      if (!score)
+            return false;
+      score->syntiState().append(SyntiParameter("soundfont", sf));
+
+      // the test preferences enable no audio, MasterSynth would
+      // not create a synthesizer
+      Preferences saved = preferences;
+      preferences.useAlsaAudio = true;
+      preferences.tuning       = 440.0;
+      preferences.masterGain   = 1.0;
+
+      int rate = MScore::sampleRate / 2;
+      MemorySink sink;
+      TEST(renderAudio(score, rate, &sink, QList<AudioEncoder*>(), 0));
+      preferences = saved;
+
+      int frames = sink.data.size() / 2;
+      printf("  -export at %d Hz: %d frames\n", rate, frames);
+      TEST(frames >= 4 * rate && frames < 4 * rate + 512);
+      static const double start[] = { 1.0, 2.5 };
+      for (int i = 0; i < 2; ++i) {
+            int expected = int(start[i] * rate);
+            int f = onset(sink.data, expected - rate / 10, expected + rate / 10, rate);
+            printf("      note %d: onset at frame %d, expected %d\n", i + 1, f, expected);
+            TEST(f >= expected - 64 && f <= expected + rate / 50);
+            }
+      delete score;
+      return passed;
+      }
+
+//---------------------------------------------------------
+//   testSynth
+//    play the midi test files and the demo scores
+//    through the sequencer and the render driver into
+//    fluid; reports the throughput as voices rendered
+//    per second of cpu time (a voice playing for one
+//    second counts one) and ns per output sample, and
+//    checks the output against the references in
+//    mtest/synth
+//---------------------------------------------------------
+
+bool testSynth()
+      {
+      printf("====test synthesizer\n");
+      bool passed = true;
+
+      QString sf = testSoundFont();
+      if (sf.isEmpty()) {
+            printf("  -no soundfont, skipped\n");
+            return true;
+            }
+      QFileInfo fi(sf);
+      QString sfId = QString("%1 %2").arg(fi.fileName()).arg(fi.size());
+      printf("  -soundfont %s\n", qPrintable(sf));
+
+      QStringList files;
+      QDir midi("../../mscore/test/midi");
+      foreach(const QString& file, midi.entryList(QStringList() << "*.mid", QDir::Files, QDir::Name))
+            files.append(midi.filePath(file));
+      QDir demos("../../mscore/demos");
+      foreach(const QString& file, demos.entryList(QStringList() << "*.mscx" << "*.mscz", QDir::Files, QDir::Name))
+            files.append(demos.filePath(file));
+      TEST(!files.isEmpty());
+
+      Totals totals;
+      memset(&totals, 0, sizeof(totals));
+      foreach(const QString& file, files)
+            TEST(synthFile(sf, sfId, file, &totals));
+
+      double sec = qMax(totals.nsec, qint64(1)) * 1e-9;
+      printf("  -total %5.1f s, %7.0f voices/s, %6.1f ns/sample, %5.1f x realtime, peak %d voices\n",
+         double(totals.frames) / MScore::sampleRate,
+         double(totals.voiceFrames) / MScore::sampleRate / sec,
+         double(totals.nsec) / qMax(totals.frames, qint64(1)),
+         double(totals.frames) / MScore::sampleRate / sec,
+         totals.peakVoices);
+      printf("  -%d files compared with their reference, %d skipped\n", totals.compared, totals.skipped);
+      if (!files.isEmpty())
+            TEST(renderThreads(sf, files.last(), 4));
+      TEST(deferredNote(sf));
+      TEST(exportRate(sf));
+      return passed;
+      }
+
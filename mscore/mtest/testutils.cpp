@@ -59,4 +59,23 @@ Element* writeReadElement(Element* element)
       return element;
       }
 
+//---------------------------------------------------------
+//   testSoundFont
+//    MTEST_SOUNDFONT or a general midi font found on the
+//    system; empty if there is none
+//---------------------------------------------------------
+
+QString testSoundFont()
+      {
+      QStringList sl;
+      sl << QString::fromLocal8Bit(qgetenv("MTEST_SOUNDFONT"))
+         << "../../mscore/share/sound/TimGM6mb.sf2"
+         << "/usr/share/sounds/sf2/FluidR3_GM.sf2"
+         << "/usr/share/sounds/sf2/TimGM6mb.sf2";
+      foreach(const QString& s, sl) {
+            if (!s.isEmpty() && QFileInfo(s).exists())
+                  return s;
+            }
+      return QString();
+      }
 
@@ -17,6 +17,7 @@
 class Element;
 
 extern Element* writeReadElement(Element* element);
+extern QString testSoundFont();
 
 #endif
 